@@ -0,0 +1,147 @@
+//==============================================================================
+// Copyright (c) 2018 Eric Seguin, all rights reserved.
+//==============================================================================
+
+#pragma once
+
+#include "external/wiringPi.h"
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace beewatch::external
+{
+
+    //==============================================================================
+    /**
+     * @class GpioChip
+     *
+     * Implements the wiringPi library interface on the Linux GPIO character
+     * device (v2 uAPI), e.g. /dev/gpiochip0.
+     *
+     * Each pin is held through a line request, whose values are read & written
+     * with a single ioctl. Edges are timestamped by the kernel & queued on the
+     * request; a single thread reads them in batches for all pins and calls
+     * their ISRs.
+     *
+     * NB: The character device only drives inputs & outputs, not PWM or clocks.
+     */
+    class GpioChip : public IWiringPi
+    {
+    public:
+        //==============================================================================
+        /**
+         * @brief Open GPIO chip & start reading its edge events
+         *
+         * @param [in] path     Path to GPIO chip character device
+         *
+         * @throws std::runtime_error if the chip cannot be opened, or if built without the v2 uAPI
+         */
+        explicit GpioChip(const std::string& path = DEFAULT_PATH);
+
+        /**
+         * @brief Stop reading edge events & release all lines
+         */
+        virtual ~GpioChip();
+
+        /**
+         * @brief Get interface to default GPIO chip
+         *
+         * @throws std::runtime_error if the chip cannot be opened
+         */
+        static std::shared_ptr<IWiringPi> getInstance();
+
+        //==============================================================================
+        virtual int digitalRead(int pin) override;
+        virtual void digitalWrite(int pin, int value) override;
+
+        virtual void pwmWrite(int pin, int value) override;
+
+        //==============================================================================
+        virtual void pinMode(int pin, int mode) override;
+        virtual void pullUpDnControl(int pin, int pud) override;
+
+        virtual void pwmSetMode(int mode) override;
+        virtual void pwmSetRange(unsigned int range) override;
+        virtual void pwmSetClock(int divisor) override;
+
+        //==============================================================================
+        virtual int setISR(int pin, int edgeType, void(*function)(void)) override;
+        virtual int setTimestampedISR(int pin, int edgeType, TimestampedISR function) override;
+
+        //==============================================================================
+        static constexpr auto DEFAULT_PATH = "/dev/gpiochip0";
+
+        /// Edges queued by the kernel per line, enough for a whole DHT transfer
+        static constexpr uint32_t EVENT_BUFFER_SIZE = 256;
+
+        /// Maximum number of edges read at once
+        static constexpr size_t EVENT_BATCH_SIZE = 32;
+
+
+    private:
+        //==============================================================================
+        /**
+         * @struct Line
+         *
+         * Requested configuration of a pin, re-applied whole on every change
+         */
+        struct Line
+        {
+            /// Line request, or -1 until the line is first configured
+            int fd = -1;
+
+            int mode;
+            int value;
+            int edgeType;
+
+            /// Resistor mode, or -1 to leave it as is
+            int pud = -1;
+
+            void (*isr)(void) = nullptr;
+            TimestampedISR timestampedISR = nullptr;
+        };
+
+        /// Get pin's line, creating it with default configuration if needed (NB: lines mutex must be held)
+        Line& getLine(int pin);
+
+        /// Request line or update its configuration (NB: lines mutex must be held)
+        bool configure(int pin, Line& line);
+
+        /// Set pin's ISRs & edge detection
+        int setISRs(int pin, int edgeType, void (*isr)(void), TimestampedISR timestampedISR);
+
+        /// Log that an operation isn't supported (once per process)
+        static void warnUnsupported();
+
+        //==============================================================================
+        /**
+         * @brief Event thread: reads edges from all lines & calls their ISRs
+         */
+        void eventLoop();
+
+        /// Make event thread update the lines it polls
+        void wakeEventLoop();
+
+        //==============================================================================
+        const std::string _path;
+
+        int _chipFd;
+        uint32_t _numLines;
+
+        /// Pipe used to wake event thread
+        int _wakeFds[2];
+
+        std::map<int, Line> _lines;
+        std::mutex _linesMutex;
+
+        std::atomic<bool> _stop;
+        std::thread _eventThread;
+    };
+
+} // namespace beewatch::external
@@ -0,0 +1,108 @@
+//==============================================================================
+// Copyright (c) 2018 Eric Seguin, all rights reserved.
+//==============================================================================
+
+#pragma once
+
+#include "external/wiringPi.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace beewatch::external
+{
+
+    //==============================================================================
+    /**
+     * @class GpioMem
+     *
+     * Implements the wiringPi library interface by accessing the BCM283x GPIO
+     * registers directly, mapped from /dev/gpiomem.
+     *
+     * Meant for bit-banged sensors: a toggle or a read is a single register
+     * access, and pins of the first bank (GPIO 0-31) can be driven together
+     * with masks. Any file of at least one page can stand in for the registers,
+     * e.g. to test off-target.
+     *
+     * NB: Edge detection, PWM & clock outputs are unavailable, and pulls use
+     *     the BCM2835-7 sequence (not the BCM2711's registers).
+     */
+    class GpioMem : public IWiringPi
+    {
+    public:
+        //==============================================================================
+        /**
+         * @brief Map GPIO registers
+         *
+         * @param [in] path     Path to GPIO register device, or to a fake register file
+         *
+         * @throws std::runtime_error if the registers cannot be mapped
+         */
+        explicit GpioMem(const std::string& path = DEFAULT_PATH);
+
+        /**
+         * @brief Unmap GPIO registers
+         */
+        virtual ~GpioMem();
+
+        /**
+         * @brief Get interface to the GPIO registers
+         *
+         * @throws std::runtime_error if the registers cannot be mapped
+         */
+        static std::shared_ptr<IWiringPi> getInstance();
+
+        //==============================================================================
+        /// Drive HI the output pins set in mask
+        void set(uint32_t mask) { _registers[GPSET0] = mask; }
+
+        /// Drive LO the output pins set in mask
+        void clear(uint32_t mask) { _registers[GPCLR0] = mask; }
+
+        /// Get levels of all pins, one bit per pin
+        uint32_t level() const { return _registers[GPLEV0]; }
+
+        //==============================================================================
+        virtual int digitalRead(int pin) override;
+        virtual void digitalWrite(int pin, int value) override;
+
+        virtual void pwmWrite(int pin, int value) override;
+
+        //==============================================================================
+        virtual void pinMode(int pin, int mode) override;
+        virtual void pullUpDnControl(int pin, int pud) override;
+
+        virtual void pwmSetMode(int mode) override;
+        virtual void pwmSetRange(unsigned int range) override;
+        virtual void pwmSetClock(int divisor) override;
+
+        //==============================================================================
+        virtual int setISR(int pin, int edgeType, void(*function)(void)) override;
+
+        //==============================================================================
+        static constexpr auto DEFAULT_PATH = "/dev/gpiomem";
+
+        /// Size of mapped register block
+        static constexpr size_t BLOCK_SIZE = 4096;
+
+        /// Register offsets, in 32-bit words
+        static constexpr size_t GPFSEL0 = 0;
+        static constexpr size_t GPSET0 = 7;
+        static constexpr size_t GPCLR0 = 10;
+        static constexpr size_t GPLEV0 = 13;
+        static constexpr size_t GPPUD = 37;
+        static constexpr size_t GPPUDCLK0 = 38;
+
+
+    private:
+        //==============================================================================
+        /// Log that an operation isn't supported (once per process)
+        static void warnUnsupported();
+
+        //==============================================================================
+        volatile uint32_t* _registers;
+    };
+
+} // namespace beewatch::external
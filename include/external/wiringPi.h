@@ -78,6 +78,18 @@ namespace beewatch::external
 
         //==============================================================================
         virtual int setISR(int pin, int edgeType, void(*function)(void)) = 0;
+
+        /// ISR receiving the pin, its value following the edge & when the edge occurred (see g_timeRaw)
+        using TimestampedISR = void (*)(int pin, int value, double timeMs);
+
+        /**
+         * @brief Set ISR receiving edges timestamped as they occurred, rather than when the ISR runs
+         *
+         * Replaces any ISR set with setISR() on the same pin, and vice versa.
+         *
+         * @returns 0 if successful, -1 if edges can't be timestamped (the default)
+         */
+        virtual int setTimestampedISR(int pin, int edgeType, TimestampedISR function);
     };
 
     //==============================================================================
@@ -8,7 +8,12 @@
 #include "hw/hx711.h"
 #include "io/gpio.h"
 #include "http/server.h"
+#include "util/broadcaster.h"
+#include "util/climate_cache.h"
 #include "util/db.h"
+#include "util/embedded_db.h"
+#include "util/ingest_queue.h"
+#include "util/rollup.h"
 
 #include "util/patterns.hpp"
 
@@ -55,13 +60,60 @@ namespace beewatch
         /**
          * @brief Get climate data
          *
+         * Recent samples are read from memory, older ones from the DB.
+         *
          * @param [in] since    Unix timestamp of earliest sample to get
          *
          * @returns Climate data ordered by sample time
          */
-        virtual std::map<int64_t, ClimateData<double>> getClimateSamples(std::string sensorID,
+        virtual ClimateSeries getClimateSamples(std::string sensorID, int64_t since = 0) const override;
+
+        virtual std::map<std::string, ClimateSeries> getClimateSamples(const std::vector<std::string>& sensorIDs,
+                                                                       int64_t since = 0,
+                                                                       int64_t until = IDB::MAX_TIMESTAMP,
+                                                                       size_t limit = 0) const override;
+
+        /**
+         * @brief Stream climate data in batches, without loading the whole history
+         *
+         * @param [in] since    Unix timestamp of earliest sample to get
+         * @param [in] visit    Visitor called for each batch of samples, returning false to stop
+         */
+        virtual void visitClimateSamples(std::string sensorID, int64_t since,
+                                         const ClimateVisitor& visit) const override;
+
+        /**
+         * @brief Get climate data downsampled to a given resolution
+         *
+         * Aggregates are read from the coarsest rollup tier whose period doesn't exceed
+         * the requested resolution, or built from raw samples if no tier is fine enough.
+         *
+         * @param [in] resolution   Requested resolution, in seconds
+         * @param [in] since        Unix timestamp of earliest sample to get
+         *
+         * @returns Climate aggregates ordered by start time
+         */
+        virtual std::map<int64_t, ClimateAggregate> getClimateAggregates(std::string sensorID,
+                                                                         int64_t resolution,
                                                                          int64_t since = 0) const override;
 
+        /**
+         * @brief Get high-water mark of a sensor's climate data
+         *
+         * Tracked in memory as samples are written, so it can be used to detect
+         * changes without querying the DB.
+         *
+         * @returns Timestamp of latest sample & number of samples written
+         */
+        virtual ClimateWatermark getClimateWatermark(std::string sensorID) const override;
+
+        /**
+         * @brief Subscribe to live climate samples, as they are read from the sensors
+         *
+         * @returns Subscription handle; releasing it unsubscribes
+         */
+        virtual ClimateBroadcaster::Subscription::Ptr subscribeClimateSamples() override;
+
         /**
          * @brief Get array of sensor IDs
          *
@@ -102,17 +154,39 @@ namespace beewatch
         // Attributes
         std::string _name;
 
-        //==============================================================================
-        // Web server
-        http::Server::Ptr _apiServer;
-
         //==============================================================================
         // Database
-        DB::Ptr _db;
+        IDB::Ptr _db;
+
+        /// Batches climate samples into the DB off the control loop's thread
+        IngestQueue::Ptr _ingestQueue;
+
+        /// Hourly & daily aggregates, updated as samples are written to the DB & persisted once closed
+        ClimateRollup::Ptr _rollup;
+
+        /// Last week or so of samples, answering most queries without the DB
+        ClimateCache::Ptr _recentSamples;
+
+        /// Climate data high-water marks by sensor, updated as samples are written to the DB
+        mutable std::shared_mutex _watermarkMutex;
+        std::map<std::string, ClimateWatermark> _watermarks;
+        uint64_t _climateGeneration;
+
+        void updateWatermarks(const std::vector<ClimateSample>& samples);
+
+        /// Write closed buckets of the rollup tiers to the DB, so they needn't be recomputed on startup
+        void persistRollup();
+
+        /// Publishes live samples to streaming clients
+        ClimateBroadcaster::Ptr _broadcaster;
 
         //==============================================================================
         // Sensors
         std::map<std::string, hw::DHTxx::Ptr> _climateSensors;
+
+        //==============================================================================
+        // Web server, declared last so it stops serving before what requests reach into goes away
+        http::Server::Ptr _apiServer;
     };
 
     #define g_manager   Manager::get()
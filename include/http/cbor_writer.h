@@ -0,0 +1,118 @@
+//==============================================================================
+// Copyright (c) 2018 Eric Seguin, all rights reserved.
+//==============================================================================
+
+#pragma once
+
+#include "util/data_types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace beewatch::http
+{
+
+    //==============================================================================
+    /**
+     * @class CborWriter
+     *
+     * Streaming CBOR (RFC 8949) serialiser writing directly into fixed-size chunks.
+     *
+     * Numeric columns are written as RFC 8746 typed arrays: a tag followed by a byte
+     * string holding the raw little-endian values, which clients can view in place
+     * (e.g. as a JavaScript Float32Array) instead of parsing each number.
+     */
+    class CborWriter
+    {
+    public:
+        //==============================================================================
+        /// Receives serialised chunks (data is only valid for the duration of the call)
+        using Sink = std::function<void(const char * data, size_t size)>;
+
+        /**
+         * @brief Construct writer around a sink
+         *
+         * @param [in] sink         Function receiving serialised chunks
+         * @param [in] chunkSize    Size of chunks passed to the sink
+         */
+        CborWriter(Sink sink, size_t chunkSize = DEFAULT_CHUNK_SIZE);
+
+        //==============================================================================
+        /// Begin map of a given number of key/value pairs
+        CborWriter& beginMap(size_t size);
+
+        /// Begin map of unknown size, to be closed with end()
+        CborWriter& beginMap();
+
+        /// Close container of unknown size
+        CborWriter& end();
+
+        /// Write text string (keys are written as values too)
+        CborWriter& value(const std::string& string);
+
+        /// Write integer, using the shortest encoding
+        CborWriter& value(int64_t number);
+
+        /// Write double-precision float
+        CborWriter& value(double number);
+
+        //==============================================================================
+        /// Write signed 64-bit little-endian typed array (tag 79)
+        CborWriter& int64Array(const std::vector<int64_t>& values);
+
+        /// Write unsigned 32-bit little-endian typed array (tag 70)
+        CborWriter& uint32Array(const std::vector<uint32_t>& values);
+
+        /// Write values as a 32-bit float little-endian typed array (tag 85)
+        CborWriter& float32Array(const std::vector<double>& values);
+
+        //==============================================================================
+        /// Pass buffered output to sink, to be called once the document is complete
+        void flush();
+
+        //==============================================================================
+        static constexpr size_t DEFAULT_CHUNK_SIZE = 16 * 1024;
+
+        /// RFC 8746 typed array tags
+        static constexpr uint64_t TAG_INT64_LE = 79;
+        static constexpr uint64_t TAG_UINT32_LE = 70;
+        static constexpr uint64_t TAG_FLOAT32_LE = 85;
+
+
+    private:
+        //==============================================================================
+        /// Write initial byte & argument of a data item
+        void writeHead(uint8_t majorType, uint64_t argument);
+
+        /// Write unsigned integer as little-endian bytes
+        void writeLittleEndian(uint64_t bits, size_t numBytes);
+
+        void write(const char * data, size_t size);
+        void put(uint8_t byte);
+
+        //==============================================================================
+        Sink _sink;
+
+        std::vector<char> _buffer;
+        size_t _size;
+    };
+
+    //==============================================================================
+    /**
+     * @brief Write climate samples as a map of typed arrays:
+     *
+     *     { "timestamps": int64[], "temperature": float32[], "humidity": float32[] }
+     */
+    void writeClimateSeries(CborWriter& writer, const ClimateSeries& series);
+
+    /**
+     * @brief Write climate aggregates as a map of typed arrays holding the mean values,
+     *        along with "min" & "max" maps & a "count" array
+     */
+    void writeClimateAggregates(CborWriter& writer, const std::map<int64_t, ClimateAggregate>& aggregates);
+
+} // namespace beewatch::http
@@ -0,0 +1,73 @@
+//==============================================================================
+// Copyright (c) 2018 Eric Seguin, all rights reserved.
+//==============================================================================
+
+#pragma once
+
+#include "http/negotiation.h"
+#include "util/patterns.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace beewatch::http
+{
+
+    //==============================================================================
+    /**
+     * @class Compressor
+     *
+     * Streaming zlib compressor producing gzip (RFC 1952) or deflate (RFC 1950)
+     * content, handing compressed output to a sink in fixed-size chunks.
+     */
+    class Compressor : public unique_ownership_t<Compressor>
+    {
+    public:
+        //==============================================================================
+        /// Receives compressed chunks (data is only valid for the duration of the call)
+        using Sink = std::function<void(const char * data, size_t size)>;
+
+        /**
+         * @brief Construct compressor around a sink
+         *
+         * @param [in] encoding     Gzip or deflate
+         * @param [in] level        Compression level, from 1 (fastest) to 9 (smallest)
+         * @param [in] sink         Function receiving compressed chunks
+         * @param [in] chunkSize    Size of chunks passed to the sink
+         *
+         * @throws std::invalid_argument if encoding, level or sink is invalid
+         * @throws std::runtime_error if zlib cannot be initialised
+         */
+        Compressor(ContentEncoding encoding, int level, Sink sink, size_t chunkSize = DEFAULT_CHUNK_SIZE);
+
+        ~Compressor();
+
+        //==============================================================================
+        /// Compress data, passing output to the sink as chunks fill up
+        void write(const char * data, size_t size);
+
+        /// Compress remaining input & pass all output to the sink, to be called once
+        void finish();
+
+        //==============================================================================
+        static constexpr size_t DEFAULT_CHUNK_SIZE = 16 * 1024;
+
+
+    private:
+        //==============================================================================
+        void deflate(const char * data, size_t size, int flush);
+
+        //==============================================================================
+        struct Stream;
+        std::unique_ptr<Stream> _stream;
+
+        Sink _sink;
+        std::vector<char> _buffer;
+
+        bool _finished;
+    };
+
+} // namespace beewatch::http
@@ -0,0 +1,106 @@
+//==============================================================================
+// Copyright (c) 2018 Eric Seguin, all rights reserved.
+//==============================================================================
+
+#pragma once
+
+#include "util/data_types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace beewatch::http
+{
+
+    //==============================================================================
+    /**
+     * @class JsonWriter
+     *
+     * Streaming JSON serialiser writing directly into fixed-size chunks.
+     *
+     * Unlike a JSON DOM, no intermediate value tree is built: values are formatted
+     * into a single reusable buffer, which is handed to the sink whenever it fills
+     * up. Commas & colons are inserted automatically.
+     */
+    class JsonWriter
+    {
+    public:
+        //==============================================================================
+        /// Receives serialised chunks (data is only valid for the duration of the call)
+        using Sink = std::function<void(const char * data, size_t size)>;
+
+        /**
+         * @brief Construct writer around a sink
+         *
+         * @param [in] sink         Function receiving serialised chunks
+         * @param [in] chunkSize    Size of chunks passed to the sink
+         */
+        JsonWriter(Sink sink, size_t chunkSize = DEFAULT_CHUNK_SIZE);
+
+        //==============================================================================
+        JsonWriter& beginObject();
+        JsonWriter& endObject();
+
+        JsonWriter& beginArray();
+        JsonWriter& endArray();
+
+        /// Write object key; must be followed by a value
+        JsonWriter& key(const std::string& name);
+
+        /// Write number (non-finite values are written as null)
+        JsonWriter& value(double number);
+        JsonWriter& value(int64_t number);
+        JsonWriter& value(uint32_t number) { return value((int64_t)number); }
+
+        /// Write escaped string
+        JsonWriter& value(const std::string& string);
+
+        /// Write null
+        JsonWriter& null();
+
+        //==============================================================================
+        /// Pass buffered output to sink, to be called once the document is complete
+        void flush();
+
+        //==============================================================================
+        static constexpr size_t DEFAULT_CHUNK_SIZE = 16 * 1024;
+
+
+    private:
+        //==============================================================================
+        /// Insert separator before a new value, if needed
+        void separate();
+
+        void write(const char * data, size_t size);
+        void put(char c);
+
+        //==============================================================================
+        Sink _sink;
+
+        std::vector<char> _buffer;
+        size_t _size;
+
+        /// Whether the innermost container is still empty, for each nesting level
+        std::vector<bool> _isEmpty;
+        bool _hasKey;
+    };
+
+    //==============================================================================
+    /**
+     * @brief Write climate samples as the API's JSON format:
+     *
+     *     { "timestamps": [ t0, ... ], "samples": [ { "temperature": x, "humidity": y }, ... ] }
+     */
+    void writeClimateSeries(JsonWriter& writer, const ClimateSeries& series);
+
+    /**
+     * @brief Write climate aggregates in the API's JSON format, with each sample holding
+     *        the mean values along with "min", "max" & "count" fields
+     */
+    void writeClimateAggregates(JsonWriter& writer, const std::map<int64_t, ClimateAggregate>& aggregates);
+
+} // namespace beewatch::http
@@ -0,0 +1,84 @@
+//==============================================================================
+// Copyright (c) 2018 Eric Seguin, all rights reserved.
+//==============================================================================
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+namespace beewatch::http
+{
+
+    //==============================================================================
+    /**
+     * @brief Parse a content negotiation header, e.g. "gzip;q=0.8, deflate"
+     *
+     * @param [in] header   Value of an Accept or Accept-Encoding header
+     *
+     * @returns Quality of each listed (lowercase) token, defaulting to 1
+     */
+    std::map<std::string, double> parseQualityValues(const std::string& header);
+
+    //==============================================================================
+    enum class ContentEncoding
+    {
+        Identity,
+        Gzip,
+        Deflate
+    };
+
+    /**
+     * @brief Pick the preferred encoding accepted by a client
+     *
+     * Gzip is preferred over deflate when both are equally acceptable, and encodings
+     * with a quality of 0 are never picked.
+     *
+     * @param [in] acceptEncoding   Value of the request's Accept-Encoding header
+     *
+     * @returns Encoding to use, or Identity if no supported encoding is accepted
+     */
+    ContentEncoding negotiateEncoding(const std::string& acceptEncoding);
+
+    /// Get Content-Encoding token of an encoding, e.g. "gzip"
+    std::string toString(ContentEncoding encoding);
+
+    //==============================================================================
+    enum class MediaType
+    {
+        Json,
+        Cbor
+    };
+
+    /**
+     * @brief Pick the response format preferred by a client
+     *
+     * CBOR is only picked if explicitly listed, and at least as acceptable as JSON.
+     *
+     * @param [in] accept   Value of the request's Accept header
+     *
+     * @returns Format to use, JSON by default
+     */
+    MediaType negotiateMediaType(const std::string& accept);
+
+    /// Get MIME type of a format, e.g. "application/json"
+    std::string toString(MediaType mediaType);
+
+    //==============================================================================
+    /**
+     * @brief Check whether an If-None-Match header lists a given entity tag
+     *
+     * Tags are compared weakly, i.e. ignoring "W/" prefixes, and "*" matches any tag.
+     *
+     * @param [in] ifNoneMatch  Value of the request's If-None-Match header
+     * @param [in] etag         Quoted entity tag of the current representation
+     *
+     * @returns True if the client already holds the representation
+     */
+    bool matchesETag(const std::string& ifNoneMatch, const std::string& etag);
+
+    /// Format Unix timestamp as an HTTP date, e.g. "Sun, 06 Nov 1994 08:49:37 GMT"
+    std::string formatHttpDate(int64_t timestamp);
+
+} // namespace beewatch::http
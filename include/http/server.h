@@ -4,12 +4,16 @@
 
 #pragma once
 
+#include "util/broadcaster.h"
 #include "util/data_types.hpp"
 #include "util/patterns.hpp"
+#include "util/worker_pool.h"
 
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <cstdint>
+#include <limits>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -34,9 +38,24 @@ namespace beewatch::http
         virtual void setName(std::string name) = 0;
         
         //==============================================================================
-        virtual std::map<int64_t, ClimateData<double>> getClimateSamples(std::string sensorID,
+        virtual ClimateSeries getClimateSamples(std::string sensorID, int64_t since = 0) const = 0;
+
+        virtual std::map<std::string, ClimateSeries> getClimateSamples(const std::vector<std::string>& sensorIDs,
+                                                                       int64_t since = 0,
+                                                                       int64_t until = std::numeric_limits<int64_t>::max(),
+                                                                       size_t limit = 0) const = 0;
+
+        virtual void visitClimateSamples(std::string sensorID, int64_t since,
+                                         const ClimateVisitor& visit) const = 0;
+
+        virtual std::map<int64_t, ClimateAggregate> getClimateAggregates(std::string sensorID,
+                                                                         int64_t resolution,
                                                                          int64_t since = 0) const = 0;
 
+        virtual ClimateWatermark getClimateWatermark(std::string sensorID) const = 0;
+
+        virtual ClimateBroadcaster::Subscription::Ptr subscribeClimateSamples() = 0;
+
         virtual std::vector<std::string> getClimateSensorIDs() const = 0;
         
         virtual void clearClimateData() = 0;
@@ -53,10 +72,16 @@ namespace beewatch::http
         /**
          * @brief Construct interface around a given port
          *
-         * @param [in] manager  Manager to push/pull data to/from
-         * @param [in] port     Port to listen on
+         * @param [in] manager          Manager to push/pull data to/from
+         * @param [in] port             Port to listen on
+         * @param [in] compressionLevel gzip/deflate level for responses (1-9), or 0 to disable
+         * @param [in] numWorkers       Number of threads answering requests which hit the DB
+         *
+         * @throws std::invalid_argument if compression level is out of range or there are no workers
          */
-        Server(IManager& manager, uint16_t port = DEFAULT_PORT);
+        Server(IManager& manager, uint16_t port = DEFAULT_PORT,
+               int compressionLevel = DEFAULT_COMPRESSION_LEVEL,
+               size_t numWorkers = DEFAULT_NUM_WORKERS);
 
         /**
          * @brief Default destructor
@@ -77,10 +102,30 @@ namespace beewatch::http
         //==============================================================================
         static constexpr uint16_t DEFAULT_PORT = 8080;
 
+        static constexpr int DEFAULT_COMPRESSION_LEVEL = 6;
+
+        /// Responses smaller than this are sent uncompressed, as compression would barely pay off
+        static constexpr size_t COMPRESSION_THRESHOLD = 1024;
+
+        /// Unread output beyond which a streamed response waits for the client (a couple of chunks)
+        static constexpr size_t MAX_STREAM_BACKLOG = 32 * 1024;
+
+        /// Maximum number of concurrent event streams (each one holds a listener thread)
+        static constexpr size_t MAX_STREAMS = 8;
+
+        static constexpr size_t DEFAULT_NUM_WORKERS = 4;
+
+        /// Maximum number of requests waiting for a worker
+        static constexpr size_t QUEUE_CAPACITY = 32;
+
+        /// Requests waiting longer than this for a worker are answered with 503 Service Unavailable
+        static constexpr std::chrono::milliseconds REQUEST_TIMEOUT = std::chrono::seconds(10);
+
 
     private:
         //==============================================================================
         uint16_t _port;
+        int _compressionLevel;
 
         IManager& _manager;
         
@@ -89,6 +134,43 @@ namespace beewatch::http
 
         void listen();
 
+        /// Whether the listener is open; event streams end once it is cleared
+        std::atomic<bool> _isListening;
+
+        std::atomic<size_t> _numStreams;
+
+        //==============================================================================
+        /// Runs requests which hit the DB or read a body, off the listener's threads
+        WorkerPool::Ptr _workers;
+
+        /**
+         * @struct RouteStats
+         *
+         * Concurrency limit & latency of requests to a given route (e.g. "GET data/climate")
+         */
+        struct RouteStats
+        {
+            /// Maximum number of requests queued or running at once, 0 if answered inline
+            size_t limit = 0;
+            size_t inFlight = 0;
+
+            uint64_t served = 0;
+            uint64_t rejected = 0;
+
+            double totalMs = 0.0;
+            double maxMs = 0.0;
+        };
+
+        /// Tracked routes, fixed on construction (only their statistics change afterwards)
+        std::map<std::string, RouteStats> _routes;
+        mutable std::mutex _routeMutex;
+
+        /// Count request against its route's limit, returning false if the route is saturated
+        bool admitRequest(RouteStats& route);
+
+        /// Record end of an admitted request, served or not
+        void finishRequest(RouteStats& route, std::chrono::steady_clock::time_point startTime, bool served);
+
         //==============================================================================
         std::mutex                   _mutex;
         std::condition_variable      _stopCondition;
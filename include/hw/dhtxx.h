@@ -10,8 +10,11 @@
 #include "util/patterns.hpp"
 #include "util/data_types.hpp"
 
+#include <array>
 #include <bitset>
+#include <cstdint>
 #include <memory>
+#include <vector>
 
 namespace beewatch::hw
 {
@@ -37,6 +40,20 @@ namespace beewatch::hw
 
         using Data = ClimateData<double>;
 
+        /**
+         * @enum ReadMode
+         *
+         * How pulse widths are measured during a transfer
+         */
+        enum class ReadMode
+        {
+            /// Poll the GPIO in a busy loop, timing each pulse (occupies a core during transfers)
+            Polling,
+
+            /// Record timestamped edges from the GPIO's ISR & decode them afterwards (sleeps during transfers)
+            EdgeCapture
+        };
+
         //==============================================================================
         /**
          * @brief Sets up a DHT communication on a given GPIO
@@ -45,8 +62,9 @@ namespace beewatch::hw
          *
          * @param [in] dhtType  Type of DHT sensor
          * @param [in] gpio     GPIO to use to interface with DHT sensor
+         * @param [in] readMode How transfers are timed
          */
-        DHTxx(Type dhtType, io::GPIO::Ptr&& gpio);
+        DHTxx(Type dhtType, io::GPIO::Ptr&& gpio, ReadMode readMode = ReadMode::Polling);
         
         /**
          * @brief Close DHT communication, releasing owned GPIO
@@ -66,23 +84,55 @@ namespace beewatch::hw
          */
         virtual Data read() override;
 
+        /// Set how transfers are timed (NB: not to be called while reading)
+        void setReadMode(ReadMode readMode) { _readMode = readMode; }
+
+        /// Get how transfers are timed
+        ReadMode getReadMode() const { return _readMode; }
+
+        //==============================================================================
+        static constexpr int READ_BITS = 40;
+        static constexpr int READ_BYTES = READ_BITS / 8;
+
+        /**
+         * @brief Decode a transfer from the edges recorded on the data line
+         *
+         * The data bits are the last 40 HI pulses: earlier edges belong to the
+         * start signal & the sensor's response. A pulse, or the gap before it,
+         * lasting longer than a bit means edges were missed.
+         *
+         * @param [in] edges    Edges recorded during the transfer, in time order
+         *
+         * @returns Bytes received, or all 0xFF if the transfer is incomplete
+         */
+        static std::array<uint8_t, READ_BYTES> decodeEdges(const std::vector<io::GPIO::Edge>& edges);
+
 
     private:
         //==============================================================================
         Type _type;
         io::GPIO::Ptr _gpio;
 
-        //==============================================================================
-        static constexpr int READ_BITS = 40;
-        static constexpr int READ_BYTES = READ_BITS / 8;
+        ReadMode _readMode;
 
+        //==============================================================================
         static constexpr double READ_TIMEOUT_MS = 0.1;
 
+        /// Mid-point between HI pulse widths of a 0 (26-28us) and a 1 (70us)
+        static constexpr double BIT_THRESHOLD_MS = 48.5e-3;
+
+        /// Start signal & response (~6 edges) followed by 40 bits (2 edges each), with margin
+        static constexpr size_t EDGE_CAPTURE_CAPACITY = 128;
+
+        /// Longest transfer is ~5ms: response (160us) + 40 bits (120us each at most)
+        static constexpr double TRANSFER_TIME_MS = 10.0;
+
         void reset();
 
         Data readSample();
 
         std::array<uint8_t, READ_BYTES> readRaw();
+        std::array<uint8_t, READ_BYTES> readEdges();
         static bool validateData(const std::array<uint8_t, READ_BYTES>& data);
 
         static inline uint16_t buildU16(uint8_t high8, uint8_t low8)
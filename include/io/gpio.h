@@ -7,13 +7,16 @@
 #include "io.h"
 
 #include "util/patterns.hpp"
+#include "external/gpioMem.h"
 #include "external/wiringPi.h"
 
 #include <array>
 #include <atomic>
 #include <bitset>
-#include <map>
+#include <cstddef>
+#include <cstdint>
 #include <mutex>
+#include <utility>
 #include <vector>
 
 
@@ -189,6 +192,50 @@ namespace beewatch::io
          */
         static void nop() {}
 
+        //==============================================================================
+        /**
+         * @struct Edge
+         *
+         * State change detected on a GPIO
+         */
+        struct Edge
+        {
+            /// Time at which the change was detected (see g_timeRaw)
+            double timeMs;
+
+            /// State following the change
+            LogicalState state;
+        };
+
+        /**
+         * @brief Start recording timestamped edges
+         *
+         * Edges are written by the ISR into a buffer preallocated here, so
+         * recording them doesn't allocate. Edges beyond the buffer's capacity
+         * are dropped. Replaces any edge detection callback.
+         *
+         * Edges are timestamped as they occurred if the wiringPi implementation
+         * supports it, otherwise when the ISR runs.
+         *
+         * The capture ISR is only set on the first capture of a given edge type, as
+         * wiringPi starts a new thread every time an ISR is set.
+         *
+         * @param [in] type     Type of state change to record
+         * @param [in] capacity Maximum number of edges recorded
+         *
+         * @throws std::invalid_argument if type is None or capacity is zero
+         */
+        virtual void startEdgeCapture(EdgeType type, size_t capacity);
+
+        /**
+         * @brief Stop recording edges & disable edge detection
+         *
+         * The capture ISR is left set, but ignores edges until capture starts again.
+         *
+         * @returns Edges recorded since capture was started, in time order
+         */
+        virtual std::vector<Edge> stopEdgeCapture();
+
 
         //==============================================================================
         /**
@@ -219,18 +266,74 @@ namespace beewatch::io
 
     private:
         //==============================================================================
-        std::map<LogicalState, int>   _mapLogicalStateToWiringPi;
-        std::map<GPIO::Mode, int>     _mapModeToWiringPi;
-        std::map<GPIO::Resistor, int> _mapResistorToWiringPi;
-        std::map<GPIO::EdgeType, int> _mapEdgeTypeToWiringPi;
+        /// wiringPi values of enums, indexed by enum value (filled from the wiringPi implementation's constants)
+        std::array<int, (size_t)LogicalState::Invalid + 1> _logicalStateToWiringPi;
+        std::array<int, (size_t)Mode::CLK + 1>             _modeToWiringPi;
+        std::array<int, (size_t)Resistor::PullDown + 1>    _resistorToWiringPi;
+        std::array<int, (size_t)EdgeType::Both + 1>        _edgeTypeToWiringPi;
+
+        /// Look up wiringPi value of an enum
+        template <typename Enum, size_t N>
+        static int toWiringPi(const std::array<int, N>& table, Enum value)
+        {
+            return table[static_cast<size_t>(value)];
+        }
 
         //==============================================================================
         std::shared_ptr<external::IWiringPi> _wiringPi;
 
+        /// Registers of a register-mapped wiringPi implementation, read & written directly (or nullptr)
+        external::GpioMem* _registers;
+
+        /// Bit of this GPIO in register masks
+        uint32_t _mask;
+
         //==============================================================================
         static bool _claimedGPIOList[NUM_GPIO];
         static std::mutex _claimMutex[NUM_GPIO];
 
+        /// Serialises configuration changes: pins share their mode & pull registers (read-modify-write)
+        static std::mutex _configMutex;
+
+        //==============================================================================
+        /**
+         * @struct EdgeBuffer
+         *
+         * Edges recorded by a GPIO's ISR. Only the ISR appends to it while capturing.
+         */
+        struct EdgeBuffer
+        {
+            std::vector<Edge> edges;
+
+            std::atomic<size_t> size{ 0 };
+            std::atomic<bool> isCapturing{ false };
+
+            EdgeType type = EdgeType::None;
+            external::IWiringPi* wiringPi = nullptr;
+
+            /// Edge type the capture ISR is set for, or None if another ISR is set
+            EdgeType isrType = EdgeType::None;
+        };
+
+        /// Edge buffers, by GPIO ID (ISRs are called without arguments)
+        static EdgeBuffer _edgeBuffers[NUM_GPIO];
+
+        /// Append edge to buffer, if capturing & not full (NB: only called by the ISR)
+        static void recordEdge(EdgeBuffer& buffer, double timeMs, LogicalState state);
+
+        /// ISR recording an edge on GPIO# into its buffer, where # = ID
+        template <size_t ID>
+        static void captureEdge();
+
+        /// ISR recording an edge timestamped by the wiringPi implementation
+        static void captureTimestampedEdge(int pin, int value, double timeMs);
+
+        template <size_t... IDs>
+        static constexpr std::array<void (*)(void), NUM_GPIO> makeCaptureISRs(std::index_sequence<IDs...>);
+
+        /// Edge capture ISRs, by GPIO ID
+        static const std::array<void (*)(void), NUM_GPIO> _captureISRs;
+
         //==============================================================================
         int _id;
 
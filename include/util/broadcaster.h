@@ -0,0 +1,135 @@
+//==============================================================================
+// Copyright (c) 2018 Eric Seguin, all rights reserved.
+//==============================================================================
+
+#pragma once
+
+#include "util/data_types.hpp"
+#include "util/patterns.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace beewatch
+{
+
+    //==============================================================================
+    /**
+     * @class ClimateBroadcaster
+     *
+     * Fans out live climate samples to any number of subscribers.
+     *
+     * The subscriber list is copy-on-write: publishing works on an immutable snapshot,
+     * so it never waits on clients subscribing or leaving. Each subscriber has its own
+     * bounded queue: when a slow consumer falls behind, its oldest samples are dropped,
+     * so neither the publisher nor other subscribers are held back.
+     */
+    class ClimateBroadcaster : public unique_ownership_t<ClimateBroadcaster>
+    {
+    public:
+        //==============================================================================
+        /**
+         * @class Subscription
+         *
+         * Bounded drop-oldest queue of samples for a single subscriber. Subscribers
+         * leave by releasing their handle.
+         */
+        class Subscription
+        {
+        public:
+            using Ptr = std::shared_ptr<Subscription>;
+
+            //==============================================================================
+            /**
+             * @brief Wait for samples to be published
+             *
+             * @param [in] timeout  Maximum time to wait
+             *
+             * @returns All queued samples, in publication order (empty on timeout or close)
+             */
+            std::vector<ClimateSample> pop(std::chrono::milliseconds timeout);
+
+            /// Wake up waiting consumer & stop accepting samples
+            void close();
+
+            bool isClosed() const;
+
+            /// Get number of samples dropped since subscribing
+            size_t dropped() const;
+
+            //==============================================================================
+            /// Construct empty queue (NB: use ClimateBroadcaster::subscribe() instead)
+            explicit Subscription(size_t capacity);
+
+        private:
+            friend class ClimateBroadcaster;
+
+            void push(const ClimateSample& sample);
+
+            //==============================================================================
+            const size_t _capacity;
+
+            std::deque<ClimateSample> _queue;
+            size_t _dropped;
+            bool _closed;
+
+            mutable std::mutex _mutex;
+            std::condition_variable _condition;
+        };
+
+        //==============================================================================
+        ClimateBroadcaster();
+
+        /**
+         * @brief Close all subscriptions
+         */
+        ~ClimateBroadcaster();
+
+        //==============================================================================
+        /**
+         * @brief Subscribe to published samples
+         *
+         * @param [in] capacity     Maximum number of samples queued for this subscriber
+         *
+         * @returns Subscription handle; releasing it unsubscribes
+         */
+        Subscription::Ptr subscribe(size_t capacity = DEFAULT_CAPACITY);
+
+        /**
+         * @brief Queue sample for all current subscribers
+         *
+         * @param [in] sample   Sample to publish
+         */
+        void publish(const ClimateSample& sample);
+
+        /// Get number of live subscriptions
+        size_t size() const;
+
+        //==============================================================================
+        static constexpr size_t DEFAULT_CAPACITY = 64;
+
+
+    private:
+        //==============================================================================
+        using SubscriberList = std::vector<std::weak_ptr<Subscription>>;
+
+        /// Remove subscribers which have been released
+        void prune();
+
+        /// Copy subscriber list without released subscribers (NB: update mutex must be held)
+        std::shared_ptr<SubscriberList> getLiveSubscribers() const;
+
+        //==============================================================================
+        /// Immutable snapshot, swapped atomically whenever subscribers change
+        std::shared_ptr<const SubscriberList> _subscribers;
+
+        /// Serialises copy-on-write updates of the subscriber list
+        std::mutex _updateMutex;
+    };
+
+} // namespace beewatch
@@ -0,0 +1,140 @@
+//==============================================================================
+// Copyright (c) 2018 Eric Seguin, all rights reserved.
+//==============================================================================
+
+#pragma once
+
+#include "util/data_types.hpp"
+#include "util/patterns.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace beewatch
+{
+
+    //==============================================================================
+    /**
+     * @class ClimateCache
+     *
+     * In-memory ring buffer of each sensor's most recent climate samples, answering
+     * queries on recent history without going to the DB.
+     *
+     * Buffers are read-copy-update: readers work on an immutable snapshot and never
+     * wait, while writers copy the buffers they change and swap the snapshot in.
+     * Samples are written every few minutes, so copying is cheap next to DB queries.
+     *
+     * A sensor's buffer covers everything since its first sample, until it wraps
+     * around: it then covers everything after the oldest sample it dropped. Samples
+     * must thus be added from the first one of each sensor, or seeded with its
+     * latest samples from the DB, for queries to be answered.
+     */
+    class ClimateCache : public unique_ownership_t<ClimateCache>
+    {
+    public:
+        //==============================================================================
+        /**
+         * @brief Construct empty cache
+         *
+         * @param [in] capacity     Maximum number of samples kept per sensor
+         *
+         * @throws std::invalid_argument if capacity is zero
+         */
+        explicit ClimateCache(size_t capacity = DEFAULT_CAPACITY);
+
+        //==============================================================================
+        /// Add batch of samples, possibly from several sensors
+        void add(const std::vector<ClimateSample>& samples);
+
+        /// Add series of samples from a given sensor
+        void add(const std::string& sensorID, const ClimateSeries& series);
+
+        /**
+         * @brief Replace a sensor's buffer with its latest samples, e.g. read from the DB
+         *
+         * @param [in] sensorID     Sensor the samples belong to
+         * @param [in] series       Sensor's latest samples, ordered by time
+         * @param [in] isComplete   Whether the series holds all of the sensor's samples;
+         *                          otherwise, only what follows its first sample is covered
+         */
+        void seed(const std::string& sensorID, const ClimateSeries& series, bool isComplete);
+
+        /// Drop all samples
+        void clear();
+
+        //==============================================================================
+        /**
+         * @brief Read samples from a sensor's buffer, if it holds the whole time window
+         *
+         * @param [in] sensorID     Sensor to read samples from
+         * @param [in] since        Unix timestamp of earliest sample to read
+         * @param [in] until        Unix timestamp samples must precede (exclusive)
+         * @param [in] limit        Maximum number of samples, or 0 for no limit
+         * @param [out] series      Samples read, ordered by time
+         *
+         * @returns True if the query was answered, false if it must go to the DB
+         */
+        bool get(const std::string& sensorID, int64_t since, int64_t until, size_t limit,
+                 ClimateSeries& series) const;
+
+        /// Get timestamp from which all of a sensor's samples are held (max. value if it has no buffer)
+        int64_t getCoveredSince(const std::string& sensorID) const;
+
+        //==============================================================================
+        /// Enough for a week of samples taken every 5 minutes
+        static constexpr size_t DEFAULT_CAPACITY = 2048;
+
+
+    private:
+        //==============================================================================
+        /**
+         * @struct Ring
+         *
+         * Fixed-capacity circular buffer of a single sensor's samples, in time order
+         */
+        struct Ring
+        {
+            explicit Ring(size_t capacity);
+
+            /// Append sample, overwriting oldest one when full
+            void push_back(int64_t timestamp, const ClimateData<double>& sample);
+
+            /// Get physical index of i-th oldest sample
+            size_t index(size_t i) const { return (start + i) % timestamps.size(); }
+
+            /// Get timestamp of i-th oldest sample
+            int64_t timestamp(size_t i) const { return timestamps[index(i)]; }
+
+            std::vector<int64_t> timestamps;
+            std::vector<ClimateData<double>> data;
+
+            size_t start;
+            size_t size;
+
+            /// All samples from this time onwards are held
+            int64_t coveredSince;
+        };
+
+        using RingMap = std::map<std::string, std::shared_ptr<const Ring>>;
+
+        /// Copy current buffers, apply changes & publish them (NB: update mutex must be held)
+        template <typename Function>
+        void update(Function change);
+
+        //==============================================================================
+        const size_t _capacity;
+
+        /// Immutable snapshot, swapped atomically whenever samples are added
+        std::shared_ptr<const RingMap> _rings;
+
+        /// Serialises copy-on-write updates of the buffers
+        std::mutex _updateMutex;
+    };
+
+} // namespace beewatch
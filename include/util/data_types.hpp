@@ -4,6 +4,12 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
 namespace beewatch
 {
     
@@ -114,5 +120,152 @@ namespace beewatch
             return lhs;
         }
     };
+    
+    //==============================================================================
+    /**
+     * @struct ClimateSample
+     *
+     * Holds a timestamped climate measurement from a given sensor
+     */
+    struct ClimateSample
+    {
+        std::string sensorID;
+        int64_t timestamp = 0;
+        ClimateData<double> data;
+    };
+    
+    //==============================================================================
+    /**
+     * @struct ClimateSeries
+     *
+     * Time-ordered climate samples from a single sensor, stored column by column
+     * in contiguous buffers
+     */
+    struct ClimateSeries
+    {
+        std::vector<int64_t> timestamps;
+        std::vector<double> temperature;
+        std::vector<double> humidity;
+
+        size_t size() const { return timestamps.size(); }
+        bool empty() const { return timestamps.empty(); }
+
+        /// Reserve space for the given number of samples in all columns
+        void reserve(size_t numSamples)
+        {
+            timestamps.reserve(numSamples);
+            temperature.reserve(numSamples);
+            humidity.reserve(numSamples);
+        }
+
+        /// Remove all samples, keeping allocated space
+        void clear()
+        {
+            timestamps.clear();
+            temperature.clear();
+            humidity.clear();
+        }
+
+        /// Keep only the given number of earliest samples
+        void resize(size_t numSamples)
+        {
+            timestamps.resize(numSamples);
+            temperature.resize(numSamples);
+            humidity.resize(numSamples);
+        }
+
+        /// Append sample (NB: samples must be appended in time order)
+        void push_back(int64_t timestamp, const ClimateData<double>& data)
+        {
+            timestamps.push_back(timestamp);
+            temperature.push_back(data.temperature);
+            humidity.push_back(data.humidity);
+        }
+
+        /// Get climate data of sample at given index
+        ClimateData<double> data(size_t index) const
+        {
+            ClimateData<double> sample;
+
+            sample.temperature = temperature[index];
+            sample.humidity = humidity[index];
+
+            return sample;
+        }
+    };
+
+    /// Receives climate samples batch by batch, returning false to stop reading
+    using ClimateVisitor = std::function<bool(const ClimateSeries&)>;
+    
+    //==============================================================================
+    /**
+     * @struct ClimateAggregate
+     *
+     * Summarises the climate samples taken over a period of time
+     */
+    struct ClimateAggregate
+    {
+        ClimateData<double> min;
+        ClimateData<double> max;
+        ClimateData<double> mean;
+
+        uint32_t count = 0;
+
+        /**
+         * @brief Add sample to aggregate
+         *
+         * @param [in] data     Sample to add
+         */
+        void add(const ClimateData<double>& data)
+        {
+            if (count == 0)
+            {
+                min = max = mean = data;
+            }
+            else
+            {
+                min.humidity = std::min(min.humidity, data.humidity);
+                min.temperature = std::min(min.temperature, data.temperature);
+
+                max.humidity = std::max(max.humidity, data.humidity);
+                max.temperature = std::max(max.temperature, data.temperature);
+
+                // Running mean, avoids accumulating a large sum
+                mean += (data - mean) / double(count + 1);
+            }
+
+            count++;
+        }
+    };
+
+    //==============================================================================
+    /**
+     * @struct ClimateWatermark
+     *
+     * Identifies the state of a sensor's stored climate data, to tell whether it
+     * has changed without querying the DB
+     */
+    struct ClimateWatermark
+    {
+        /// Timestamp of latest sample
+        int64_t lastTimestamp = 0;
+
+        /// Number of samples written
+        uint64_t count = 0;
+
+        /// Incremented every time climate data is cleared
+        uint64_t generation = 0;
+
+        /**
+         * @brief Account for a new sample
+         *
+         * @param [in] timestamp    Sample timestamp
+         */
+        void add(int64_t timestamp)
+        {
+            lastTimestamp = std::max(lastTimestamp, timestamp);
+            count++;
+        }
+    };
 
 } // namespace beewatch
@@ -7,16 +7,150 @@
 #include "util/data_types.hpp"
 #include "util/patterns.hpp"
 
+#include <atomic>
 #include <cstdint>
+#include <limits>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <string>
+#include <vector>
 
 namespace beewatch
 {
 
     //==============================================================================
-    class DB : public unique_ownership_t<DB>
+    /**
+     * @interface IDB
+     *
+     * Storage backend for climate data & device attributes
+     */
+    class IDB : public unique_ownership_t<IDB>
+    {
+    public:
+        //==============================================================================
+        virtual ~IDB() = default;
+
+        //==============================================================================
+        /// Drop all data from DB
+        virtual void clear() = 0;
+
+
+        //==============================================================================
+        /// Read climate data from DB
+        virtual ClimateSeries getClimateData(std::string sensorID, int64_t since = 0) = 0;
+
+        /**
+         * @brief Read climate data for several sensors at once
+         *
+         * @param [in] sensorIDs    Sensors to read samples from
+         * @param [in] since        Unix timestamp of earliest sample to read
+         * @param [in] until        Unix timestamp samples must precede (exclusive)
+         * @param [in] limit        Maximum number of samples per sensor, or 0 for no limit
+         *
+         * @returns Earliest samples of each sensor in the window, keyed by sensor ID
+         *          (sensors without samples are omitted)
+         */
+        virtual std::map<std::string, ClimateSeries> getClimateData(const std::vector<std::string>& sensorIDs,
+                                                                    int64_t since = 0,
+                                                                    int64_t until = MAX_TIMESTAMP,
+                                                                    size_t limit = 0) = 0;
+
+        /**
+         * @brief Stream climate data from DB in fixed-size batches
+         *
+         * Only one batch is held in memory at a time, regardless of the amount of
+         * history read. The batch passed to the visitor is reused between calls.
+         *
+         * @param [in] sensorID     Sensor to read samples from
+         * @param [in] since        Unix timestamp of earliest sample to read
+         * @param [in] visit        Visitor called for each batch, returning false to stop
+         * @param [in] batchSize    Maximum number of samples per batch
+         */
+        virtual void visitClimateData(std::string sensorID, int64_t since, const ClimateVisitor& visit,
+                                      size_t batchSize = DEFAULT_BATCH_SIZE) = 0;
+
+        /// Append climate data to DB
+        virtual void addClimateData(std::string sensorID, int64_t timestamp, ClimateData<double> data) = 0;
+
+        /**
+         * @brief Append batch of climate samples to DB in a single transaction
+         *
+         * @returns True if the batch was written, false if it must be retried
+         */
+        virtual bool addClimateData(const std::vector<ClimateSample>& samples) = 0;
+
+        /**
+         * @brief Get watermarks of several sensors' climate data without reading their samples
+         *
+         * @param [in] sensorIDs    Sensors to get watermarks for
+         *
+         * @returns Timestamp of latest sample & number of samples of each sensor, keyed by
+         *          sensor ID (sensors without samples are omitted)
+         */
+        virtual std::map<std::string, ClimateWatermark> getClimateWatermarks(const std::vector<std::string>& sensorIDs) = 0;
+
+        /**
+         * @brief Read latest climate data of several sensors at once
+         *
+         * @param [in] sensorIDs    Sensors to read samples from
+         * @param [in] limit        Maximum number of samples per sensor
+         *
+         * @returns Latest samples of each sensor ordered by time, keyed by sensor ID
+         *          (sensors without samples are omitted)
+         */
+        virtual std::map<std::string, ClimateSeries> getLatestClimateData(const std::vector<std::string>& sensorIDs,
+                                                                          size_t limit) = 0;
+
+        /**
+         * @brief Read persisted aggregates of a sensor's rollup tier
+         *
+         * @param [in] sensorID     Sensor to read aggregates for
+         * @param [in] period       Tier period, in seconds
+         *
+         * @returns Aggregates ordered by bucket start time
+         */
+        virtual std::map<int64_t, ClimateAggregate> getClimateAggregates(std::string sensorID, int64_t period) = 0;
+
+        /**
+         * @brief Persist aggregates of a sensor's rollup tier, replacing those of the same buckets
+         *
+         * @param [in] sensorID     Sensor the aggregates belong to
+         * @param [in] period       Tier period, in seconds
+         * @param [in] aggregates   Aggregates by bucket start time
+         *
+         * @returns True if the aggregates were written, false if they must be retried
+         */
+        virtual bool addClimateAggregates(std::string sensorID, int64_t period,
+                                          const std::map<int64_t, ClimateAggregate>& aggregates) = 0;
+
+        /// Delete all climate data from DB
+        virtual void clearClimateData() = 0;
+
+
+        //==============================================================================
+        /// Read device name from DB
+        virtual std::string getName() = 0;
+
+        /// Update device name in DB
+        virtual void setName(std::string name) = 0;
+
+        /// Delete device attributes from DB
+        virtual void clearAboutData() = 0;
+
+
+        //==============================================================================
+        static constexpr size_t DEFAULT_BATCH_SIZE = 1000;
+        static constexpr int64_t MAX_TIMESTAMP = std::numeric_limits<int64_t>::max();
+    };
+
+    //==============================================================================
+    /**
+     * @class DB
+     *
+     * PostgreSQL client implementing the DB interface
+     */
+    class DB : public IDB
     {
     public:
         //==============================================================================
@@ -24,58 +158,88 @@ namespace beewatch
          * @brief Construct a DB client, connecting to instance on the given host
          *
          * If the connection fails (e.g. DB inaccessible), an exception is thrown.
+         * Afterwards, lost connections are re-established automatically, backing off
+         * while the DB is unreachable.
+         *
+         * @param [in] poolSize     Maximum number of concurrent connections
          *
          * @throws std::invalid_argument
          */
         DB(std::string name = DEFAULT_NAME,
-           std::string host = DEFAULT_HOST, uint16_t port = DEFAULT_PORT);
+           std::string host = DEFAULT_HOST, uint16_t port = DEFAULT_PORT,
+           size_t poolSize = DEFAULT_POOL_SIZE);
 
-        ~DB();
+        virtual ~DB();
 
 
         //==============================================================================
         /// Drop all tables from DB
-        void clear();
+        virtual void clear() override;
 
 
         //==============================================================================
         /// Read climate data from DB
-        std::map<int64_t, ClimateData<double>> getClimateData(std::string sensorID, int64_t since = 0);
+        virtual ClimateSeries getClimateData(std::string sensorID, int64_t since = 0) override;
+
+        /// Read climate data for several sensors in a single query
+        virtual std::map<std::string, ClimateSeries> getClimateData(const std::vector<std::string>& sensorIDs,
+                                                                    int64_t since = 0,
+                                                                    int64_t until = MAX_TIMESTAMP,
+                                                                    size_t limit = 0) override;
+
+        /// Stream climate data from DB through a server-side cursor
+        virtual void visitClimateData(std::string sensorID, int64_t since, const ClimateVisitor& visit,
+                                      size_t batchSize = DEFAULT_BATCH_SIZE) override;
 
         /// Append climate data to DB
-        void addClimateData(std::string sensorID, int64_t timestamp, ClimateData<double> data);
+        virtual void addClimateData(std::string sensorID, int64_t timestamp, ClimateData<double> data) override;
+
+        /// Append batch of climate samples to DB in a single transaction
+        virtual bool addClimateData(const std::vector<ClimateSample>& samples) override;
+
+        /// Get watermarks of several sensors' climate data in a single query
+        virtual std::map<std::string, ClimateWatermark> getClimateWatermarks(const std::vector<std::string>& sensorIDs) override;
+
+        /// Read latest climate data of several sensors in a single query
+        virtual std::map<std::string, ClimateSeries> getLatestClimateData(const std::vector<std::string>& sensorIDs,
+                                                                          size_t limit) override;
+
+        /// Read persisted aggregates of a sensor's rollup tier
+        virtual std::map<int64_t, ClimateAggregate> getClimateAggregates(std::string sensorID, int64_t period) override;
+
+        /// Upsert aggregates of a sensor's rollup tier in a single transaction
+        virtual bool addClimateAggregates(std::string sensorID, int64_t period,
+                                          const std::map<int64_t, ClimateAggregate>& aggregates) override;
 
-        /// Drop climate data table from DB
-        void clearClimateData();
+        /// Delete all climate data & aggregates from DB
+        virtual void clearClimateData() override;
 
 
         //==============================================================================
         /// Read device name from DB
-        std::string getName();
+        virtual std::string getName() override;
 
         /// Update device name in DB
-        void setName(std::string name);
+        virtual void setName(std::string name) override;
 
         /// Drop About table from DB
-        void clearAboutData();
+        virtual void clearAboutData() override;
 
         
         //==============================================================================
         static constexpr auto DEFAULT_NAME = "beewatch";
         static constexpr auto DEFAULT_HOST = "127.0.0.1";
         static constexpr uint16_t DEFAULT_PORT = 5432;
+        static constexpr size_t DEFAULT_POOL_SIZE = 4;
 
 
     private:
         //==============================================================================
-        /// Check if table exists in DB
-        bool hasTable(std::string name);
+        /// Create or migrate climate data tables unless they are known to be up to date
+        void ensureClimateSchema();
 
-        /// Create "ClimateData" table
-        void createClimateDataTable();
-
-        /// Create "About" table
-        void createAboutTable();
+        /// Create "About" table with default name unless it is known to exist
+        void ensureAboutTable();
 
 
         //==============================================================================
@@ -84,6 +248,23 @@ namespace beewatch
         impl * pimpl;
 
 
+        //==============================================================================
+        /// Cached schema state, only reset when tables are dropped
+        std::atomic<bool> _isClimateSchemaReady;
+        std::atomic<bool> _hasAboutTable;
+
+        //==============================================================================
+        /**
+         * @brief Get key of sensor in "Sensors" lookup table, registering it if needed
+         *
+         * @returns Sensor key, or -1 on error
+         */
+        int getSensorKey(const std::string& sensorID);
+
+        /// Cache of sensor IDs to keys (keys are never reused, so entries remain valid)
+        std::map<std::string, int> _sensorKeys;
+        std::mutex _sensorKeyMutex;
+
         //==============================================================================
         bool _isConnected;
 
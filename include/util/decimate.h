@@ -0,0 +1,36 @@
+//==============================================================================
+// Copyright (c) 2018 Eric Seguin, all rights reserved.
+//==============================================================================
+
+#pragma once
+
+#include "util/data_types.hpp"
+
+#include <cstddef>
+
+namespace beewatch
+{
+
+    //==============================================================================
+    /**
+     * @brief Reduce a series to a given number of points for display, using the
+     *        Largest-Triangle-Three-Buckets algorithm
+     *
+     * The first & last samples are kept, and the remaining samples are split into
+     * equal buckets. From each bucket, the sample forming the largest triangle with
+     * the previously kept sample & the next bucket's average is kept, which preserves
+     * peaks & troughs better than averaging. Triangle areas from the temperature &
+     * humidity columns are summed, so both columns keep the same timestamps.
+     *
+     * Runs in a single pass over the series.
+     *
+     * @param [in] series   Time-ordered samples
+     * @param [in] points   Maximum number of samples to keep
+     *
+     * @returns Decimated series, or a copy of the series if it already fits
+     *
+     * @throws std::invalid_argument if fewer than 3 points are requested
+     */
+    ClimateSeries decimateLTTB(const ClimateSeries& series, size_t points);
+
+} // namespace beewatch
@@ -0,0 +1,125 @@
+//==============================================================================
+// Copyright (c) 2018 Eric Seguin, all rights reserved.
+//==============================================================================
+
+#pragma once
+
+#include "util/db.h"
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace beewatch
+{
+
+    //==============================================================================
+    /**
+     * @class EmbeddedDB
+     *
+     * Embedded time-series store implementing the DB interface without a DB server.
+     *
+     * Each sensor's samples are appended to memory-mapped segment files holding
+     * fixed-width records (time, temperature, humidity). Samples are assumed to be
+     * appended in time order, so range reads are binary searches over the mapped
+     * records, narrowed down by a sparse index holding each segment's first timestamp.
+     *
+     * Full segments are sealed: their records are compressed into a Gorilla chunk
+     * (see GorillaEncoder), which replaces the segment file and is decoded on the
+     * fly when read.
+     *
+     * Directory layout:
+     *
+     *     <path>/name                          Device name
+     *     <path>/climate/<sensor>/<N>.seg      Nth segment of sensor's samples
+     *     <path>/climate/<sensor>/<N>.chunk    Nth segment of sensor's samples, once sealed
+     *     <path>/climate/<sensor>/<P>.agg      Aggregates of sensor's rollup tier with period P
+     *
+     * Aggregate files are append-only: rewritten buckets are appended again and the
+     * latest record of each bucket wins when the file is read.
+     */
+    class EmbeddedDB : public IDB
+    {
+    public:
+        //==============================================================================
+        /**
+         * @brief Open store in the given directory, creating it if needed
+         *
+         * @param [in] path             Directory holding the store's files
+         * @param [in] segmentCapacity  Number of records per segment file
+         *
+         * @throws std::runtime_error if the directory cannot be created
+         */
+        EmbeddedDB(std::string path = DEFAULT_PATH, size_t segmentCapacity = DEFAULT_SEGMENT_CAPACITY);
+
+        virtual ~EmbeddedDB();
+
+
+        //==============================================================================
+        /// Delete all data from store
+        virtual void clear() override;
+
+
+        //==============================================================================
+        /// Read climate data from store
+        virtual ClimateSeries getClimateData(std::string sensorID, int64_t since = 0) override;
+
+        /// Read climate data for several sensors under a single lock
+        virtual std::map<std::string, ClimateSeries> getClimateData(const std::vector<std::string>& sensorIDs,
+                                                                    int64_t since = 0,
+                                                                    int64_t until = MAX_TIMESTAMP,
+                                                                    size_t limit = 0) override;
+
+        /// Stream climate data directly from mapped segments
+        virtual void visitClimateData(std::string sensorID, int64_t since, const ClimateVisitor& visit,
+                                      size_t batchSize = DEFAULT_BATCH_SIZE) override;
+
+        /// Append climate data to store
+        virtual void addClimateData(std::string sensorID, int64_t timestamp, ClimateData<double> data) override;
+
+        /// Append batch of climate samples to store
+        virtual bool addClimateData(const std::vector<ClimateSample>& samples) override;
+
+        /// Get watermarks of several sensors' climate data from segment sizes
+        virtual std::map<std::string, ClimateWatermark> getClimateWatermarks(const std::vector<std::string>& sensorIDs) override;
+
+        /// Read latest climate data of several sensors under a single lock
+        virtual std::map<std::string, ClimateSeries> getLatestClimateData(const std::vector<std::string>& sensorIDs,
+                                                                          size_t limit) override;
+
+        /// Read persisted aggregates of a sensor's rollup tier
+        virtual std::map<int64_t, ClimateAggregate> getClimateAggregates(std::string sensorID, int64_t period) override;
+
+        /// Append aggregates of a sensor's rollup tier to its aggregate file
+        virtual bool addClimateAggregates(std::string sensorID, int64_t period,
+                                          const std::map<int64_t, ClimateAggregate>& aggregates) override;
+
+        /// Delete all climate data from store
+        virtual void clearClimateData() override;
+
+
+        //==============================================================================
+        /// Read device name from store
+        virtual std::string getName() override;
+
+        /// Update device name in store
+        virtual void setName(std::string name) override;
+
+        /// Delete device name from store
+        virtual void clearAboutData() override;
+
+
+        //==============================================================================
+        static constexpr auto DEFAULT_PATH = "/var/lib/beewatch";
+        static constexpr size_t DEFAULT_SEGMENT_CAPACITY = 64 * 1024;   // 1 MiB per segment
+
+
+    private:
+        //==============================================================================
+        /// Store implementation (pimpl)
+        struct impl;
+        impl * pimpl;
+    };
+
+} // namespace beewatch
@@ -0,0 +1,194 @@
+//==============================================================================
+// Copyright (c) 2018 Eric Seguin, all rights reserved.
+//==============================================================================
+
+#pragma once
+
+#include "util/data_types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace beewatch
+{
+
+    //==============================================================================
+    /**
+     * @struct GorillaState
+     *
+     * Predictor state shared by the Gorilla encoder and decoder
+     */
+    struct GorillaState
+    {
+        /// Timestamp predictor: previous timestamp and delta
+        int64_t prevTime = 0;
+        int64_t prevDelta = 0;
+
+        /// Value predictor, one per climate value
+        struct Value
+        {
+            uint64_t prevBits = 0;
+
+            /// Window of meaningful bits in previous non-zero XOR
+            unsigned leadingZeros = 0;
+            unsigned trailingZeros = 0;
+            bool hasWindow = false;
+        };
+
+        Value temperature;
+        Value humidity;
+    };
+
+    //==============================================================================
+    /**
+     * @class GorillaEncoder
+     *
+     * Encodes a climate data series into a compressed chunk, following the scheme
+     * from Facebook's Gorilla time-series DB:
+     *
+     *   - Timestamps are stored as delta-of-deltas in variable-width buckets, so a
+     *     regular sampling period costs a single bit per sample
+     *   - Each value is XORed with the previous value of the same column, and only
+     *     the meaningful bits of the XOR are stored, so unchanged values cost a
+     *     single bit and slowly changing values only a few
+     *
+     * Chunk layout: 1-byte version, 4-byte little-endian sample count, bit stream.
+     */
+    class GorillaEncoder
+    {
+    public:
+        //==============================================================================
+        GorillaEncoder();
+
+        //==============================================================================
+        /**
+         * @brief Append sample to chunk
+         *
+         * @param [in] time     Sample timestamp
+         * @param [in] data     Sample climate data
+         */
+        void append(int64_t time, const ClimateData<double>& data);
+
+        /// Get number of encoded samples
+        size_t size() const { return _count; }
+
+        /// Get encoded chunk (valid until next append)
+        const std::vector<uint8_t>& bytes() const { return _bytes; }
+
+        //==============================================================================
+        /// Encode whole series into a chunk
+        static std::vector<uint8_t> encode(const ClimateSeries& series);
+
+        static constexpr uint8_t VERSION = 1;
+        static constexpr size_t HEADER_SIZE = 5;
+
+    private:
+        //==============================================================================
+        void writeBits(uint64_t value, unsigned numBits);
+        void writeTime(int64_t time);
+        void writeValue(double value, GorillaState::Value& state);
+
+        //==============================================================================
+        std::vector<uint8_t> _bytes;
+
+        /// Number of unused bits in last byte
+        unsigned _freeBits;
+
+        uint32_t _count;
+        GorillaState _state;
+    };
+
+    //==============================================================================
+    /**
+     * @class GorillaDecoder
+     *
+     * Decodes a chunk produced by GorillaEncoder.
+     *
+     * Samples are decoded one at a time while iterating, so a chunk never has to be
+     * inflated as a whole. The chunk's bytes must outlive the decoder & its iterators.
+     */
+    class GorillaDecoder
+    {
+    public:
+        //==============================================================================
+        using Sample = std::pair<int64_t, ClimateData<double>>;
+
+        /**
+         * @class iterator
+         *
+         * Input iterator decoding samples on the fly
+         *
+         * @throws std::out_of_range when incrementing past the end of a truncated chunk
+         */
+        class iterator
+        {
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type = Sample;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const Sample *;
+            using reference = const Sample&;
+
+            reference operator*() const { return _sample; }
+            pointer operator->() const { return &_sample; }
+
+            iterator& operator++();
+            iterator operator++(int) { auto copy = *this; ++*this; return copy; }
+
+            bool operator==(const iterator& rhs) const { return _index == rhs._index; }
+            bool operator!=(const iterator& rhs) const { return _index != rhs._index; }
+
+        private:
+            friend class GorillaDecoder;
+
+            iterator(const GorillaDecoder& decoder, size_t index);
+
+            uint64_t readBits(unsigned numBits);
+            int64_t readTime();
+            double readValue(GorillaState::Value& state);
+
+            void decodeNext();
+
+            const uint8_t * _data;
+            size_t _size;
+            size_t _count;
+
+            /// Position in bit stream
+            size_t _bitPos;
+
+            size_t _index;
+            Sample _sample;
+            GorillaState _state;
+        };
+
+        //==============================================================================
+        /**
+         * @brief Attach decoder to chunk
+         *
+         * @throws std::invalid_argument if chunk header is missing or unsupported
+         */
+        GorillaDecoder(const uint8_t * data, size_t size);
+        explicit GorillaDecoder(const std::vector<uint8_t>& chunk);
+
+        //==============================================================================
+        /// Get number of samples in chunk
+        size_t size() const { return _count; }
+
+        iterator begin() const { return iterator(*this, 0); }
+        iterator end() const { return iterator(*this, _count); }
+
+        //==============================================================================
+        /// Decode whole chunk into a series
+        static ClimateSeries decode(const std::vector<uint8_t>& chunk);
+
+    private:
+        //==============================================================================
+        const uint8_t * _data;
+        size_t _size;
+        size_t _count;
+    };
+
+} // namespace beewatch
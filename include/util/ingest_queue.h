@@ -0,0 +1,143 @@
+//==============================================================================
+// Copyright (c) 2018 Eric Seguin, all rights reserved.
+//==============================================================================
+
+#pragma once
+
+#include "util/data_types.hpp"
+#include "util/patterns.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace beewatch
+{
+
+    //==============================================================================
+    /**
+     * @class IngestQueue
+     *
+     * Bounded queue of climate samples drained by a background writer thread.
+     *
+     * Samples are gathered and handed to the flush function in batches, either once
+     * the batch size is reached or once the oldest queued sample has waited for the
+     * flush interval. Producers never wait on the flush function: if the queue is
+     * full, the oldest sample is dropped to make room for the new one.
+     *
+     * Batches which fail to be written are put back at the front of the queue and
+     * retried, backing off exponentially while writes keep failing.
+     */
+    class IngestQueue : public unique_ownership_t<IngestQueue>
+    {
+    public:
+        //==============================================================================
+        /// Function persisting a batch of samples, returning false (or throwing) if it must be retried
+        using FlushFunction = std::function<bool(const std::vector<ClimateSample>&)>;
+
+        /**
+         * @brief Construct queue and start its writer thread
+         *
+         * @param [in] flush            Function persisting a batch of samples
+         * @param [in] capacity         Maximum number of queued samples
+         * @param [in] batchSize        Number of queued samples triggering a flush
+         * @param [in] flushInterval    Maximum time a sample may wait before being flushed
+         * @param [in] retryInterval    Time to wait before retrying a failed write (doubled on each failure)
+         */
+        IngestQueue(FlushFunction flush,
+                    size_t capacity = DEFAULT_CAPACITY,
+                    size_t batchSize = DEFAULT_BATCH_SIZE,
+                    std::chrono::milliseconds flushInterval = DEFAULT_FLUSH_INTERVAL,
+                    std::chrono::milliseconds retryInterval = DEFAULT_RETRY_INTERVAL);
+
+        /**
+         * @brief Flush remaining samples and stop writer thread
+         *
+         * Samples are discarded if this last write fails.
+         */
+        ~IngestQueue();
+
+        //==============================================================================
+        /**
+         * @brief Queue sample for writing
+         *
+         * @param [in] sample   Sample to queue
+         *
+         * @returns False if the oldest queued sample had to be dropped, true otherwise
+         */
+        bool push(ClimateSample sample);
+
+        /**
+         * @brief Write all queued samples, blocking until they have been flushed
+         *
+         * @returns False if a write failed, leaving samples queued for a retry
+         */
+        bool flush();
+
+        /**
+         * @brief Discard all queued samples, waiting for any batch being written
+         */
+        void clear();
+
+        /**
+         * @brief Get number of queued samples
+         */
+        size_t size() const;
+
+        //==============================================================================
+        static constexpr size_t DEFAULT_CAPACITY = 1024;
+        static constexpr size_t DEFAULT_BATCH_SIZE = 64;
+        static constexpr std::chrono::milliseconds DEFAULT_FLUSH_INTERVAL = std::chrono::seconds(10);
+        static constexpr std::chrono::milliseconds DEFAULT_RETRY_INTERVAL = std::chrono::seconds(1);
+        static constexpr std::chrono::milliseconds MAX_RETRY_INTERVAL = std::chrono::minutes(1);
+
+
+    private:
+        //==============================================================================
+        /**
+         * @brief Writer thread: waits for a flush condition, then writes queued samples
+         */
+        void writerLoop();
+
+        /**
+         * @brief Put batch which failed to be written back at the front of the queue
+         *
+         * NB: _mutex must be held
+         */
+        void requeue(std::vector<ClimateSample>& batch, std::chrono::steady_clock::time_point batchTime);
+
+        //==============================================================================
+        FlushFunction _flush;
+
+        const size_t _capacity;
+        const size_t _batchSize;
+        const std::chrono::milliseconds _flushInterval;
+        const std::chrono::milliseconds _retryInterval;
+
+        //==============================================================================
+        /// Queued samples, with the time at which the oldest one was queued
+        std::deque<ClimateSample> _queue;
+        std::chrono::steady_clock::time_point _oldestTime;
+
+        mutable std::mutex _mutex;
+        std::condition_variable _wakeCondition;
+        std::condition_variable _idleCondition;
+
+        bool _flushRequested;
+        bool _writing;
+        bool _stop;
+
+        /// Backoff after failed writes, & number of failed writes so far
+        std::chrono::milliseconds _backoff;
+        std::chrono::steady_clock::time_point _retryTime;
+        size_t _numFailures;
+
+        std::unique_ptr<std::thread> _thread;
+    };
+
+} // namespace beewatch
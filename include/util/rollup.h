@@ -0,0 +1,160 @@
+//==============================================================================
+// Copyright (c) 2018 Eric Seguin, all rights reserved.
+//==============================================================================
+
+#pragma once
+
+#include "util/data_types.hpp"
+#include "util/patterns.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+namespace beewatch
+{
+
+    //==============================================================================
+    /**
+     * @class ClimateRollup
+     *
+     * In-process downsampled tiers of climate history.
+     *
+     * Each tier holds the min/max/mean of every sensor's samples per period (e.g. per
+     * hour and per day), updated incrementally as samples are added. Periods are
+     * aligned on the Unix epoch, so daily buckets start at midnight UTC.
+     *
+     * Closed buckets (those preceding a sensor's latest bucket) are meant to be
+     * persisted as they close, and restored on startup: only samples taken since the
+     * last persisted bucket must then be replayed. Samples falling into persisted
+     * buckets are ignored.
+     */
+    class ClimateRollup : public unique_ownership_t<ClimateRollup>
+    {
+    public:
+        //==============================================================================
+        /**
+         * @brief Construct empty rollup
+         *
+         * @param [in] periods  Tier periods, in seconds
+         *
+         * @throws std::invalid_argument if a period is not strictly positive
+         */
+        ClimateRollup(std::vector<int64_t> periods = { HOUR, DAY });
+
+        //==============================================================================
+        /// Add sample to all tiers
+        void add(const ClimateSample& sample);
+
+        /// Add batch of samples to all tiers
+        void add(const std::vector<ClimateSample>& samples);
+
+        /// Add series of samples from a given sensor to all tiers
+        void add(const std::string& sensorID, const ClimateSeries& series);
+
+        /// Delete all aggregates
+        void clear();
+
+        //==============================================================================
+        /**
+         * @struct Closed
+         *
+         * Closed buckets of a sensor's tier which haven't been persisted yet
+         */
+        struct Closed
+        {
+            std::string sensorID;
+            int64_t period;
+
+            std::map<int64_t, ClimateAggregate> buckets;
+        };
+
+        /**
+         * @brief Restore persisted buckets of a sensor's tier
+         *
+         * @param [in] sensorID     Sensor the buckets belong to
+         * @param [in] period       Tier period
+         * @param [in] buckets      Aggregates by bucket start time
+         *
+         * @returns Unix timestamp from which samples must be replayed into the tier
+         *          (min. value if no buckets were restored)
+         *
+         * @throws std::invalid_argument if there is no tier with the given period
+         */
+        int64_t restore(const std::string& sensorID, int64_t period, std::map<int64_t, ClimateAggregate> buckets);
+
+        /// Get closed buckets of every sensor's tiers which haven't been persisted yet
+        std::vector<Closed> getUnpersisted() const;
+
+        /**
+         * @brief Mark buckets of a sensor's tier as persisted
+         *
+         * @param [in] sensorID     Sensor the buckets belong to
+         * @param [in] period       Tier period
+         * @param [in] until        Unix timestamp buckets were persisted until (exclusive)
+         *
+         * @throws std::invalid_argument if there is no tier with the given period
+         */
+        void setPersisted(const std::string& sensorID, int64_t period, int64_t until);
+
+        /// Get tier periods, in increasing order
+        std::vector<int64_t> getPeriods() const;
+
+        //==============================================================================
+        /**
+         * @brief Select coarsest tier whose period doesn't exceed the requested resolution
+         *
+         * @param [in] resolution   Requested resolution, in seconds
+         *
+         * @returns Tier period, or 0 if no tier is fine enough (i.e. raw samples are needed)
+         */
+        int64_t selectPeriod(int64_t resolution) const;
+
+        /**
+         * @brief Get aggregates of a given tier
+         *
+         * @param [in] sensorID     Sensor to get aggregates for
+         * @param [in] period       Tier period, as returned by selectPeriod()
+         * @param [in] since        Unix timestamp; buckets ending before it are skipped
+         *
+         * @returns Aggregates ordered by bucket start time
+         */
+        std::map<int64_t, ClimateAggregate> get(const std::string& sensorID, int64_t period, int64_t since = 0) const;
+
+        //==============================================================================
+        static constexpr int64_t HOUR = 3600;
+        static constexpr int64_t DAY = 24 * HOUR;
+
+
+    private:
+        //==============================================================================
+        struct Tier
+        {
+            int64_t period;
+
+            /// Aggregates by sensor, then by bucket start time
+            std::map<std::string, std::map<int64_t, ClimateAggregate>> buckets;
+
+            /// End of last persisted bucket, by sensor
+            std::map<std::string, int64_t> persistedUntil;
+
+            int64_t bucketStart(int64_t time) const;
+
+            /// Get time before which a sensor's samples are ignored (min. value if none were persisted)
+            int64_t getPersistedUntil(const std::string& sensorID) const;
+        };
+
+        /// Find tier with given period (NB: mutex must be held)
+        Tier& getTier(int64_t period);
+        const Tier& getTier(int64_t period) const;
+
+        mutable std::shared_mutex _mutex;
+
+        /// Tiers ordered by increasing period
+        std::vector<Tier> _tiers;
+    };
+
+} // namespace beewatch
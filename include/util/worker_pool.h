@@ -0,0 +1,141 @@
+//==============================================================================
+// Copyright (c) 2018 Eric Seguin, all rights reserved.
+//==============================================================================
+
+#pragma once
+
+#include "util/patterns.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace beewatch
+{
+
+    //==============================================================================
+    /**
+     * @class WorkerPool
+     *
+     * Fixed number of worker threads draining a bounded queue of tasks.
+     *
+     * Submitting never blocks: once the queue is full, tasks are refused so callers
+     * can shed load. Tasks which waited longer than their timeout are not run; their
+     * expiry function is called instead, e.g. to tell a client to retry later.
+     */
+    class WorkerPool : public unique_ownership_t<WorkerPool>
+    {
+    public:
+        //==============================================================================
+        using Task = std::function<void()>;
+
+        /**
+         * @struct Stats
+         *
+         * Snapshot of queue depth, throughput & latency
+         */
+        struct Stats
+        {
+            size_t numWorkers = 0;
+            size_t capacity = 0;
+
+            /// Tasks waiting for a worker, and tasks being run
+            size_t queued = 0;
+            size_t running = 0;
+
+            uint64_t completed = 0;
+            uint64_t rejected = 0;
+            uint64_t expired = 0;
+
+            /// Time spent in queue by tasks taken by a worker, in milliseconds
+            double meanWaitMs = 0.0;
+            double maxWaitMs = 0.0;
+        };
+
+        //==============================================================================
+        /**
+         * @brief Construct pool and start its workers
+         *
+         * @param [in] numWorkers   Number of worker threads
+         * @param [in] capacity     Maximum number of queued tasks
+         *
+         * @throws std::invalid_argument if either value is zero
+         */
+        WorkerPool(size_t numWorkers = DEFAULT_NUM_WORKERS, size_t capacity = DEFAULT_CAPACITY);
+
+        /**
+         * @brief Run remaining tasks and stop workers
+         */
+        ~WorkerPool();
+
+        //==============================================================================
+        /**
+         * @brief Queue task for a worker
+         *
+         * @param [in] task         Task to run
+         * @param [in] timeout      Maximum time the task may wait in queue
+         * @param [in] onExpired    Function called instead of the task once it waited too long
+         *
+         * @returns False if the queue is full, in which case the task is dropped
+         */
+        bool submit(Task task,
+                    std::chrono::milliseconds timeout = std::chrono::milliseconds::max(),
+                    Task onExpired = nullptr);
+
+        /// Get current queue depth & statistics since construction
+        Stats getStats() const;
+
+        //==============================================================================
+        static constexpr size_t DEFAULT_NUM_WORKERS = 4;
+        static constexpr size_t DEFAULT_CAPACITY = 64;
+
+
+    private:
+        //==============================================================================
+        /**
+         * @brief Worker thread: runs queued tasks until the pool is destroyed
+         */
+        void workerLoop();
+
+        //==============================================================================
+        struct QueuedTask
+        {
+            Task task;
+            Task onExpired;
+
+            std::chrono::steady_clock::time_point queuedTime;
+            std::chrono::steady_clock::time_point deadline;
+        };
+
+        const size_t _capacity;
+
+        std::deque<QueuedTask> _queue;
+
+        mutable std::mutex _mutex;
+        std::condition_variable _wakeCondition;
+
+        bool _stop;
+
+        //==============================================================================
+        // Statistics (guarded by mutex)
+        size_t _running;
+
+        uint64_t _completed;
+        uint64_t _rejected;
+        uint64_t _expired;
+
+        uint64_t _numWaits;
+        double _totalWaitMs;
+        double _maxWaitMs;
+
+        //==============================================================================
+        std::vector<std::thread> _workers;
+    };
+
+} // namespace beewatch
@@ -0,0 +1,475 @@
+//==============================================================================
+// Copyright (c) 2018 Eric Seguin, all rights reserved.
+//==============================================================================
+
+#include "external/gpioChip.h"
+
+#include "global/logging.h"
+#include "global/time.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#ifdef HAS_GPIOCHIP_V2
+#include <fcntl.h>
+#include <linux/gpio.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <time.h>
+#include <unistd.h>
+#else
+#ifdef __linux__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#else
+#pragma warning(push)
+#pragma warning(disable: 4100)
+#endif
+#endif
+
+namespace beewatch::external
+{
+
+    //==============================================================================
+    constexpr uint32_t GpioChip::EVENT_BUFFER_SIZE;
+    constexpr size_t GpioChip::EVENT_BATCH_SIZE;
+
+    // Values exposed through the wiringPi interface: only inputs & outputs exist on the character device
+    enum : int { VALUE_LOW, VALUE_HIGH };
+    enum : int { MODE_INPUT, MODE_OUTPUT, MODE_PWM_TONE_OUTPUT, MODE_GPIO_CLOCK };
+    enum : int { PWM_MS, PWM_BAL };
+    enum : int { PUD_OFF, PUD_UP, PUD_DOWN };
+    enum : int { EDGE_NONE, EDGE_RISING, EDGE_FALLING, EDGE_BOTH };
+
+    //==============================================================================
+    GpioChip::GpioChip(const std::string& path)
+        : IWiringPi(VALUE_LOW, VALUE_HIGH,
+                    MODE_INPUT, MODE_OUTPUT, MODE_PWM_TONE_OUTPUT, MODE_GPIO_CLOCK,
+                    PWM_MS, PWM_BAL,
+                    PUD_OFF, PUD_UP, PUD_DOWN,
+                    EDGE_NONE, EDGE_RISING, EDGE_FALLING, EDGE_BOTH),
+          _path(path), _chipFd(-1), _numLines(0), _wakeFds{ -1, -1 }, _stop(false)
+    {
+#ifdef HAS_GPIOCHIP_V2
+        _chipFd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+
+        if (_chipFd < 0)
+        {
+            throw std::runtime_error("Failed to open GPIO chip \"" + path + "\": " + std::strerror(errno));
+        }
+
+        gpiochip_info info;
+        std::memset(&info, 0, sizeof(info));
+
+        if (::ioctl(_chipFd, GPIO_GET_CHIPINFO_IOCTL, &info) < 0)
+        {
+            ::close(_chipFd);
+            throw std::runtime_error("\"" + path + "\" is not a GPIO chip: " + std::strerror(errno));
+        }
+
+        _numLines = info.lines;
+
+        if (::pipe2(_wakeFds, O_CLOEXEC | O_NONBLOCK) < 0)
+        {
+            ::close(_chipFd);
+            throw std::runtime_error("Failed to create GPIO event pipe: " + std::string(std::strerror(errno)));
+        }
+
+        _eventThread = std::thread(&GpioChip::eventLoop, this);
+
+        g_logger.info("Using GPIO chip \"" + std::string(info.label) + "\" (" + std::to_string(_numLines) + " lines)");
+#else
+        throw std::runtime_error("GPIO character device unavailable: built without the v2 uAPI (Linux 5.10+ headers)");
+#endif
+    }
+
+    GpioChip::~GpioChip()
+    {
+#ifdef HAS_GPIOCHIP_V2
+        _stop = true;
+        wakeEventLoop();
+
+        if (_eventThread.joinable())
+        {
+            _eventThread.join();
+        }
+
+        // Releasing line requests resets the lines
+        for (auto& line : _lines)
+        {
+            if (line.second.fd >= 0)
+                ::close(line.second.fd);
+        }
+
+        ::close(_wakeFds[0]);
+        ::close(_wakeFds[1]);
+        ::close(_chipFd);
+#endif
+    }
+
+    //==============================================================================
+    std::shared_ptr<IWiringPi> GpioChip::getInstance()
+    {
+        static std::shared_ptr<IWiringPi> instance = std::make_shared<GpioChip>();
+
+        return instance;
+    }
+
+    //==============================================================================
+    int GpioChip::digitalRead(int pin)
+    {
+#ifdef HAS_GPIOCHIP_V2
+        std::lock_guard<std::mutex> lock(_linesMutex);
+
+        auto& line = getLine(pin);
+
+        if (line.fd < 0 && !configure(pin, line))
+        {
+            return -1;
+        }
+
+        gpio_v2_line_values values;
+        values.bits = 0;
+        values.mask = 1;
+
+        if (::ioctl(line.fd, GPIO_V2_LINE_GET_VALUES_IOCTL, &values) < 0)
+        {
+            g_logger.error("Failed to read GPIO" + std::to_string(pin) + ": " + std::strerror(errno));
+            return -1;
+        }
+
+        return (values.bits & 1) ? VALUE_HIGH : VALUE_LOW;
+#else
+        return -1;
+#endif
+    }
+
+    void GpioChip::digitalWrite(int pin, int value)
+    {
+#ifdef HAS_GPIOCHIP_V2
+        std::lock_guard<std::mutex> lock(_linesMutex);
+
+        auto& line = getLine(pin);
+        line.value = value;
+
+        // Inputs hold on to the value until they become outputs
+        if (line.fd < 0 || line.mode != MODE_OUTPUT)
+        {
+            return;
+        }
+
+        gpio_v2_line_values values;
+        values.bits = value == VALUE_HIGH ? 1 : 0;
+        values.mask = 1;
+
+        if (::ioctl(line.fd, GPIO_V2_LINE_SET_VALUES_IOCTL, &values) < 0)
+        {
+            g_logger.error("Failed to write GPIO" + std::to_string(pin) + ": " + std::strerror(errno));
+        }
+#endif
+    }
+
+    void GpioChip::pwmWrite(int, int)
+    {
+        warnUnsupported();
+    }
+
+    //==============================================================================
+    void GpioChip::pinMode(int pin, int mode)
+    {
+        if (mode != MODE_INPUT && mode != MODE_OUTPUT)
+        {
+            warnUnsupported();
+            return;
+        }
+
+#ifdef HAS_GPIOCHIP_V2
+        std::lock_guard<std::mutex> lock(_linesMutex);
+
+        auto& line = getLine(pin);
+        line.mode = mode;
+
+        configure(pin, line);
+#endif
+    }
+
+    void GpioChip::pullUpDnControl(int pin, int pud)
+    {
+#ifdef HAS_GPIOCHIP_V2
+        std::lock_guard<std::mutex> lock(_linesMutex);
+
+        auto& line = getLine(pin);
+        line.pud = pud;
+
+        configure(pin, line);
+#endif
+    }
+
+    void GpioChip::pwmSetMode(int)
+    {
+        warnUnsupported();
+    }
+
+    void GpioChip::pwmSetRange(unsigned int)
+    {
+        warnUnsupported();
+    }
+
+    void GpioChip::pwmSetClock(int)
+    {
+        warnUnsupported();
+    }
+
+    //==============================================================================
+    int GpioChip::setISR(int pin, int edgeType, void(*function)(void))
+    {
+        return setISRs(pin, edgeType, function, nullptr);
+    }
+
+    int GpioChip::setTimestampedISR(int pin, int edgeType, TimestampedISR function)
+    {
+        return setISRs(pin, edgeType, nullptr, function);
+    }
+
+    int GpioChip::setISRs(int pin, int edgeType, void (*isr)(void), TimestampedISR timestampedISR)
+    {
+#ifdef HAS_GPIOCHIP_V2
+        std::lock_guard<std::mutex> lock(_linesMutex);
+
+        auto& line = getLine(pin);
+
+        line.edgeType = edgeType;
+        line.isr = isr;
+        line.timestampedISR = timestampedISR;
+
+        return configure(pin, line) ? 0 : -1;
+#else
+        return -1;
+#endif
+    }
+
+    void GpioChip::warnUnsupported()
+    {
+        static std::once_flag warned;
+
+        std::call_once(warned, []() {
+                g_logger.warning("PWM & clock outputs aren't supported by the GPIO character device, ignoring");
+            });
+    }
+
+    //==============================================================================
+    GpioChip::Line& GpioChip::getLine(int pin)
+    {
+        auto it = _lines.find(pin);
+
+        if (it == _lines.end())
+        {
+            Line line;
+
+            line.mode = MODE_INPUT;
+            line.value = VALUE_LOW;
+            line.edgeType = EDGE_NONE;
+
+            it = _lines.emplace(pin, line).first;
+        }
+
+        return it->second;
+    }
+
+    bool GpioChip::configure(int pin, Line& line)
+    {
+#ifdef HAS_GPIOCHIP_V2
+        if (pin < 0 || (uint32_t)pin >= _numLines)
+        {
+            g_logger.error("GPIO" + std::to_string(pin) + " doesn't exist on \"" + _path + "\"");
+            return false;
+        }
+
+        gpio_v2_line_config config;
+        std::memset(&config, 0, sizeof(config));
+
+        if (line.mode == MODE_OUTPUT)
+        {
+            // Edges can only be detected on inputs: they resume once the line is an input again
+            config.flags = GPIO_V2_LINE_FLAG_OUTPUT;
+
+            config.num_attrs = 1;
+            config.attrs[0].attr.id = GPIO_V2_LINE_ATTR_ID_OUTPUT_VALUES;
+            config.attrs[0].attr.values = line.value == VALUE_HIGH ? 1 : 0;
+            config.attrs[0].mask = 1;
+        }
+        else
+        {
+            config.flags = GPIO_V2_LINE_FLAG_INPUT;
+
+            if (line.edgeType == EDGE_RISING || line.edgeType == EDGE_BOTH)
+                config.flags |= GPIO_V2_LINE_FLAG_EDGE_RISING;
+
+            if (line.edgeType == EDGE_FALLING || line.edgeType == EDGE_BOTH)
+                config.flags |= GPIO_V2_LINE_FLAG_EDGE_FALLING;
+        }
+
+        if (line.pud == PUD_UP)
+            config.flags |= GPIO_V2_LINE_FLAG_BIAS_PULL_UP;
+        else if (line.pud == PUD_DOWN)
+            config.flags |= GPIO_V2_LINE_FLAG_BIAS_PULL_DOWN;
+        else if (line.pud == PUD_OFF)
+            config.flags |= GPIO_V2_LINE_FLAG_BIAS_DISABLED;
+
+        // Lines already requested are reconfigured in place, so outputs don't glitch
+        if (line.fd >= 0)
+        {
+            if (::ioctl(line.fd, GPIO_V2_LINE_SET_CONFIG_IOCTL, &config) < 0)
+            {
+                g_logger.error("Failed to configure GPIO" + std::to_string(pin) + ": " + std::strerror(errno));
+                return false;
+            }
+
+            return true;
+        }
+
+        gpio_v2_line_request request;
+        std::memset(&request, 0, sizeof(request));
+
+        request.offsets[0] = (uint32_t)pin;
+        request.num_lines = 1;
+        request.config = config;
+        request.event_buffer_size = EVENT_BUFFER_SIZE;
+
+        std::strncpy(request.consumer, "beewatch", sizeof(request.consumer) - 1);
+
+        if (::ioctl(_chipFd, GPIO_V2_GET_LINE_IOCTL, &request) < 0)
+        {
+            g_logger.error("Failed to request GPIO" + std::to_string(pin) + ": " + std::strerror(errno));
+            return false;
+        }
+
+        line.fd = request.fd;
+
+        // Event thread must poll the new line
+        wakeEventLoop();
+
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    //==============================================================================
+    void GpioChip::eventLoop()
+    {
+#ifdef HAS_GPIOCHIP_V2
+        std::vector<pollfd> fds;
+        std::vector<int> pins;
+
+        gpio_v2_line_event events[EVENT_BATCH_SIZE];
+
+        while (!_stop)
+        {
+            // Poll wake pipe, then every requested line
+            fds.assign(1, { _wakeFds[0], POLLIN, 0 });
+            pins.assign(1, -1);
+
+            {
+                std::lock_guard<std::mutex> lock(_linesMutex);
+
+                for (const auto& line : _lines)
+                {
+                    if (line.second.fd >= 0)
+                    {
+                        fds.push_back({ line.second.fd, POLLIN, 0 });
+                        pins.push_back(line.first);
+                    }
+                }
+            }
+
+            if (::poll(fds.data(), fds.size(), -1) < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+
+                g_logger.error("Failed to poll GPIO events: " + std::string(std::strerror(errno)));
+                return;
+            }
+
+            if (fds[0].revents & POLLIN)
+            {
+                char drain[64];
+                while (::read(_wakeFds[0], drain, sizeof(drain)) > 0);
+
+                continue;
+            }
+
+            for (size_t i = 1; i < fds.size(); ++i)
+            {
+                if (!(fds[i].revents & POLLIN))
+                    continue;
+
+                ssize_t numBytes = ::read(fds[i].fd, events, sizeof(events));
+
+                if (numBytes <= 0)
+                    continue;
+
+                // Kernel timestamps events on CLOCK_MONOTONIC: carry their age over to g_timeRaw
+                timespec now;
+                clock_gettime(CLOCK_MONOTONIC, &now);
+
+                double rawNowMs = g_timeRaw.now();
+                int64_t nowNs = (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+
+                void (*isr)(void);
+                TimestampedISR timestampedISR;
+
+                {
+                    std::lock_guard<std::mutex> lock(_linesMutex);
+
+                    const auto& line = _lines.at(pins[i]);
+
+                    isr = line.isr;
+                    timestampedISR = line.timestampedISR;
+                }
+
+                size_t numEvents = (size_t)numBytes / sizeof(events[0]);
+
+                for (size_t j = 0; j < numEvents; ++j)
+                {
+                    if (timestampedISR)
+                    {
+                        int value = events[j].id == GPIO_V2_LINE_EVENT_RISING_EDGE ? VALUE_HIGH : VALUE_LOW;
+                        double ageMs = (nowNs - (int64_t)events[j].timestamp_ns) / 1e6;
+
+                        timestampedISR(pins[i], value, rawNowMs - ageMs);
+                    }
+                    else if (isr)
+                    {
+                        isr();
+                    }
+                }
+            }
+        }
+#endif
+    }
+
+    void GpioChip::wakeEventLoop()
+    {
+#ifdef HAS_GPIOCHIP_V2
+        char wake = 1;
+
+        if (::write(_wakeFds[1], &wake, 1) < 0 && errno != EAGAIN)
+        {
+            g_logger.error("Failed to wake GPIO event thread: " + std::string(std::strerror(errno)));
+        }
+#endif
+    }
+
+} // namespace beewatch::external
+
+#ifndef HAS_GPIOCHIP_V2
+#ifdef __linux__
+#pragma GCC diagnostic pop
+#else
+#pragma warning(pop)
+#endif
+#endif
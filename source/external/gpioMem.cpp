@@ -0,0 +1,196 @@
+//==============================================================================
+// Copyright (c) 2018 Eric Seguin, all rights reserved.
+//==============================================================================
+
+#include "external/gpioMem.h"
+
+#include "global/logging.h"
+#include "global/time.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace beewatch::external
+{
+
+    //==============================================================================
+    constexpr size_t GpioMem::BLOCK_SIZE;
+
+    constexpr size_t GpioMem::GPFSEL0;
+    constexpr size_t GpioMem::GPSET0;
+    constexpr size_t GpioMem::GPCLR0;
+    constexpr size_t GpioMem::GPLEV0;
+    constexpr size_t GpioMem::GPPUD;
+    constexpr size_t GpioMem::GPPUDCLK0;
+
+    // Values exposed through the wiringPi interface: modes & pulls match their register encodings
+    enum : int { VALUE_LOW, VALUE_HIGH };
+    enum : int { MODE_INPUT, MODE_OUTPUT, MODE_PWM_TONE_OUTPUT = 0x10, MODE_GPIO_CLOCK };
+    enum : int { PWM_MS, PWM_BAL };
+    enum : int { PUD_OFF, PUD_DOWN, PUD_UP };
+    enum : int { EDGE_NONE, EDGE_RISING, EDGE_FALLING, EDGE_BOTH };
+
+    /// Pins of the first bank, which set/clear/level masks cover
+    static constexpr int NUM_PINS = 32;
+
+    //==============================================================================
+    GpioMem::GpioMem(const std::string& path)
+        : IWiringPi(VALUE_LOW, VALUE_HIGH,
+                    MODE_INPUT, MODE_OUTPUT, MODE_PWM_TONE_OUTPUT, MODE_GPIO_CLOCK,
+                    PWM_MS, PWM_BAL,
+                    PUD_OFF, PUD_UP, PUD_DOWN,
+                    EDGE_NONE, EDGE_RISING, EDGE_FALLING, EDGE_BOTH),
+          _registers(nullptr)
+    {
+        int fd = ::open(path.c_str(), O_RDWR | O_SYNC | O_CLOEXEC);
+
+        if (fd < 0)
+        {
+            throw std::runtime_error("Failed to open GPIO registers \"" + path + "\": " + std::strerror(errno));
+        }
+
+        // Fake register files must hold the whole block, or accesses past their end would fault
+        struct stat info;
+
+        if (::fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && (size_t)info.st_size < BLOCK_SIZE)
+        {
+            ::close(fd);
+            throw std::runtime_error("Register file \"" + path + "\" is smaller than a register block");
+        }
+
+        void* block = ::mmap(nullptr, BLOCK_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+        // Mapping outlives the file descriptor
+        ::close(fd);
+
+        if (block == MAP_FAILED)
+        {
+            throw std::runtime_error("Failed to map GPIO registers \"" + path + "\": " + std::strerror(errno));
+        }
+
+        _registers = static_cast<volatile uint32_t*>(block);
+    }
+
+    GpioMem::~GpioMem()
+    {
+        ::munmap(const_cast<uint32_t*>(_registers), BLOCK_SIZE);
+    }
+
+    //==============================================================================
+    std::shared_ptr<IWiringPi> GpioMem::getInstance()
+    {
+        static std::shared_ptr<IWiringPi> instance = std::make_shared<GpioMem>();
+
+        return instance;
+    }
+
+    //==============================================================================
+    int GpioMem::digitalRead(int pin)
+    {
+        if (pin < 0 || pin >= NUM_PINS)
+        {
+            return -1;
+        }
+
+        return (level() >> pin) & 1 ? VALUE_HIGH : VALUE_LOW;
+    }
+
+    void GpioMem::digitalWrite(int pin, int value)
+    {
+        if (pin < 0 || pin >= NUM_PINS)
+        {
+            return;
+        }
+
+        if (value == VALUE_HIGH)
+            set(1u << pin);
+        else
+            clear(1u << pin);
+    }
+
+    void GpioMem::pwmWrite(int, int)
+    {
+        warnUnsupported();
+    }
+
+    //==============================================================================
+    void GpioMem::pinMode(int pin, int mode)
+    {
+        if (pin < 0 || pin >= NUM_PINS)
+        {
+            return;
+        }
+
+        if (mode != MODE_INPUT && mode != MODE_OUTPUT)
+        {
+            warnUnsupported();
+            return;
+        }
+
+        // Each function select register holds 3 bits for each of 10 pins (NB: not atomic, see GPIO)
+        volatile uint32_t& functionSelect = _registers[GPFSEL0 + pin / 10];
+        int shift = 3 * (pin % 10);
+
+        functionSelect = (functionSelect & ~(7u << shift)) | ((uint32_t)mode << shift);
+    }
+
+    void GpioMem::pullUpDnControl(int pin, int pud)
+    {
+        if (pin < 0 || pin >= NUM_PINS)
+        {
+            return;
+        }
+
+        /**
+         * Set control signal, clock it into the pin, then remove both
+         * (each step must be held for at least 150 cycles)
+         */
+        _registers[GPPUD] = (uint32_t)pud;
+        g_timeRaw.wait(5e-3);
+
+        _registers[GPPUDCLK0] = 1u << pin;
+        g_timeRaw.wait(5e-3);
+
+        _registers[GPPUD] = 0;
+        _registers[GPPUDCLK0] = 0;
+    }
+
+    void GpioMem::pwmSetMode(int)
+    {
+        warnUnsupported();
+    }
+
+    void GpioMem::pwmSetRange(unsigned int)
+    {
+        warnUnsupported();
+    }
+
+    void GpioMem::pwmSetClock(int)
+    {
+        warnUnsupported();
+    }
+
+    //==============================================================================
+    int GpioMem::setISR(int, int, void(*)(void))
+    {
+        // Edges are only reported through interrupts
+        return -1;
+    }
+
+    void GpioMem::warnUnsupported()
+    {
+        static std::once_flag warned;
+
+        std::call_once(warned, []() {
+                g_logger.warning("PWM & clock outputs aren't supported through GPIO registers, ignoring");
+            });
+    }
+
+} // namespace beewatch::external
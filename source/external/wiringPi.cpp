@@ -60,6 +60,11 @@ namespace beewatch::external
     {
     }
 
+    int IWiringPi::setTimestampedISR(int, int, TimestampedISR)
+    {
+        return -1;
+    }
+
     //==============================================================================
     WiringPi::WiringPi()
         : IWiringPi(LOW, HIGH,
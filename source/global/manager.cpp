@@ -4,14 +4,18 @@
 
 #include "global/manager.h"
 
+#include "external/gpioChip.h"
+#include "external/gpioMem.h"
 #include "global/logging.h"
 #include "global/time.hpp"
 #include "util/string.h"
 
 #include <algorithm>
 #include <chrono>
+#include <future>
 #include <iomanip>
 #include <iostream>
+#include <iterator>
 #include <set>
 #include <sstream>
 
@@ -93,11 +97,8 @@ namespace beewatch
 
     //==============================================================================
     Manager::Manager()
+        : _climateGeneration(0), _broadcaster(std::make_unique<ClimateBroadcaster>())
     {
-        // Initialise DHT11
-        // TODO: Support a dynamic configuration eventually
-        _climateSensors["interior"] = std::make_unique<hw::DHTxx>(hw::DHTxx::Type::DHT22, io::GPIO::claim(14));
-        _climateSensors["exterior"] = std::make_unique<hw::DHTxx>(hw::DHTxx::Type::DHT22, io::GPIO::claim(16));
     }
 
     //==============================================================================
@@ -112,6 +113,30 @@ namespace beewatch
                 'r'
             },
 
+            Argument {
+                "compression-level",
+                "gzip/deflate level of REST API responses, 1-9 or 0 to disable (default: 6)",
+                "level"
+            },
+
+            Argument {
+                "http-workers",
+                "Number of threads answering REST API requests to the DB (default: 4)",
+                "count"
+            },
+
+            Argument {
+                "db-backend",
+                "Climate data store, postgres or embedded (default: postgres)",
+                "backend"
+            },
+
+            Argument {
+                "db-path",
+                "Directory holding the embedded store (default: /var/lib/beewatch)",
+                "path"
+            },
+
             Argument {
                 "db-host",
                 "MongoDB host (default: 127.0.0.1)",
@@ -132,6 +157,18 @@ namespace beewatch
                 "db name"
             },
 
+            Argument {
+                "gpio-backend",
+                "GPIO access, wiringpi, gpiochip or gpiomem (no PWM; no edges on gpiomem) (default: wiringpi)",
+                "backend"
+            },
+
+            Argument {
+                "dht-read-mode",
+                "How DHT transfers are timed, polling or edges (not on gpiomem) (default: polling)",
+                "mode"
+            },
+
             Argument {
                 "debug",
                 "Enable debug logging (default: off)",
@@ -155,11 +192,19 @@ namespace beewatch
 
         // Defaults
         int restPort = http::Server::DEFAULT_PORT;
+        int compressionLevel = http::Server::DEFAULT_COMPRESSION_LEVEL;
+        int numWorkers = (int)http::Server::DEFAULT_NUM_WORKERS;
 
         std::string dbName = DB::DEFAULT_NAME;
         std::string dbHost = DB::DEFAULT_HOST;
         int dbPort = DB::DEFAULT_PORT;
 
+        std::string dbBackend = "postgres";
+        std::string dbPath = EmbeddedDB::DEFAULT_PATH;
+
+        std::string gpioBackend = "wiringpi";
+        std::string dhtReadMode = "polling";
+
         // Parse args
         const auto& knownArgs = getKnownArgs();
 
@@ -200,6 +245,99 @@ namespace beewatch
                     exit(-1);
                 }
             }
+            else if (*match == "--compression-level")
+            {
+                if (i+1 < argc && argv[i+1][0] != '-')
+                {
+                    try
+                    {
+                        compressionLevel = std::stoi(argv[++i]);
+                    }
+                    catch (const std::exception& e)
+                    {
+                        compressionLevel = -1;
+                    }
+
+                    if (compressionLevel < 0 || compressionLevel > 9)
+                    {
+                        std::cerr << "Received invalid option for \"" << arg << "\": \""
+                                  << argv[i] << "\"" << std::endl;
+
+                        printUsage();
+                        exit(-1);
+                    }
+                }
+                else
+                {
+                    std::cerr << "Expected " << match->expectedArg << " after \"" << arg << "\"" << std::endl;
+                    printUsage();
+                    exit(-1);
+                }
+            }
+            else if (*match == "--http-workers")
+            {
+                if (i+1 < argc && argv[i+1][0] != '-')
+                {
+                    try
+                    {
+                        numWorkers = std::stoi(argv[++i]);
+                    }
+                    catch (const std::exception& e)
+                    {
+                        numWorkers = -1;
+                    }
+
+                    if (numWorkers < 1)
+                    {
+                        std::cerr << "Received invalid option for \"" << arg << "\": \""
+                                  << argv[i] << "\"" << std::endl;
+
+                        printUsage();
+                        exit(-1);
+                    }
+                }
+                else
+                {
+                    std::cerr << "Expected " << match->expectedArg << " after \"" << arg << "\"" << std::endl;
+                    printUsage();
+                    exit(-1);
+                }
+            }
+            else if (*match == "--db-backend")
+            {
+                if (i+1 < argc && argv[i+1][0] != '-')
+                {
+                    dbBackend = argv[++i];
+
+                    if (dbBackend != "postgres" && dbBackend != "embedded")
+                    {
+                        std::cerr << "Received invalid option for \"" << arg << "\": \""
+                                  << argv[i] << "\"" << std::endl;
+
+                        printUsage();
+                        exit(-1);
+                    }
+                }
+                else
+                {
+                    std::cerr << "Expected " << match->expectedArg << " after \"" << arg << "\"" << std::endl;
+                    printUsage();
+                    exit(-1);
+                }
+            }
+            else if (*match == "--db-path")
+            {
+                if (i+1 < argc && argv[i+1][0] != '-')
+                {
+                    dbPath = argv[++i];
+                }
+                else
+                {
+                    std::cerr << "Expected " << match->expectedArg << " after \"" << arg << "\"" << std::endl;
+                    printUsage();
+                    exit(-1);
+                }
+            }
             else if (*match == "--db-host")
             {
                 if (i+1 < argc && argv[i+1][0] != '-')
@@ -250,6 +388,50 @@ namespace beewatch
                     exit(-1);
                 }
             }
+            else if (*match == "--gpio-backend")
+            {
+                if (i+1 < argc && argv[i+1][0] != '-')
+                {
+                    gpioBackend = argv[++i];
+
+                    if (gpioBackend != "wiringpi" && gpioBackend != "gpiochip" && gpioBackend != "gpiomem")
+                    {
+                        std::cerr << "Received invalid option for \"" << arg << "\": \""
+                                  << argv[i] << "\"" << std::endl;
+
+                        printUsage();
+                        exit(-1);
+                    }
+                }
+                else
+                {
+                    std::cerr << "Expected " << match->expectedArg << " after \"" << arg << "\"" << std::endl;
+                    printUsage();
+                    exit(-1);
+                }
+            }
+            else if (*match == "--dht-read-mode")
+            {
+                if (i+1 < argc && argv[i+1][0] != '-')
+                {
+                    dhtReadMode = argv[++i];
+
+                    if (dhtReadMode != "polling" && dhtReadMode != "edges")
+                    {
+                        std::cerr << "Received invalid option for \"" << arg << "\": \""
+                                  << argv[i] << "\"" << std::endl;
+
+                        printUsage();
+                        exit(-1);
+                    }
+                }
+                else
+                {
+                    std::cerr << "Expected " << match->expectedArg << " after \"" << arg << "\"" << std::endl;
+                    printUsage();
+                    exit(-1);
+                }
+            }
             else if (*match == "--debug")
             {
                 g_logger.info("Enabling debug logs");
@@ -262,13 +444,38 @@ namespace beewatch
             }
         }
 
+        // /dev/gpiomem has no interrupts, so edges couldn't be captured
+        if (gpioBackend == "gpiomem" && dhtReadMode == "edges")
+        {
+            std::cerr << "Received invalid option for \"--dht-read-mode\": \"" << dhtReadMode
+                      << "\" (not supported by the \"" << gpioBackend << "\" GPIO backend)" << std::endl;
+
+            printUsage();
+            exit(-1);
+        }
+
         try
         {
-            _apiServer = std::make_unique<http::Server>(*this, restPort);
+            std::shared_ptr<external::IWiringPi> gpio;
+
+            if (gpioBackend == "gpiochip")
+                gpio = external::GpioChip::getInstance();
+            else if (gpioBackend == "gpiomem")
+                gpio = external::GpioMem::getInstance();
+            else
+                gpio = external::WiringPi::getInstance();
+
+            auto readMode = dhtReadMode == "edges" ? hw::DHTxx::ReadMode::EdgeCapture
+                                                   : hw::DHTxx::ReadMode::Polling;
+
+            // Initialise DHT22 sensors
+            // TODO: Support a dynamic configuration eventually
+            _climateSensors["interior"] = std::make_unique<hw::DHTxx>(hw::DHTxx::Type::DHT22, io::GPIO::claim(14, gpio), readMode);
+            _climateSensors["exterior"] = std::make_unique<hw::DHTxx>(hw::DHTxx::Type::DHT22, io::GPIO::claim(16, gpio), readMode);
         }
         catch (const std::exception& e)
         {
-            g_logger.fatal("Caught exception while bringing up API server: " +
+            g_logger.fatal("Caught exception while bringing up climate sensors: " +
                            std::string(e.what()));
 
             exit(-1);
@@ -276,7 +483,10 @@ namespace beewatch
 
         try
         {
-            _db = std::make_unique<DB>(dbName, dbHost, dbPort);
+            if (dbBackend == "embedded")
+                _db = std::make_unique<EmbeddedDB>(dbPath);
+            else
+                _db = std::make_unique<DB>(dbName, dbHost, dbPort);
         }
         catch (const std::exception& e)
         {
@@ -285,6 +495,79 @@ namespace beewatch
 
             exit(-1);
         }
+
+        // Restore persisted rollup tiers, only replaying samples taken since their last closed bucket
+        _rollup = std::make_unique<ClimateRollup>();
+        _recentSamples = std::make_unique<ClimateCache>();
+
+        auto sensorIDs = getClimateSensorIDs();
+
+        for (const auto& sensorID : sensorIDs)
+        {
+            int64_t replaySince = IDB::MAX_TIMESTAMP;
+
+            for (auto period : _rollup->getPeriods())
+            {
+                auto restoredUntil = _rollup->restore(sensorID, period, _db->getClimateAggregates(sensorID, period));
+                replaySince = std::min(replaySince, restoredUntil);
+            }
+
+            _db->visitClimateData(sensorID, std::max<int64_t>(replaySince, 0), [&](const ClimateSeries& batch) {
+                    _rollup->add(sensorID, batch);
+                    return true;
+                });
+        }
+
+        // Buckets closed while the manager was down (or never persisted, e.g. by an older version)
+        persistRollup();
+
+        // Seed watermarks & recent samples with bounded queries, without reading each sensor's history
+        auto watermarks = _db->getClimateWatermarks(sensorIDs);
+
+        for (const auto& latest : _db->getLatestClimateData(sensorIDs, ClimateCache::DEFAULT_CAPACITY))
+        {
+            auto watermark = watermarks.find(latest.first);
+            bool isComplete = watermark != watermarks.end() && latest.second.size() >= watermark->second.count;
+
+            _recentSamples->seed(latest.first, latest.second, isComplete);
+        }
+
+        {
+            std::unique_lock<std::shared_mutex> lock(_watermarkMutex);
+            _watermarks = std::move(watermarks);
+        }
+
+        _ingestQueue = std::make_unique<IngestQueue>([this](const std::vector<ClimateSample>& samples) {
+                // Failed batches are retried by the queue, so nothing may see them until they are stored
+                if (!_db->addClimateData(samples))
+                {
+                    return false;
+                }
+
+                _rollup->add(samples);
+                _recentSamples->add(samples);
+
+                // Only advance watermarks once samples can be read back
+                updateWatermarks(samples);
+
+                persistRollup();
+
+                return true;
+            });
+
+        // The server starts listening as soon as it is constructed, so only bring it
+        // up once everything its requests reach into is in place
+        try
+        {
+            _apiServer = std::make_unique<http::Server>(*this, restPort, compressionLevel, (size_t)numWorkers);
+        }
+        catch (const std::exception& e)
+        {
+            g_logger.fatal("Caught exception while bringing up API server: " +
+                           std::string(e.what()));
+
+            exit(-1);
+        }
     }
 
     void Manager::printUsage()
@@ -345,15 +628,137 @@ namespace beewatch
     }
 
     //==============================================================================
-    std::map<int64_t, ClimateData<double>> Manager::getClimateSamples(std::string sensorID,
-                                                                      int64_t since) const
+    ClimateSeries Manager::getClimateSamples(std::string sensorID, int64_t since) const
     {
+        ClimateSeries series;
+
+        if (_recentSamples->get(sensorID, since, IDB::MAX_TIMESTAMP, 0, series))
+        {
+            return series;
+        }
+
         return _db->getClimateData(sensorID, since);
     }
 
+    std::map<std::string, ClimateSeries> Manager::getClimateSamples(const std::vector<std::string>& sensorIDs,
+                                                                    int64_t since, int64_t until,
+                                                                    size_t limit) const
+    {
+        std::map<std::string, ClimateSeries> data;
+        std::vector<std::string> missedSensorIDs;
+
+        for (const auto& sensorID : sensorIDs)
+        {
+            ClimateSeries series;
+
+            if (!_recentSamples->get(sensorID, since, until, limit, series))
+            {
+                missedSensorIDs.push_back(sensorID);
+            }
+            else if (!series.empty())
+            {
+                data[sensorID] = std::move(series);
+            }
+        }
+
+        // Only sensors whose buffer doesn't reach back far enough go to the DB
+        if (!missedSensorIDs.empty())
+        {
+            auto stored = _db->getClimateData(missedSensorIDs, since, until, limit);
+            data.insert(std::make_move_iterator(stored.begin()), std::make_move_iterator(stored.end()));
+        }
+
+        return data;
+    }
+
+    void Manager::visitClimateSamples(std::string sensorID, int64_t since, const ClimateVisitor& visit) const
+    {
+        _db->visitClimateData(sensorID, since, visit);
+    }
+
+    std::map<int64_t, ClimateAggregate> Manager::getClimateAggregates(std::string sensorID,
+                                                                      int64_t resolution,
+                                                                      int64_t since) const
+    {
+        int64_t period = _rollup->selectPeriod(resolution);
+
+        if (period > 0)
+        {
+            return _rollup->get(sensorID, period, since);
+        }
+
+        // Requested resolution is finer than any tier: wrap raw samples
+        std::map<int64_t, ClimateAggregate> aggregates;
+
+        _db->visitClimateData(sensorID, since, [&](const ClimateSeries& batch) {
+                for (size_t i = 0; i < batch.size(); ++i)
+                {
+                    aggregates[batch.timestamps[i]].add(batch.data(i));
+                }
+
+                return true;
+            });
+
+        return aggregates;
+    }
+
     void Manager::clearClimateData()
     {
+        // Discard pending samples so they don't reappear after the table is dropped
+        _ingestQueue->clear();
         _db->clearClimateData();
+        _rollup->clear();
+        _recentSamples->clear();
+
+        std::unique_lock<std::shared_mutex> lock(_watermarkMutex);
+
+        _watermarks.clear();
+        _climateGeneration++;
+    }
+
+    ClimateWatermark Manager::getClimateWatermark(std::string sensorID) const
+    {
+        std::shared_lock<std::shared_mutex> lock(_watermarkMutex);
+
+        ClimateWatermark watermark;
+
+        auto it = _watermarks.find(sensorID);
+
+        if (it != _watermarks.end())
+        {
+            watermark = it->second;
+        }
+
+        watermark.generation = _climateGeneration;
+
+        return watermark;
+    }
+
+    void Manager::updateWatermarks(const std::vector<ClimateSample>& samples)
+    {
+        std::unique_lock<std::shared_mutex> lock(_watermarkMutex);
+
+        for (const auto& sample : samples)
+        {
+            _watermarks[sample.sensorID].add(sample.timestamp);
+        }
+    }
+
+    void Manager::persistRollup()
+    {
+        // Buckets which fail to be written stay unpersisted, so they are retried on the next call
+        for (const auto& closed : _rollup->getUnpersisted())
+        {
+            if (_db->addClimateAggregates(closed.sensorID, closed.period, closed.buckets))
+            {
+                _rollup->setPersisted(closed.sensorID, closed.period, closed.buckets.rbegin()->first + closed.period);
+            }
+        }
+    }
+
+    ClimateBroadcaster::Subscription::Ptr Manager::subscribeClimateSamples()
+    {
+        return _broadcaster->subscribe();
     }
 
     std::vector<std::string> Manager::getClimateSensorIDs() const
@@ -376,20 +781,30 @@ namespace beewatch
         {
             auto start = std::chrono::steady_clock::now();
 
-            // TODO: Read data on both internal & external sensors
+            // Read all sensors at once: a read takes 10+ s, mostly spent waiting between
+            // samples, so the cycle lasts as long as the slowest sensor however many there are
+            std::map<std::string, std::future<hw::DHTxx::Data>> reads;
+
             for (auto& climateSensor: _climateSensors)
             {
-                auto& id = climateSensor.first;
                 auto& sensor = climateSensor.second;
+                reads[climateSensor.first] = std::async(std::launch::async, [&sensor]() { return sensor->read(); });
+            }
 
-                auto data = sensor->read();
+            for (auto& read: reads)
+            {
+                auto& id = read.first;
+                auto data = read.second.get();
 
                 g_logger.debug("Humidity (" + id + "): " + string::fromNumber(data.humidity) + " %");
                 g_logger.debug("Temperature (" + id + "): " + string::fromNumber(data.temperature) + " deg Celsius");
 
                 if (data.temperature < 60.0 && data.humidity <= 100.0)
                 {
-                _db->addClimateData(id, g_timeReal.toUnix(g_timeReal.now()), data);
+                    ClimateSample sample = { id, g_timeReal.toUnix(g_timeReal.now()), data };
+
+                    _broadcaster->publish(sample);
+                    _ingestQueue->push(std::move(sample));
                 }
                 else
                 {
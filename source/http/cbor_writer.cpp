@@ -0,0 +1,268 @@
+//==============================================================================
+// Copyright (c) 2018 Eric Seguin, all rights reserved.
+//==============================================================================
+
+#include "http/cbor_writer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace beewatch::http
+{
+
+    //==============================================================================
+    // CBOR major types
+    static constexpr uint8_t c_unsigned = 0;
+    static constexpr uint8_t c_negative = 1;
+    static constexpr uint8_t c_byteString = 2;
+    static constexpr uint8_t c_textString = 3;
+    static constexpr uint8_t c_map = 5;
+    static constexpr uint8_t c_tag = 6;
+
+    static constexpr uint8_t c_indefinite = 0x1f;
+    static constexpr uint8_t c_break = 0xff;
+    static constexpr uint8_t c_float64 = 0xfb;
+
+    //==============================================================================
+    constexpr size_t CborWriter::DEFAULT_CHUNK_SIZE;
+    constexpr uint64_t CborWriter::TAG_INT64_LE;
+    constexpr uint64_t CborWriter::TAG_UINT32_LE;
+    constexpr uint64_t CborWriter::TAG_FLOAT32_LE;
+
+    //==============================================================================
+    CborWriter::CborWriter(Sink sink, size_t chunkSize)
+        : _sink(sink), _buffer(std::max<size_t>(chunkSize, 64)), _size(0)
+    {
+        if (!_sink)
+        {
+            throw std::invalid_argument("Received undefined CBOR sink");
+        }
+    }
+
+    //==============================================================================
+    CborWriter& CborWriter::beginMap(size_t size)
+    {
+        writeHead(c_map, size);
+        return *this;
+    }
+
+    CborWriter& CborWriter::beginMap()
+    {
+        put((c_map << 5) | c_indefinite);
+        return *this;
+    }
+
+    CborWriter& CborWriter::end()
+    {
+        put(c_break);
+        return *this;
+    }
+
+    CborWriter& CborWriter::value(const std::string& string)
+    {
+        writeHead(c_textString, string.size());
+        write(string.data(), string.size());
+
+        return *this;
+    }
+
+    CborWriter& CborWriter::value(int64_t number)
+    {
+        // Negative integers are stored as -1 - n
+        if (number < 0)
+            writeHead(c_negative, (uint64_t)(-1 - number));
+        else
+            writeHead(c_unsigned, (uint64_t)number);
+
+        return *this;
+    }
+
+    CborWriter& CborWriter::value(double number)
+    {
+        uint64_t bits;
+        std::memcpy(&bits, &number, sizeof(bits));
+
+        put(c_float64);
+
+        // Big-endian, like all CBOR arguments
+        for (int shift = 56; shift >= 0; shift -= 8)
+            put((uint8_t)(bits >> shift));
+
+        return *this;
+    }
+
+    //==============================================================================
+    CborWriter& CborWriter::int64Array(const std::vector<int64_t>& values)
+    {
+        writeHead(c_tag, TAG_INT64_LE);
+        writeHead(c_byteString, values.size() * sizeof(int64_t));
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        write(reinterpret_cast<const char *>(values.data()), values.size() * sizeof(int64_t));
+#else
+        for (auto value : values)
+            writeLittleEndian((uint64_t)value, sizeof(value));
+#endif
+
+        return *this;
+    }
+
+    CborWriter& CborWriter::uint32Array(const std::vector<uint32_t>& values)
+    {
+        writeHead(c_tag, TAG_UINT32_LE);
+        writeHead(c_byteString, values.size() * sizeof(uint32_t));
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        write(reinterpret_cast<const char *>(values.data()), values.size() * sizeof(uint32_t));
+#else
+        for (auto value : values)
+            writeLittleEndian(value, sizeof(value));
+#endif
+
+        return *this;
+    }
+
+    CborWriter& CborWriter::float32Array(const std::vector<double>& values)
+    {
+        writeHead(c_tag, TAG_FLOAT32_LE);
+        writeHead(c_byteString, values.size() * sizeof(float));
+
+        // Sensor readings have far less precision than a float's 24-bit mantissa
+        for (auto value : values)
+        {
+            float single = (float)value;
+
+            uint32_t bits;
+            std::memcpy(&bits, &single, sizeof(bits));
+
+            writeLittleEndian(bits, sizeof(bits));
+        }
+
+        return *this;
+    }
+
+    //==============================================================================
+    void CborWriter::flush()
+    {
+        if (_size > 0)
+        {
+            _sink(_buffer.data(), _size);
+            _size = 0;
+        }
+    }
+
+    //==============================================================================
+    void CborWriter::writeHead(uint8_t majorType, uint64_t argument)
+    {
+        uint8_t type = majorType << 5;
+
+        if (argument < 24)
+        {
+            put(type | (uint8_t)argument);
+        }
+        else if (argument <= 0xff)
+        {
+            put(type | 24);
+            put((uint8_t)argument);
+        }
+        else
+        {
+            // Additional info 25, 26 & 27 denote 2, 4 & 8 byte big-endian arguments
+            size_t numBytes = argument <= 0xffff ? 2 : argument <= 0xffffffff ? 4 : 8;
+            put(type | (numBytes == 2 ? 25 : numBytes == 4 ? 26 : 27));
+
+            for (size_t i = numBytes; i-- > 0;)
+                put((uint8_t)(argument >> (8 * i)));
+        }
+    }
+
+    void CborWriter::writeLittleEndian(uint64_t bits, size_t numBytes)
+    {
+        if (_buffer.size() - _size >= numBytes)
+        {
+            for (size_t i = 0; i < numBytes; ++i)
+                _buffer[_size++] = (char)(bits >> (8 * i));
+
+            if (_size == _buffer.size())
+                flush();
+        }
+        else
+        {
+            for (size_t i = 0; i < numBytes; ++i)
+                put((uint8_t)(bits >> (8 * i)));
+        }
+    }
+
+    void CborWriter::write(const char * data, size_t size)
+    {
+        while (size > 0)
+        {
+            size_t n = std::min(size, _buffer.size() - _size);
+
+            std::memcpy(_buffer.data() + _size, data, n);
+            _size += n;
+
+            data += n;
+            size -= n;
+
+            if (_size == _buffer.size())
+            {
+                flush();
+            }
+        }
+    }
+
+    void CborWriter::put(uint8_t byte)
+    {
+        _buffer[_size++] = (char)byte;
+
+        if (_size == _buffer.size())
+        {
+            flush();
+        }
+    }
+
+    //==============================================================================
+    void writeClimateSeries(CborWriter& writer, const ClimateSeries& series)
+    {
+        writer.beginMap(3);
+
+        writer.value("timestamps").int64Array(series.timestamps);
+        writer.value("temperature").float32Array(series.temperature);
+        writer.value("humidity").float32Array(series.humidity);
+    }
+
+    void writeClimateAggregates(CborWriter& writer, const std::map<int64_t, ClimateAggregate>& aggregates)
+    {
+        // Aggregates are few, so gather them into columns first
+        ClimateSeries mean, min, max;
+        std::vector<uint32_t> counts;
+
+        for (const auto& aggregate : aggregates)
+        {
+            mean.push_back(aggregate.first, aggregate.second.mean);
+            min.push_back(aggregate.first, aggregate.second.min);
+            max.push_back(aggregate.first, aggregate.second.max);
+
+            counts.push_back(aggregate.second.count);
+        }
+
+        writer.beginMap(6);
+
+        writer.value("timestamps").int64Array(mean.timestamps);
+        writer.value("temperature").float32Array(mean.temperature);
+        writer.value("humidity").float32Array(mean.humidity);
+
+        writer.value("min").beginMap(2);
+        writer.value("temperature").float32Array(min.temperature);
+        writer.value("humidity").float32Array(min.humidity);
+
+        writer.value("max").beginMap(2);
+        writer.value("temperature").float32Array(max.temperature);
+        writer.value("humidity").float32Array(max.humidity);
+
+        writer.value("count").uint32Array(counts);
+    }
+
+} // namespace beewatch::http
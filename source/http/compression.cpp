@@ -0,0 +1,118 @@
+//==============================================================================
+// Copyright (c) 2018 Eric Seguin, all rights reserved.
+//==============================================================================
+
+#include "http/compression.h"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace beewatch::http
+{
+
+    //==============================================================================
+    struct Compressor::Stream
+    {
+        z_stream z;
+    };
+
+    constexpr size_t Compressor::DEFAULT_CHUNK_SIZE;
+
+    //==============================================================================
+    Compressor::Compressor(ContentEncoding encoding, int level, Sink sink, size_t chunkSize)
+        : _stream(std::make_unique<Stream>()), _sink(sink), _buffer(std::max<size_t>(chunkSize, 64)), _finished(false)
+    {
+        if (!_sink)
+        {
+            throw std::invalid_argument("Received undefined compressed output sink");
+        }
+
+        if (level < 1 || level > 9)
+        {
+            throw std::invalid_argument("Received invalid compression level: " + std::to_string(level));
+        }
+
+        // Window bits select the container: +16 for a gzip header & trailer, zlib otherwise
+        int windowBits;
+
+        switch (encoding)
+        {
+            case ContentEncoding::Gzip:     windowBits = 15 + 16; break;
+            case ContentEncoding::Deflate:  windowBits = 15; break;
+
+            default:
+                throw std::invalid_argument("Cannot compress with encoding \"" + toString(encoding) + "\"");
+        }
+
+        _stream->z = z_stream();
+
+        if (deflateInit2(&_stream->z, level, Z_DEFLATED, windowBits, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        {
+            throw std::runtime_error("Failed to initialise zlib stream");
+        }
+    }
+
+    Compressor::~Compressor()
+    {
+        deflateEnd(&_stream->z);
+    }
+
+    //==============================================================================
+    void Compressor::write(const char * data, size_t size)
+    {
+        if (_finished)
+        {
+            throw std::logic_error("Cannot write to finished compressed stream");
+        }
+
+        deflate(data, size, Z_NO_FLUSH);
+    }
+
+    void Compressor::finish()
+    {
+        if (!_finished)
+        {
+            deflate(nullptr, 0, Z_FINISH);
+            _finished = true;
+        }
+    }
+
+    //==============================================================================
+    void Compressor::deflate(const char * data, size_t size, int flush)
+    {
+        auto& z = _stream->z;
+
+        z.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+        z.avail_in = (uInt)size;
+
+        // Run until all input is consumed (and, when finishing, the trailer is written)
+        while (true)
+        {
+            z.next_out = reinterpret_cast<Bytef *>(_buffer.data());
+            z.avail_out = (uInt)_buffer.size();
+
+            int result = ::deflate(&z, flush);
+
+            if (result == Z_STREAM_ERROR)
+            {
+                throw std::runtime_error("Failed to compress data: zlib stream error");
+            }
+
+            size_t produced = _buffer.size() - z.avail_out;
+
+            if (produced > 0)
+            {
+                _sink(_buffer.data(), produced);
+            }
+
+            // Output buffer wasn't filled: zlib has nothing more to give for now
+            if (flush == Z_FINISH ? result == Z_STREAM_END : z.avail_out != 0)
+            {
+                break;
+            }
+        }
+    }
+
+} // namespace beewatch::http
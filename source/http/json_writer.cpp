@@ -0,0 +1,279 @@
+//==============================================================================
+// Copyright (c) 2018 Eric Seguin, all rights reserved.
+//==============================================================================
+
+#include "http/json_writer.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace beewatch::http
+{
+
+    //==============================================================================
+    constexpr size_t JsonWriter::DEFAULT_CHUNK_SIZE;
+
+    //==============================================================================
+    JsonWriter::JsonWriter(Sink sink, size_t chunkSize)
+        : _sink(sink), _buffer(std::max<size_t>(chunkSize, 64)), _size(0), _hasKey(false)
+    {
+        if (!_sink)
+        {
+            throw std::invalid_argument("Received undefined JSON sink");
+        }
+    }
+
+    //==============================================================================
+    JsonWriter& JsonWriter::beginObject()
+    {
+        separate();
+        put('{');
+
+        _isEmpty.push_back(true);
+        return *this;
+    }
+
+    JsonWriter& JsonWriter::endObject()
+    {
+        put('}');
+
+        _isEmpty.pop_back();
+        return *this;
+    }
+
+    JsonWriter& JsonWriter::beginArray()
+    {
+        separate();
+        put('[');
+
+        _isEmpty.push_back(true);
+        return *this;
+    }
+
+    JsonWriter& JsonWriter::endArray()
+    {
+        put(']');
+
+        _isEmpty.pop_back();
+        return *this;
+    }
+
+    JsonWriter& JsonWriter::key(const std::string& name)
+    {
+        value(name);
+        put(':');
+
+        _hasKey = true;
+        return *this;
+    }
+
+    //==============================================================================
+    JsonWriter& JsonWriter::value(double number)
+    {
+        if (!std::isfinite(number))
+        {
+            return null();
+        }
+
+        separate();
+
+        // Enough digits to round-trip any double
+        char digits[32];
+        int length = std::snprintf(digits, sizeof(digits), "%.*g", std::numeric_limits<double>::max_digits10, number);
+
+        write(digits, length);
+        return *this;
+    }
+
+    JsonWriter& JsonWriter::value(int64_t number)
+    {
+        separate();
+
+        char digits[24];
+        auto result = std::to_chars(digits, digits + sizeof(digits), number);
+
+        write(digits, result.ptr - digits);
+        return *this;
+    }
+
+    JsonWriter& JsonWriter::value(const std::string& string)
+    {
+        separate();
+        put('"');
+
+        for (char c : string)
+        {
+            switch (c)
+            {
+                case '"':   write("\\\"", 2); break;
+                case '\\':  write("\\\\", 2); break;
+                case '\b':  write("\\b", 2); break;
+                case '\f':  write("\\f", 2); break;
+                case '\n':  write("\\n", 2); break;
+                case '\r':  write("\\r", 2); break;
+                case '\t':  write("\\t", 2); break;
+
+                default:
+                    if ((unsigned char)c < 0x20)
+                    {
+                        char escaped[8];
+                        std::snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned)c);
+
+                        write(escaped, 6);
+                    }
+                    else
+                    {
+                        put(c);
+                    }
+                    break;
+            }
+        }
+
+        put('"');
+        return *this;
+    }
+
+    JsonWriter& JsonWriter::null()
+    {
+        separate();
+        write("null", 4);
+
+        return *this;
+    }
+
+    //==============================================================================
+    void JsonWriter::flush()
+    {
+        if (_size > 0)
+        {
+            _sink(_buffer.data(), _size);
+            _size = 0;
+        }
+    }
+
+    //==============================================================================
+    void JsonWriter::separate()
+    {
+        // Values following a key are already separated by a colon
+        if (_hasKey)
+        {
+            _hasKey = false;
+            return;
+        }
+
+        if (!_isEmpty.empty())
+        {
+            if (!_isEmpty.back())
+                put(',');
+
+            _isEmpty.back() = false;
+        }
+    }
+
+    void JsonWriter::write(const char * data, size_t size)
+    {
+        while (size > 0)
+        {
+            size_t n = std::min(size, _buffer.size() - _size);
+
+            std::memcpy(_buffer.data() + _size, data, n);
+            _size += n;
+
+            data += n;
+            size -= n;
+
+            if (_size == _buffer.size())
+            {
+                flush();
+            }
+        }
+    }
+
+    void JsonWriter::put(char c)
+    {
+        _buffer[_size++] = c;
+
+        if (_size == _buffer.size())
+        {
+            flush();
+        }
+    }
+
+    //==============================================================================
+    void writeClimateSeries(JsonWriter& writer, const ClimateSeries& series)
+    {
+        writer.beginObject();
+
+        writer.key("timestamps").beginArray();
+
+        for (auto timestamp : series.timestamps)
+        {
+            writer.value(timestamp);
+        }
+
+        writer.endArray();
+
+        writer.key("samples").beginArray();
+
+        for (size_t i = 0; i < series.size(); ++i)
+        {
+            writer.beginObject()
+                  .key("temperature").value(series.temperature[i])
+                  .key("humidity").value(series.humidity[i])
+                  .endObject();
+        }
+
+        writer.endArray();
+
+        writer.endObject();
+    }
+
+    void writeClimateAggregates(JsonWriter& writer, const std::map<int64_t, ClimateAggregate>& aggregates)
+    {
+        writer.beginObject();
+
+        writer.key("timestamps").beginArray();
+
+        for (const auto& aggregate : aggregates)
+        {
+            writer.value(aggregate.first);
+        }
+
+        writer.endArray();
+
+        writer.key("samples").beginArray();
+
+        for (const auto& aggregate : aggregates)
+        {
+            const auto& value = aggregate.second;
+
+            // Mean values keep the raw sample format, with extrema alongside
+            writer.beginObject()
+                  .key("temperature").value(value.mean.temperature)
+                  .key("humidity").value(value.mean.humidity);
+
+            writer.key("min").beginObject()
+                  .key("temperature").value(value.min.temperature)
+                  .key("humidity").value(value.min.humidity)
+                  .endObject();
+
+            writer.key("max").beginObject()
+                  .key("temperature").value(value.max.temperature)
+                  .key("humidity").value(value.max.humidity)
+                  .endObject();
+
+            writer.key("count").value(value.count)
+                  .endObject();
+        }
+
+        writer.endArray();
+
+        writer.endObject();
+    }
+
+} // namespace beewatch::http
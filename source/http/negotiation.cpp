@@ -0,0 +1,167 @@
+//==============================================================================
+// Copyright (c) 2018 Eric Seguin, all rights reserved.
+//==============================================================================
+
+#include "http/negotiation.h"
+
+#include "util/string.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <ctime>
+
+namespace beewatch::http
+{
+
+    //==============================================================================
+    std::map<std::string, double> parseQualityValues(const std::string& header)
+    {
+        std::map<std::string, double> qualities;
+
+        // Comma-separated list of tokens, each with an optional ";q=<quality>"
+        size_t start = 0;
+
+        while (start < header.size())
+        {
+            size_t end = std::min(header.find(',', start), header.size());
+
+            std::string token = string::tolower(header.substr(start, end - start));
+            double quality = 1.0;
+
+            size_t params = token.find(';');
+
+            if (params != std::string::npos)
+            {
+                size_t q = token.find("q=", params);
+
+                if (q != std::string::npos)
+                    quality = std::strtod(token.c_str() + q + 2, nullptr);
+
+                token.erase(params);
+            }
+
+            token.erase(0, token.find_first_not_of(" \t"));
+            token.erase(token.find_last_not_of(" \t") + 1);
+
+            if (!token.empty())
+                qualities[token] = quality;
+
+            start = end + 1;
+        }
+
+        return qualities;
+    }
+
+    /// Get quality of a token, or 0 if not listed
+    static double getQuality(const std::map<std::string, double>& qualities, const std::string& token)
+    {
+        auto it = qualities.find(token);
+        return it != qualities.end() ? it->second : 0.0;
+    }
+
+    //==============================================================================
+    ContentEncoding negotiateEncoding(const std::string& acceptEncoding)
+    {
+        auto qualities = parseQualityValues(acceptEncoding);
+
+        double wildcardQuality = getQuality(qualities, "*");
+
+        double gzipQuality = std::max({ getQuality(qualities, "gzip"), getQuality(qualities, "x-gzip"),
+                                        qualities.count("gzip") ? 0.0 : wildcardQuality });
+
+        double deflateQuality = qualities.count("deflate") ? getQuality(qualities, "deflate") : wildcardQuality;
+
+        if (gzipQuality > 0.0 && gzipQuality >= deflateQuality)
+            return ContentEncoding::Gzip;
+
+        if (deflateQuality > 0.0)
+            return ContentEncoding::Deflate;
+
+        return ContentEncoding::Identity;
+    }
+
+    std::string toString(ContentEncoding encoding)
+    {
+        switch (encoding)
+        {
+            case ContentEncoding::Gzip:     return "gzip";
+            case ContentEncoding::Deflate:  return "deflate";
+            default:                        return "identity";
+        }
+    }
+
+    //==============================================================================
+    MediaType negotiateMediaType(const std::string& accept)
+    {
+        auto qualities = parseQualityValues(accept);
+
+        double cborQuality = getQuality(qualities, toString(MediaType::Cbor));
+
+        double jsonQuality = std::max({ getQuality(qualities, toString(MediaType::Json)),
+                                        getQuality(qualities, "application/*"),
+                                        getQuality(qualities, "*/*") });
+
+        if (cborQuality > 0.0 && cborQuality >= jsonQuality)
+            return MediaType::Cbor;
+
+        return MediaType::Json;
+    }
+
+    std::string toString(MediaType mediaType)
+    {
+        switch (mediaType)
+        {
+            case MediaType::Cbor:   return "application/cbor";
+            default:                return "application/json";
+        }
+    }
+
+    //==============================================================================
+    /// Strip surrounding whitespace & weak indicator from an entity tag
+    static std::string normaliseETag(std::string tag)
+    {
+        tag.erase(0, tag.find_first_not_of(" \t"));
+        tag.erase(tag.find_last_not_of(" \t") + 1);
+
+        if (tag.compare(0, 2, "W/") == 0)
+            tag.erase(0, 2);
+
+        return tag;
+    }
+
+    bool matchesETag(const std::string& ifNoneMatch, const std::string& etag)
+    {
+        auto expected = normaliseETag(etag);
+
+        // Comma-separated list of (possibly weak) entity tags, or "*"
+        size_t start = 0;
+
+        while (start < ifNoneMatch.size())
+        {
+            size_t end = std::min(ifNoneMatch.find(',', start), ifNoneMatch.size());
+
+            auto tag = normaliseETag(ifNoneMatch.substr(start, end - start));
+
+            if (tag == "*" || tag == expected)
+                return true;
+
+            start = end + 1;
+        }
+
+        return false;
+    }
+
+    std::string formatHttpDate(int64_t timestamp)
+    {
+        std::time_t time = (std::time_t)timestamp;
+        std::tm tm;
+
+        gmtime_r(&time, &tm);
+
+        char date[32];
+        std::strftime(date, sizeof(date), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+
+        return date;
+    }
+
+} // namespace beewatch::http
@@ -5,13 +5,25 @@
 #include "http/server.h"
 
 #include "global/logging.h"
+#include "http/cbor_writer.h"
+#include "http/compression.h"
+#include "http/json_writer.h"
+#include "http/negotiation.h"
+#include "util/decimate.h"
 #include "util/file.h"
 #include "util/string.h"
 #include "version.h"
 
 #include <cpprest/http_listener.h>
+#include <cpprest/producerconsumerstream.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
 #include <fstream>
+#include <stdexcept>
+#include <thread>
 
 namespace beewatch::http
 {
@@ -22,15 +34,46 @@ namespace beewatch::http
     using namespace web::json;
 
     //==============================================================================
-    Server::Server(IManager& manager, uint16_t port)
-        : _port(port), _manager(manager), _changingState(false)
+    constexpr int Server::DEFAULT_COMPRESSION_LEVEL;
+    constexpr size_t Server::COMPRESSION_THRESHOLD;
+    constexpr size_t Server::MAX_STREAM_BACKLOG;
+
+    constexpr size_t Server::MAX_STREAMS;
+
+    constexpr size_t Server::DEFAULT_NUM_WORKERS;
+    constexpr size_t Server::QUEUE_CAPACITY;
+    constexpr std::chrono::milliseconds Server::REQUEST_TIMEOUT;
+
+    Server::Server(IManager& manager, uint16_t port, int compressionLevel, size_t numWorkers)
+        : _port(port), _compressionLevel(compressionLevel), _manager(manager),
+          _isListening(false), _numStreams(0), _changingState(false)
     {
+        if (compressionLevel < 0 || compressionLevel > 9)
+        {
+            throw std::invalid_argument("Received invalid compression level: " + std::to_string(compressionLevel));
+        }
+
+        _workers = std::make_unique<WorkerPool>(numWorkers, QUEUE_CAPACITY);
+
+        // Routes hitting the DB or reading a body go to workers, with few concurrent requests
+        // each so a burst of history queries can't take every worker. Others stay inline
+        _routes["GET data/climate"].limit = std::max<size_t>(numWorkers / 2, 1);
+        _routes["DELETE data/climate"].limit = 1;
+        _routes["PUT name"].limit = 1;
+
+        _routes["GET name"];
+        _routes["GET version"];
+        _routes["GET metrics"];
+
         restart();
     }
 
     Server::~Server()
     {
         stop();
+
+        // Wait for requests still being answered, as they use the manager
+        _workers = nullptr;
     }
 
     //==============================================================================
@@ -114,6 +157,346 @@ namespace beewatch::http
         return relative_uri.split_query(relative_uri.query());
     }
 
+    /// Reply 503 Service Unavailable, asking client to retry shortly
+    inline static void replyUnavailable(const http_request& request, const std::string& errMsg)
+    {
+        auto answer = json::value::object();
+        answer["error"] = json::value::string(errMsg);
+
+        http_response response(status_codes::ServiceUnavailable);
+
+        response.headers().add(header_names::retry_after, "1");
+        response.set_body(answer);
+
+        g_logger.warning(errMsg);
+        request.reply(response);
+    }
+
+    /// Reply 500 Internal Server Error, unless a response was already sent
+    inline static void replyInternalError(const http_request& request, const std::string& errMsg)
+    {
+        auto answer = json::value::object();
+        answer["error"] = json::value::string(errMsg);
+
+        g_logger.error(errMsg);
+
+        try
+        {
+            request.reply(status_codes::InternalError, answer);
+        }
+        catch (const std::exception&)
+        {
+            // Response was already (partially) sent, the client will see it cut short
+        }
+    }
+
+    /// Encode where the next page of a time window starts as an opaque cursor
+    inline static std::string encodeCursor(int64_t since, int64_t until)
+    {
+        char cursor[33];
+        std::snprintf(cursor, sizeof(cursor), "%016" PRIx64 "%016" PRIx64, (uint64_t)since, (uint64_t)until);
+
+        return cursor;
+    }
+
+    /// Decode cursor made by encodeCursor(), returning false if it is malformed
+    inline static bool decodeCursor(const std::string& cursor, int64_t& since, int64_t& until)
+    {
+        if (cursor.size() != 32 || cursor.find_first_not_of("0123456789abcdef") != std::string::npos)
+            return false;
+
+        since = (int64_t)std::stoull(cursor.substr(0, 16), nullptr, 16);
+        until = (int64_t)std::stoull(cursor.substr(16), nullptr, 16);
+
+        return since < until;
+    }
+
+    /**
+     * @brief Wait until the client has read a streamed response body down to the given backlog
+     *
+     * @param [in] buffer       Buffer the response body is read from
+     * @param [in] replyTask    Task sending the response, which completes early if the client disconnects
+     * @param [in] maxBacklog   Number of unread bytes to wait for
+     * @param [in] timeout      Time after which a client that stopped reading is deemed gone
+     *
+     * @returns False if the response was abandoned (i.e. the client is gone), true otherwise
+     */
+    static bool waitForClient(const concurrency::streams::producer_consumer_buffer<uint8_t>& buffer,
+                              const pplx::task<void>& replyTask, size_t maxBacklog,
+                              std::chrono::milliseconds timeout)
+    {
+        using namespace std::chrono;
+
+        static constexpr auto c_pollInterval = milliseconds(5);
+
+        auto backlog = buffer.in_avail();
+        auto lastProgressTime = steady_clock::now();
+
+        while (backlog > maxBacklog)
+        {
+            if (replyTask.is_done() || steady_clock::now() - lastProgressTime > timeout)
+                return false;
+
+            std::this_thread::sleep_for(c_pollInterval);
+
+            auto newBacklog = buffer.in_avail();
+
+            if (newBacklog < backlog)
+                lastProgressTime = steady_clock::now();
+
+            backlog = newBacklog;
+        }
+
+        // Body isn't complete yet, so a finished reply means it was abandoned
+        return !replyTask.is_done();
+    }
+
+    /// Receives serialised chunks of a response body
+    using ChunkSink = std::function<void(const char * data, size_t size)>;
+
+    /**
+     * @brief Reply with a body written in chunks as it is serialised
+     *
+     * The body is compressed if the client accepts gzip or deflate, unless the whole
+     * document fits in a single chunk smaller than the compression threshold.
+     *
+     * @param [in] request          Request to reply to
+     * @param [in] response         Response to send, with status & headers already set
+     * @param [in] contentType      MIME type of the body
+     * @param [in] compressionLevel zlib compression level, or 0 to disable compression
+     * @param [in] write            Function writing the whole document to a sink
+     */
+    static void replyStreamed(const http_request& request, http_response response, const std::string& contentType,
+                              int compressionLevel, const std::function<void(const ChunkSink&)>& write)
+    {
+        auto encoding = ContentEncoding::Identity;
+
+        if (compressionLevel > 0)
+        {
+            auto header = request.headers().find(header_names::accept_encoding);
+
+            if (header != request.headers().end())
+                encoding = negotiateEncoding(header->second);
+
+            // Representation depends on Accept-Encoding, even when sent uncompressed
+            auto vary = response.headers().find(header_names::vary);
+
+            if (vary == response.headers().end() || vary->second.find("Accept-Encoding") == std::string::npos)
+                response.headers().add(header_names::vary, "Accept-Encoding");
+        }
+
+        concurrency::streams::producer_consumer_buffer<uint8_t> buffer;
+        pplx::task<void> replyTask;
+        Compressor::Ptr compressor;
+
+        // First chunk is held back until we know whether compression is worth it
+        std::string firstChunk;
+        bool hasReplied = false;
+
+        // Serialisation only runs a couple of chunks ahead of the client, so slow clients
+        // don't make the whole body pile up in memory
+        auto send = [&](const char * data, size_t size) {
+            buffer.putn_nocopy(reinterpret_cast<const uint8_t *>(data), size).wait();
+
+            if (!waitForClient(buffer, replyTask, Server::MAX_STREAM_BACKLOG, Server::REQUEST_TIMEOUT))
+                throw std::runtime_error("Client stopped reading response");
+        };
+
+        auto output = [&](const char * data, size_t size) {
+            if (compressor)
+                compressor->write(data, size);
+            else
+                send(data, size);
+        };
+
+        auto startReply = [&](bool isSmall) {
+            if (encoding != ContentEncoding::Identity && !isSmall)
+            {
+                compressor = std::make_unique<Compressor>(encoding, compressionLevel, send);
+                response.headers().add(header_names::content_encoding, toString(encoding));
+            }
+
+            response.set_body(buffer.create_istream(), contentType);
+            replyTask = request.reply(response);
+
+            hasReplied = true;
+
+            output(firstChunk.data(), firstChunk.size());
+        };
+
+        try
+        {
+            write([&](const char * data, size_t size) {
+                    if (!hasReplied)
+                    {
+                        if (firstChunk.empty())
+                        {
+                            firstChunk.assign(data, size);
+                            return;
+                        }
+
+                        startReply(false);
+                    }
+
+                    output(data, size);
+                });
+
+            if (!hasReplied)
+                startReply(firstChunk.size() < Server::COMPRESSION_THRESHOLD);
+
+            if (compressor)
+                compressor->finish();
+        }
+        catch (const std::exception& e)
+        {
+            std::string errMsg = "Caught error while streaming response: " + std::string(e.what());
+            g_logger.error(errMsg);
+
+            if (!hasReplied)
+            {
+                auto answer = json::value::object();
+                answer["error"] = json::value::string(errMsg);
+
+                request.reply(status_codes::InternalError, answer);
+            }
+        }
+
+        buffer.close(std::ios_base::out).wait();
+    }
+
+    /**
+     * @brief Stream live climate samples as Server-Sent Events, e.g.:
+     *
+     *     event: climate
+     *     data: {"sensor":"interior","timestamp":1500000000,"temperature":21.5,"humidity":48}
+     *
+     * Returns once the client disconnects (the reply task fails as soon as a write
+     * does, which keep-alives guarantee within their interval) or falls behind, the
+     * stream has lasted for its maximum duration (clients reconnect automatically),
+     * or the listener is stopped.
+     *
+     * @param [in] request      Request to reply to
+     * @param [in] manager      Manager to subscribe to
+     * @param [in] isListening  Flag cleared when the listener is stopped
+     */
+    static void streamClimateSamples(const http_request& request, IManager& manager,
+                                     const std::atomic<bool>& isListening)
+    {
+        using namespace std::chrono;
+
+        static constexpr auto c_pollInterval = seconds(1);
+        static constexpr auto c_keepAliveInterval = seconds(15);
+        static constexpr auto c_maxDuration = minutes(10);
+
+        // Unread output beyond which the client is deemed gone (events are ~100 bytes each)
+        static constexpr size_t c_maxBacklog = 4 * 1024;
+
+        auto subscription = manager.subscribeClimateSamples();
+
+        concurrency::streams::producer_consumer_buffer<uint8_t> buffer;
+
+        http_response response(status_codes::OK);
+
+        response.headers().add(header_names::cache_control, "no-cache");
+        response.set_body(buffer.create_istream(), "text/event-stream");
+
+        auto replyTask = request.reply(response);
+
+        auto send = [&buffer](const std::string& events) {
+            buffer.putn_nocopy(reinterpret_cast<const uint8_t *>(events.data()), events.size()).wait();
+        };
+
+        try
+        {
+            // Delay before clients reconnect, in ms
+            send("retry: 5000\n\n");
+
+            auto startTime = steady_clock::now();
+            auto lastSendTime = startTime;
+
+            while (isListening && !replyTask.is_done() && buffer.in_avail() < c_maxBacklog &&
+                   steady_clock::now() - startTime < c_maxDuration)
+            {
+                auto samples = subscription->pop(c_pollInterval);
+
+                if (samples.empty())
+                {
+                    // Comment lines keep proxies from closing an idle connection
+                    if (steady_clock::now() - lastSendTime >= c_keepAliveInterval)
+                    {
+                        send(": keep-alive\n\n");
+                        lastSendTime = steady_clock::now();
+                    }
+
+                    continue;
+                }
+
+                std::string events;
+
+                for (const auto& sample : samples)
+                {
+                    events += "event: climate\ndata: ";
+
+                    JsonWriter writer([&events](const char * data, size_t size) { events.append(data, size); }, 256);
+
+                    writer.beginObject()
+                          .key("sensor").value(sample.sensorID)
+                          .key("timestamp").value(sample.timestamp)
+                          .key("temperature").value(sample.data.temperature)
+                          .key("humidity").value(sample.data.humidity)
+                          .endObject();
+
+                    writer.flush();
+
+                    events += "\n\n";
+                }
+
+                send(events);
+                lastSendTime = steady_clock::now();
+            }
+        }
+        catch (const std::exception& e)
+        {
+            g_logger.warning("Caught error while streaming climate samples: " + std::string(e.what()));
+        }
+
+        buffer.close(std::ios_base::out).wait();
+    }
+
+    bool Server::admitRequest(RouteStats& route)
+    {
+        std::lock_guard<std::mutex> lock(_routeMutex);
+
+        if (route.limit > 0 && route.inFlight >= route.limit)
+        {
+            route.rejected++;
+            return false;
+        }
+
+        route.inFlight++;
+        return true;
+    }
+
+    void Server::finishRequest(RouteStats& route, std::chrono::steady_clock::time_point startTime, bool served)
+    {
+        double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+        std::lock_guard<std::mutex> lock(_routeMutex);
+
+        route.inFlight--;
+
+        if (served)
+        {
+            route.served++;
+            route.totalMs += elapsedMs;
+            route.maxMs = std::max(route.maxMs, elapsedMs);
+        }
+        else
+        {
+            route.rejected++;
+        }
+    }
+
     void Server::listen()
     {
         std::unique_lock<std::mutex> lock(_mutex);
@@ -137,9 +520,9 @@ namespace beewatch::http
                     {
                         try
                         {
-                            since = std::stoi(query.at("since"));
+                            since = std::stoll(query.at("since"));
                         }
-                        catch (const std::invalid_argument&)
+                        catch (const std::exception&)
                         {
                             std::string errMsg = "Caught error while interpreting \"since\" "
                                                  "parameter in \"GET /data/climate\" request "
@@ -153,32 +536,312 @@ namespace beewatch::http
                         }
                     }
 
-                    // Create JSON array from map of climate samples
+                    // Optional resolution (in seconds): answer from downsampled aggregates
+                    int64_t resolution = 0;
+
+                    if (query.find("resolution") != query.end())
+                    {
+                        try
+                        {
+                            resolution = std::stoll(query.at("resolution"));
+                        }
+                        catch (const std::exception&)
+                        {
+                            resolution = -1;
+                        }
+
+                        if (resolution <= 0)
+                        {
+                            std::string errMsg = "Caught error while interpreting \"resolution\" "
+                                                 "parameter in \"GET /data/climate\" request "
+                                                 "(got \"?resolution=" + query.at("resolution") + "\"";
+
+                            answer["error"] = json::value::string(errMsg);
+                            g_logger.error(errMsg);
+
+                            request.reply(status_codes::BadRequest, answer);
+                            return;
+                        }
+                    }
+
+                    // Optional maximum number of points per sensor: decimate raw samples for display
+                    size_t points = 0;
+
+                    if (query.find("points") != query.end())
+                    {
+                        long long value;
+
+                        try
+                        {
+                            value = std::stoll(query.at("points"));
+                        }
+                        catch (const std::exception&)
+                        {
+                            value = -1;
+                        }
+
+                        if (value < 3)
+                        {
+                            std::string errMsg = "Caught error while interpreting \"points\" "
+                                                 "parameter in \"GET /data/climate\" request "
+                                                 "(got \"?points=" + query.at("points") + "\", "
+                                                 "expected at least 3)";
+
+                            answer["error"] = json::value::string(errMsg);
+                            g_logger.error(errMsg);
+
+                            request.reply(status_codes::BadRequest, answer);
+                            return;
+                        }
+
+                        points = (size_t)value;
+                    }
+
+                    // Optional end of the time window (exclusive)
+                    int64_t until = std::numeric_limits<int64_t>::max();
+
+                    if (query.find("until") != query.end())
+                    {
+                        try
+                        {
+                            until = std::stoll(query.at("until"));
+                        }
+                        catch (const std::exception&)
+                        {
+                            std::string errMsg = "Caught error while interpreting \"until\" "
+                                                 "parameter in \"GET /data/climate\" request "
+                                                 "(got \"?until=" + query.at("until") + "\")";
+
+                            answer["error"] = json::value::string(errMsg);
+                            g_logger.error(errMsg);
+
+                            request.reply(status_codes::BadRequest, answer);
+                            return;
+                        }
+                    }
+
+                    // Optional maximum number of raw samples per sensor: answer one page at a time
+                    size_t limit = 0;
+
+                    if (query.find("limit") != query.end())
+                    {
+                        long long value;
+
+                        try
+                        {
+                            value = std::stoll(query.at("limit"));
+                        }
+                        catch (const std::exception&)
+                        {
+                            value = -1;
+                        }
+
+                        if (value < 1 || resolution > 0)
+                        {
+                            std::string errMsg = "Caught error while interpreting \"limit\" "
+                                                 "parameter in \"GET /data/climate\" request "
+                                                 "(got \"?limit=" + query.at("limit") + "\", "
+                                                 "expected at least 1, without \"resolution\")";
+
+                            answer["error"] = json::value::string(errMsg);
+                            g_logger.error(errMsg);
+
+                            request.reply(status_codes::BadRequest, answer);
+                            return;
+                        }
+
+                        limit = (size_t)value;
+                    }
+
+                    // Optional cursor from a previous page, which replaces "since" & "until"
+                    if (query.find("cursor") != query.end())
+                    {
+                        if (limit == 0 || !decodeCursor(query.at("cursor"), since, until))
+                        {
+                            std::string errMsg = "Caught error while interpreting \"cursor\" "
+                                                 "parameter in \"GET /data/climate\" request "
+                                                 "(got \"?cursor=" + query.at("cursor") + "\", "
+                                                 "expected a cursor from a previous page, with \"limit\")";
+
+                            answer["error"] = json::value::string(errMsg);
+                            g_logger.error(errMsg);
+
+                            request.reply(status_codes::BadRequest, answer);
+                            return;
+                        }
+                    }
+
                     auto sensorIDs = _manager.getClimateSensorIDs();
 
+                    // Identify current state of climate data from in-memory watermarks,
+                    // taken before reading samples so a response is never newer than its tag
+                    ClimateWatermark watermark;
+
                     for (const auto& sensorID : sensorIDs)
                     {
-                        auto samples = _manager.getClimateSamples(sensorID, since);
+                        auto sensorWatermark = _manager.getClimateWatermark(sensorID);
+
+                        watermark.lastTimestamp = std::max(watermark.lastTimestamp, sensorWatermark.lastTimestamp);
+                        watermark.count += sensorWatermark.count;
+                        watermark.generation = sensorWatermark.generation;
+                    }
+
+                    // Packed typed arrays if the client asks for CBOR, JSON otherwise
+                    auto mediaType = MediaType::Json;
+                    auto accept = request.headers().find(header_names::accept);
+
+                    if (accept != request.headers().end())
+                        mediaType = negotiateMediaType(accept->second);
+
+                    // Sample counts only grow until data is cleared, which bumps the generation.
+                    // Tags are weak since gzip & identity encodings of a format share them
+                    std::string etag = "\"" + std::to_string(watermark.generation) + "-" +
+                                       std::to_string(watermark.count) + "-" +
+                                       std::to_string(watermark.lastTimestamp) +
+                                       (mediaType == MediaType::Cbor ? "-cbor" : "") + "\"";
+
+                    http_response response(status_codes::OK);
+
+                    response.headers().add(header_names::etag, "W/" + etag);
+                    response.headers().add(header_names::cache_control, "no-cache");
+
+                    // Set before answering 304s, which must carry the same Vary header as full responses
+                    response.headers().add(header_names::vary, _compressionLevel > 0 ? "Accept, Accept-Encoding" : "Accept");
+
+                    if (watermark.count > 0)
+                        response.headers().add(header_names::last_modified, formatHttpDate(watermark.lastTimestamp));
+
+                    // Client already has this state: answer without touching the DB
+                    auto ifNoneMatch = request.headers().find(header_names::if_none_match);
+
+                    if (ifNoneMatch != request.headers().end() && matchesETag(ifNoneMatch->second, etag))
+                    {
+                        response.set_status_code(status_codes::NotModified);
+                        request.reply(response);
+                        return;
+                    }
 
-                        answer[sensorID] = json::value::object(true);
-                        answer[sensorID]["timestamps"] = json::value::array(samples.size());
-                        answer[sensorID]["samples"] = json::value::array(samples.size());
+                    // Pin the window of a paged read to the samples present on its first page,
+                    // so that pages don't chase samples added in the meantime
+                    if (limit > 0 && until == std::numeric_limits<int64_t>::max())
+                        until = watermark.lastTimestamp + 1;
 
-                        size_t index = 0;
-                        for (auto& sample : samples)
+                    // Raw samples of all sensors are fetched in a single DB round trip before
+                    // serialising; aggregates come from the in-memory rollup
+                    std::map<std::string, ClimateSeries> samples;
+
+                    if (resolution <= 0)
+                        samples = _manager.getClimateSamples(sensorIDs, since, until, limit);
+
+                    if (limit > 0)
+                    {
+                        // End the page where the first sensor ran out of samples, so all
+                        // sensors cover the same time span & the next page resumes from there
+                        int64_t pageEnd = until;
+
+                        for (const auto& entry : samples)
                         {
-                            answer[sensorID]["timestamps"][index] = json::value::number((int64_t)sample.first);
+                            if (entry.second.size() >= limit)
+                                pageEnd = std::min(pageEnd, entry.second.timestamps.back() + 1);
+                        }
 
-                            answer[sensorID]["samples"][index] = json::value::object({
-                                    { "temperature", sample.second.temperature },
-                                    { "humidity", sample.second.humidity }
-                                }, true);
+                        for (auto& entry : samples)
+                        {
+                            auto& timestamps = entry.second.timestamps;
+                            entry.second.resize(std::lower_bound(timestamps.begin(), timestamps.end(), pageEnd) -
+                                                timestamps.begin());
+                        }
+
+                        if (pageEnd < until)
+                        {
+                            std::string next = "?cursor=" + encodeCursor(pageEnd, until) +
+                                               "&limit=" + std::to_string(limit);
 
-                            ++index;
+                            if (points > 0)
+                                next += "&points=" + std::to_string(points);
+
+                            response.headers().add("Link", "<" + next + ">; rel=\"next\"");
                         }
                     }
 
-                    request.reply(status_codes::OK, answer);
+                    // Get each sensor's samples, decimated or aggregated as requested. Timestamps
+                    // precede samples in the output, so series are held in their (compact)
+                    // columnar form rather than streamed from the DB
+                    auto writeSensor = [&](const std::string& sensorID, auto& writer) {
+                            if (resolution > 0)
+                            {
+                                auto aggregates = _manager.getClimateAggregates(sensorID, resolution, since);
+                                aggregates.erase(aggregates.lower_bound(until), aggregates.end());
+
+                                writeClimateAggregates(writer, aggregates);
+                                return;
+                            }
+
+                            auto& series = samples[sensorID];
+
+                            if (points > 0)
+                                writeClimateSeries(writer, decimateLTTB(series, points));
+                            else
+                                writeClimateSeries(writer, series);
+
+                            // Release each series once written
+                            series = ClimateSeries();
+                        };
+
+                    // Serialise straight to the response, without building a DOM
+                    replyStreamed(request, response, toString(mediaType), _compressionLevel, [&](const ChunkSink& sink) {
+                            if (mediaType == MediaType::Cbor)
+                            {
+                                CborWriter writer(sink);
+
+                                writer.beginMap(sensorIDs.size());
+
+                                for (const auto& sensorID : sensorIDs)
+                                {
+                                    writer.value(sensorID);
+                                    writeSensor(sensorID, writer);
+                                }
+
+                                writer.flush();
+                            }
+                            else
+                            {
+                                JsonWriter writer(sink);
+
+                                writer.beginObject();
+
+                                for (const auto& sensorID : sensorIDs)
+                                {
+                                    writer.key(sensorID);
+                                    writeSensor(sensorID, writer);
+                                }
+
+                                writer.endObject();
+                                writer.flush();
+                            }
+                        });
+
+                    return;
+                }
+                else if (uri == "stream/climate")
+                {
+                    // Each stream holds a listener thread for its whole duration
+                    if (++_numStreams > MAX_STREAMS)
+                    {
+                        --_numStreams;
+
+                        std::string errMsg = "Too many clients streaming climate samples";
+
+                        answer["error"] = json::value::string(errMsg);
+                        g_logger.warning(errMsg);
+
+                        request.reply(status_codes::ServiceUnavailable, answer);
+                        return;
+                    }
+
+                    streamClimateSamples(request, _manager, _isListening);
+
+                    --_numStreams;
                     return;
                 }
                 else if (uri == "name")
@@ -188,6 +851,43 @@ namespace beewatch::http
                     request.reply(status_codes::OK, answer);
                     return;
                 }
+                else if (uri == "metrics")
+                {
+                    auto stats = _workers->getStats();
+
+                    answer["workers"] = json::value::object();
+                    answer["workers"]["count"] = json::value::number((uint64_t)stats.numWorkers);
+                    answer["workers"]["running"] = json::value::number((uint64_t)stats.running);
+                    answer["workers"]["queued"] = json::value::number((uint64_t)stats.queued);
+                    answer["workers"]["capacity"] = json::value::number((uint64_t)stats.capacity);
+                    answer["workers"]["completed"] = json::value::number(stats.completed);
+                    answer["workers"]["rejected"] = json::value::number(stats.rejected);
+                    answer["workers"]["expired"] = json::value::number(stats.expired);
+                    answer["workers"]["meanWaitMs"] = json::value::number(stats.meanWaitMs);
+                    answer["workers"]["maxWaitMs"] = json::value::number(stats.maxWaitMs);
+
+                    answer["routes"] = json::value::object();
+
+                    std::lock_guard<std::mutex> lock(_routeMutex);
+
+                    for (const auto& route : _routes)
+                    {
+                        auto& routeStats = answer["routes"][route.first];
+                        routeStats = json::value::object();
+
+                        routeStats["limit"] = json::value::number((uint64_t)route.second.limit);
+                        routeStats["inFlight"] = json::value::number((uint64_t)route.second.inFlight);
+                        routeStats["served"] = json::value::number(route.second.served);
+                        routeStats["rejected"] = json::value::number(route.second.rejected);
+                        routeStats["meanLatencyMs"] = json::value::number(route.second.served > 0
+                                                                          ? route.second.totalMs / route.second.served
+                                                                          : 0.0);
+                        routeStats["maxLatencyMs"] = json::value::number(route.second.maxMs);
+                    }
+
+                    request.reply(status_codes::OK, answer);
+                    return;
+                }
                 else if (uri == "version")
                 {
                     answer["version"] = json::value::string(NAME_VERSION);
@@ -279,12 +979,79 @@ namespace beewatch::http
         };
         
 
+        // Answer admitted request, always counting it out of its route (as not served if it threw)
+        auto answerAdmitted = [this, answerRequest](http_request request, RouteStats& routeStats,
+                                                    std::chrono::steady_clock::time_point startTime) {
+            bool served = true;
+
+            try
+            {
+                answerRequest(request);
+            }
+            catch (const std::exception& e)
+            {
+                served = false;
+
+                replyInternalError(request, "Caught error while answering \"" + request.method() + " " +
+                                            getRequestURI(request) + "\" request: " + std::string(e.what()));
+            }
+
+            finishRequest(routeStats, startTime, served);
+        };
+
+        // Answer cheap routes on the listener's threads & hand others to workers, within
+        // their route's concurrency limit. Untracked routes (event streams & unknown
+        // URIs) are answered inline as well
+        auto dispatchRequest = [this, answerAdmitted, answerRequest](http_request request) {
+            auto startTime = std::chrono::steady_clock::now();
+
+            // Route map is never modified after construction, so it can be searched without locking
+            auto route = _routes.find(request.method() + " " + getRequestURI(request));
+
+            if (route == _routes.end())
+            {
+                answerRequest(request);
+                return;
+            }
+
+            auto& routeStats = route->second;
+
+            if (!admitRequest(routeStats))
+            {
+                replyUnavailable(request, "Too many concurrent \"" + route->first + "\" requests");
+                return;
+            }
+
+            if (routeStats.limit == 0)
+            {
+                answerAdmitted(request, routeStats, startTime);
+                return;
+            }
+
+            bool isQueued = _workers->submit(
+                [answerAdmitted, request, &routeStats, startTime]() {
+                    answerAdmitted(request, routeStats, startTime);
+                },
+                REQUEST_TIMEOUT,
+                [this, request, &routeStats, startTime]() {
+                    replyUnavailable(request, "Timed out waiting for a worker to answer \"" +
+                                              request.method() + " " + getRequestURI(request) + "\" request");
+                    finishRequest(routeStats, startTime, false);
+                });
+
+            if (!isQueued)
+            {
+                replyUnavailable(request, "Too many queued requests, rejecting \"" + route->first + "\" request");
+                finishRequest(routeStats, startTime, false);
+            }
+        };
+
         // Create listener and add handler for supported methods
         http_listener listener("http://0.0.0.0:" + std::to_string(_port) + "/api/v1/");
 
-        listener.support(methods::GET, answerRequest);
-        listener.support(methods::PUT, answerRequest);
-        listener.support(methods::DEL, answerRequest);
+        listener.support(methods::GET, dispatchRequest);
+        listener.support(methods::PUT, dispatchRequest);
+        listener.support(methods::DEL, dispatchRequest);
 
         // Loop until stop signal received
         try
@@ -293,12 +1060,16 @@ namespace beewatch::http
                     .then([](){ g_logger.debug("Starting Server listener"); })
                     .wait();
 
+            _isListening = true;
             _stopCondition.wait(lock);
         }
         catch (const std::exception& e)
         {
             g_logger.error("Caught exception in REST API's listener thread: " + std::string(e.what()));
         }
+
+        // End event streams, so the listener can close
+        _isListening = false;
     }
 
 } // namespace beewatch::http
@@ -9,6 +9,7 @@
 #include "util/priority.h"
 #include "util/algorithms.hpp"
 
+#include <mutex>
 #include <thread>
 
 namespace beewatch::hw
@@ -18,8 +19,8 @@ namespace beewatch::hw
     using io::LogicalState;
 
     //==============================================================================
-    DHTxx::DHTxx(Type dhtType, GPIO::Ptr&& gpio)
-        : _type(dhtType)
+    DHTxx::DHTxx(Type dhtType, GPIO::Ptr&& gpio, ReadMode readMode)
+        : _type(dhtType), _readMode(readMode)
     {
         if (!gpio)
         {
@@ -38,6 +39,14 @@ namespace beewatch::hw
     //==============================================================================
     static constexpr std::array<uint8_t, 5> readError { {0xFF, 0xFF, 0xFF, 0xFF, 0xFF} };
 
+    /**
+     * Sensors may be read concurrently, but polled transfers are timed by busy-waiting:
+     * only one transfer runs at a time, so two sensors never compete for a core mid-
+     * transfer. Waits between samples & attempts (seconds) still overlap, as do edge
+     * captures, which are timestamped by the ISR.
+     */
+    static std::mutex transferMutex;
+
     DHTxx::Data DHTxx::read()
     {
         // Sample DHTxx output N times
@@ -87,11 +96,22 @@ namespace beewatch::hw
         int i = 0;
         while (i++ < 25)
         {
-            auto data = readRaw();
+            std::array<uint8_t, READ_BYTES> data;
+
+            if (_readMode == ReadMode::EdgeCapture)
+            {
+                data = readEdges();
+            }
+            else
+            {
+                std::lock_guard<std::mutex> transferLock(transferMutex);
+                data = readRaw();
+            }
 
             if ( std::equal(data.begin(), data.end(), readError.begin()) )
             {
-                g_logger.warning("DHT read failed: timeout reached");
+                g_logger.warning(_readMode == ReadMode::EdgeCapture ? "DHT read failed: edges missed"
+                                                                    : "DHT read failed: timeout reached");
 
                 reset();
                 continue;
@@ -250,7 +270,7 @@ namespace beewatch::hw
             } while (_gpio->read() == LogicalState::HI);
             
             // Mid-point between bit value times is 48.5
-            if (diffMs > 48.5e-3)
+            if (diffMs > BIT_THRESHOLD_MS)
             {
                 bytes[byte] |= mask;
             }
@@ -266,6 +286,92 @@ namespace beewatch::hw
         return bytes;
     }
 
+    std::array<uint8_t, DHTxx::READ_BYTES> DHTxx::readEdges()
+    {
+        /**
+         * 1. Record edges from before the start signal, which leaves the ISR
+         *    ample time to be ready for the response
+         */
+        _gpio->startEdgeCapture(GPIO::EdgeType::Both, EDGE_CAPTURE_CAPACITY);
+
+
+        /**
+         * 2. Output LO for 20ms (>18ms given in spec sheet)
+         */
+        _gpio->setMode(GPIO::Mode::Output);
+
+        _gpio->write(LogicalState::LO);
+        g_timeRaw.wait(20.0);
+
+        _gpio->write(LogicalState::HI);
+        g_timeRaw.wait(30e-3);
+
+        _gpio->setMode(GPIO::Mode::Input);
+
+
+        /**
+         * 3. Sleep through the transfer, then measure pulse widths from the timestamps
+         */
+        g_timeRaw.wait(TRANSFER_TIME_MS);
+
+        return decodeEdges(_gpio->stopEdgeCapture());
+    }
+
+    std::array<uint8_t, DHTxx::READ_BYTES> DHTxx::decodeEdges(const std::vector<GPIO::Edge>& edges)
+    {
+        /**
+         * 1. Pair rising & falling edges into HI pulses
+         */
+        struct Pulse
+        {
+            double startMs;
+            double endMs;
+        };
+
+        std::vector<Pulse> pulses;
+        pulses.reserve(edges.size() / 2);
+
+        for (size_t i = 0; i + 1 < edges.size(); ++i)
+        {
+            if (edges[i].state == LogicalState::HI && edges[i + 1].state == LogicalState::LO)
+            {
+                pulses.push_back({ edges[i].timeMs, edges[i + 1].timeMs });
+            }
+        }
+
+        if (pulses.size() < READ_BITS)
+        {
+            return readError;
+        }
+
+        /**
+         * 2. DHT sends 40 bits back to back via LO (50us), then HI (26-28us for 0, 70us for 1)
+         */
+        std::array<uint8_t, READ_BYTES> bytes;
+        bytes.fill(0);
+
+        size_t first = pulses.size() - READ_BITS;
+
+        for (size_t i = first; i < pulses.size(); ++i)
+        {
+            double widthMs = pulses[i].endMs - pulses[i].startMs;
+            double gapMs = i > first ? pulses[i].startMs - pulses[i - 1].endMs : 0.0;
+
+            if (widthMs > READ_TIMEOUT_MS || gapMs > READ_TIMEOUT_MS)
+            {
+                return readError;
+            }
+
+            if (widthMs > BIT_THRESHOLD_MS)
+            {
+                size_t bit = i - first;
+                bytes[bit / 8] |= 0b1000'0000 >> (bit % 8);
+            }
+        }
+
+        return bytes;
+    }
+
     bool DHTxx::validateData(const std::array<uint8_t, READ_BYTES>& data)
     {
         uint8_t checksum = 0;
@@ -5,6 +5,7 @@
 #include "io/gpio.h"
 
 #include "global/logging.h"
+#include "global/time.hpp"
 
 #include <algorithm>
 #include <cassert>
@@ -20,43 +21,57 @@ namespace beewatch::io
 
     bool GPIO::_claimedGPIOList[NUM_GPIO] = { 0 };
     std::mutex GPIO::_claimMutex[NUM_GPIO];
+    std::mutex GPIO::_configMutex;
+
+    GPIO::EdgeBuffer GPIO::_edgeBuffers[NUM_GPIO];
+
+    template <size_t... IDs>
+    constexpr std::array<void (*)(void), GPIO::NUM_GPIO> GPIO::makeCaptureISRs(std::index_sequence<IDs...>)
+    {
+        return { { &GPIO::captureEdge<IDs>... } };
+    }
+
+    const std::array<void (*)(void), GPIO::NUM_GPIO> GPIO::_captureISRs =
+        GPIO::makeCaptureISRs(std::make_index_sequence<GPIO::NUM_GPIO>());
 
     //==============================================================================
     GPIO::GPIO(int id, std::shared_ptr<external::IWiringPi> wiringPi)
-        : _wiringPi(wiringPi)
+        : _wiringPi(wiringPi),
+          _registers(dynamic_cast<external::GpioMem*>(wiringPi.get())),
+          _mask(1u << id)
     {
         if (_claimedGPIOList[id])
         {
             throw std::invalid_argument("Requested GPIO is already claimed");
         }
 
-        // Set enum _maps
-        _mapLogicalStateToWiringPi = {
-            { LogicalState::LO, _wiringPi->c_low },
-            { LogicalState::HI, _wiringPi->c_high },
-
-            { LogicalState::Invalid, -1 }
-        };
-
-        _mapModeToWiringPi = {
-            { GPIO::Mode::Input, _wiringPi->c_input },
-            { GPIO::Mode::Output, _wiringPi->c_output },
-            { GPIO::Mode::PWM, _wiringPi->c_pwmToneOutput },
-            { GPIO::Mode::CLK, _wiringPi->c_gpioClock },
-        };
-
-        _mapResistorToWiringPi = {
-            { GPIO::Resistor::Off, _wiringPi->c_pudOff },
-            { GPIO::Resistor::PullUp, _wiringPi->c_pudUp },
-            { GPIO::Resistor::PullDown, _wiringPi->c_pudDown },
-        };
-
-        _mapEdgeTypeToWiringPi = {
-            { GPIO::EdgeType::None, _wiringPi->c_intEdgeSetup },
-            { GPIO::EdgeType::Rising, _wiringPi->c_intEdgeRising },
-            { GPIO::EdgeType::Falling, _wiringPi->c_intEdgeFalling },
-            { GPIO::EdgeType::Both, _wiringPi->c_intEdgeBoth },
-        };
+        // Set enum lookup tables, in enum order
+        _logicalStateToWiringPi = { {
+            _wiringPi->c_low,               // LogicalState::LO
+            _wiringPi->c_high,              // LogicalState::HI
+
+            -1,                             // LogicalState::Invalid
+        } };
+
+        _modeToWiringPi = { {
+            _wiringPi->c_input,             // Mode::Input
+            _wiringPi->c_output,            // Mode::Output
+            _wiringPi->c_pwmToneOutput,     // Mode::PWM
+            _wiringPi->c_gpioClock,         // Mode::CLK
+        } };
+
+        _resistorToWiringPi = { {
+            _wiringPi->c_pudOff,            // Resistor::Off
+            _wiringPi->c_pudUp,             // Resistor::PullUp
+            _wiringPi->c_pudDown,           // Resistor::PullDown
+        } };
+
+        _edgeTypeToWiringPi = { {
+            _wiringPi->c_intEdgeSetup,      // EdgeType::None
+            _wiringPi->c_intEdgeRising,     // EdgeType::Rising
+            _wiringPi->c_intEdgeFalling,    // EdgeType::Falling
+            _wiringPi->c_intEdgeBoth,       // EdgeType::Both
+        } };
 
         // Take ownership of GPIO
         _id = id;
@@ -69,6 +84,8 @@ namespace beewatch::io
     GPIO::~GPIO()
     {
         // Reset GPIO configuration
+        _edgeBuffers[_id].isCapturing = false;
+
         setMode(Mode::Input);
         setResistorMode(Resistor::Off);
         clearEdgeDetection();
@@ -119,7 +136,9 @@ namespace beewatch::io
     //==============================================================================
     void GPIO::setMode(Mode mode)
     {
-        _wiringPi->pinMode(_id, _mapModeToWiringPi.at(mode));
+        std::lock_guard<std::mutex> guard(_configMutex);
+
+        _wiringPi->pinMode(_id, toWiringPi(_modeToWiringPi, mode));
         _mode = mode;
     }
 
@@ -132,7 +151,9 @@ namespace beewatch::io
     //==============================================================================
     void GPIO::setResistorMode(Resistor cfg)
     {
-        _wiringPi->pullUpDnControl(_id, _mapResistorToWiringPi.at(cfg));
+        std::lock_guard<std::mutex> guard(_configMutex);
+
+        _wiringPi->pullUpDnControl(_id, toWiringPi(_resistorToWiringPi, cfg));
         _resistorCfg = cfg;
     }
 
@@ -155,7 +176,18 @@ namespace beewatch::io
             throw std::invalid_argument("Received invalid logical state in GPIO::write()");
         }
 
-        _wiringPi->digitalWrite(_id, _mapLogicalStateToWiringPi.at(state));
+        // Register-mapped pins are toggled directly, bypassing the library interface
+        if (_registers)
+        {
+            if (state == LogicalState::HI)
+                _registers->set(_mask);
+            else
+                _registers->clear(_mask);
+
+            return;
+        }
+
+        _wiringPi->digitalWrite(_id, toWiringPi(_logicalStateToWiringPi, state));
     }
 
     LogicalState GPIO::read()
@@ -165,13 +197,18 @@ namespace beewatch::io
             throw std::invalid_argument("read() called on GPIO not configured as input");
         }
 
+        if (_registers)
+        {
+            return (_registers->level() & _mask) ? LogicalState::HI : LogicalState::LO;
+        }
+
         int val = _wiringPi->digitalRead(_id);
 
-        if (val == _wiringPi->c_low)
+        if (val == toWiringPi(_logicalStateToWiringPi, LogicalState::LO))
         {
             return LogicalState::LO;
         }
-        else if (val == _wiringPi->c_high)
+        else if (val == toWiringPi(_logicalStateToWiringPi, LogicalState::HI))
         {
             return LogicalState::HI;
         }
@@ -192,7 +229,13 @@ namespace beewatch::io
             return;
         }
 
-        _wiringPi->setISR(_id, _mapEdgeTypeToWiringPi.at(type), callback);
+        _edgeBuffers[_id].isrType = EdgeType::None;
+
+        if (_wiringPi->setISR(_id, toWiringPi(_edgeTypeToWiringPi, type), callback) < 0)
+        {
+            g_logger.error("Edge detection is unavailable on GPIO" + std::to_string(_id));
+        }
+
         _edgeDetection = type;
     }
 
@@ -203,8 +246,122 @@ namespace beewatch::io
 
     void GPIO::clearEdgeDetection()
     {
+        _edgeBuffers[_id].isrType = EdgeType::None;
+
         _wiringPi->setISR(_id, _wiringPi->c_intEdgeRising, &nop);
         _edgeDetection = EdgeType::None;
     }
 
+
+    //==============================================================================
+    void GPIO::recordEdge(EdgeBuffer& buffer, double timeMs, LogicalState state)
+    {
+        if (!buffer.isCapturing.load(std::memory_order_acquire))
+        {
+            return;
+        }
+
+        size_t size = buffer.size.load(std::memory_order_relaxed);
+
+        if (size < buffer.edges.size())
+        {
+            buffer.edges[size] = { timeMs, state };
+            buffer.size.store(size + 1, std::memory_order_release);
+        }
+    }
+
+    template <size_t ID>
+    void GPIO::captureEdge()
+    {
+        // Timestamp first: everything else only adds latency
+        double timeMs = g_timeRaw.now();
+
+        auto& buffer = _edgeBuffers[ID];
+
+        if (!buffer.isCapturing.load(std::memory_order_acquire))
+        {
+            return;
+        }
+
+        LogicalState state;
+
+        if (buffer.type == EdgeType::Rising)
+            state = LogicalState::HI;
+        else if (buffer.type == EdgeType::Falling)
+            state = LogicalState::LO;
+        else
+            state = buffer.wiringPi->digitalRead(ID) == buffer.wiringPi->c_high ? LogicalState::HI : LogicalState::LO;
+
+        recordEdge(buffer, timeMs, state);
+    }
+
+    void GPIO::captureTimestampedEdge(int pin, int value, double timeMs)
+    {
+        if (pin < 0 || pin >= NUM_GPIO)
+        {
+            return;
+        }
+
+        auto& buffer = _edgeBuffers[pin];
+
+        if (!buffer.isCapturing.load(std::memory_order_acquire))
+        {
+            return;
+        }
+
+        recordEdge(buffer, timeMs, value == buffer.wiringPi->c_high ? LogicalState::HI : LogicalState::LO);
+    }
+
+    void GPIO::startEdgeCapture(EdgeType type, size_t capacity)
+    {
+        if (type == EdgeType::None || capacity == 0)
+        {
+            throw std::invalid_argument("Edge capture requires an edge type and a non-empty buffer");
+        }
+
+        auto& buffer = _edgeBuffers[_id];
+
+        // Buffer is only reallocated when growing, and never while the ISR may use it
+        buffer.isCapturing = false;
+
+        buffer.edges.resize(capacity);
+        buffer.size = 0;
+        buffer.type = type;
+        buffer.wiringPi = _wiringPi.get();
+
+        buffer.isCapturing.store(true, std::memory_order_release);
+
+        // Capture ISR is kept between captures, since wiringPi starts a thread whenever an ISR is set
+        if (buffer.isrType != type)
+        {
+            // Prefer timestamps taken as edges occurred over those taken by the ISR
+            int edgeType = toWiringPi(_edgeTypeToWiringPi, type);
+
+            if (_wiringPi->setTimestampedISR(_id, edgeType, &GPIO::captureTimestampedEdge) < 0 &&
+                _wiringPi->setISR(_id, edgeType, _captureISRs[_id]) < 0)
+            {
+                g_logger.error("Edge detection is unavailable on GPIO" + std::to_string(_id));
+            }
+            else
+            {
+                buffer.isrType = type;
+            }
+        }
+
+        _edgeDetection = type;
+    }
+
+    std::vector<GPIO::Edge> GPIO::stopEdgeCapture()
+    {
+        auto& buffer = _edgeBuffers[_id];
+
+        // Capture ISR is left set, ignoring edges until capture starts again
+        buffer.isCapturing = false;
+        _edgeDetection = EdgeType::None;
+
+        size_t size = buffer.size.load(std::memory_order_acquire);
+
+        return std::vector<Edge>(buffer.edges.begin(), buffer.edges.begin() + size);
+    }
+
 } // namespace beewatch::io
@@ -0,0 +1,164 @@
+//==============================================================================
+// Copyright (c) 2018 Eric Seguin, all rights reserved.
+//==============================================================================
+
+#include "util/broadcaster.h"
+
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+
+namespace beewatch
+{
+
+    //==============================================================================
+    constexpr size_t ClimateBroadcaster::DEFAULT_CAPACITY;
+
+    //==============================================================================
+    ClimateBroadcaster::Subscription::Subscription(size_t capacity)
+        : _capacity(std::max<size_t>(capacity, 1)), _dropped(0), _closed(false)
+    {
+    }
+
+    std::vector<ClimateSample> ClimateBroadcaster::Subscription::pop(std::chrono::milliseconds timeout)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        _condition.wait_for(lock, timeout, [this]() { return _closed || !_queue.empty(); });
+
+        std::vector<ClimateSample> samples(std::make_move_iterator(_queue.begin()),
+                                           std::make_move_iterator(_queue.end()));
+        _queue.clear();
+
+        return samples;
+    }
+
+    void ClimateBroadcaster::Subscription::close()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _closed = true;
+        }
+
+        _condition.notify_all();
+    }
+
+    bool ClimateBroadcaster::Subscription::isClosed() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _closed;
+    }
+
+    size_t ClimateBroadcaster::Subscription::dropped() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _dropped;
+    }
+
+    void ClimateBroadcaster::Subscription::push(const ClimateSample& sample)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+
+            if (_closed)
+            {
+                return;
+            }
+
+            if (_queue.size() >= _capacity)
+            {
+                _queue.pop_front();
+                _dropped++;
+            }
+
+            _queue.push_back(sample);
+        }
+
+        _condition.notify_one();
+    }
+
+    //==============================================================================
+    ClimateBroadcaster::ClimateBroadcaster()
+        : _subscribers(std::make_shared<const SubscriberList>())
+    {
+    }
+
+    ClimateBroadcaster::~ClimateBroadcaster()
+    {
+        auto subscribers = std::atomic_load(&_subscribers);
+
+        for (const auto& weakSubscriber : *subscribers)
+        {
+            if (auto subscriber = weakSubscriber.lock())
+            {
+                subscriber->close();
+            }
+        }
+    }
+
+    //==============================================================================
+    ClimateBroadcaster::Subscription::Ptr ClimateBroadcaster::subscribe(size_t capacity)
+    {
+        auto subscription = std::make_shared<Subscription>(capacity);
+
+        std::lock_guard<std::mutex> lock(_updateMutex);
+
+        auto subscribers = getLiveSubscribers();
+        subscribers->push_back(subscription);
+
+        std::atomic_store(&_subscribers, std::shared_ptr<const SubscriberList>(std::move(subscribers)));
+
+        return subscription;
+    }
+
+    void ClimateBroadcaster::publish(const ClimateSample& sample)
+    {
+        // Hold snapshot while iterating, as the list may be swapped concurrently
+        auto subscribers = std::atomic_load(&_subscribers);
+        bool hasExpired = false;
+
+        for (const auto& weakSubscriber : *subscribers)
+        {
+            if (auto subscriber = weakSubscriber.lock())
+                subscriber->push(sample);
+            else
+                hasExpired = true;
+        }
+
+        if (hasExpired)
+        {
+            prune();
+        }
+    }
+
+    size_t ClimateBroadcaster::size() const
+    {
+        auto subscribers = std::atomic_load(&_subscribers);
+
+        return std::count_if(subscribers->begin(), subscribers->end(),
+                             [](const std::weak_ptr<Subscription>& subscriber) { return !subscriber.expired(); });
+    }
+
+    //==============================================================================
+    void ClimateBroadcaster::prune()
+    {
+        std::lock_guard<std::mutex> lock(_updateMutex);
+
+        std::atomic_store(&_subscribers, std::shared_ptr<const SubscriberList>(getLiveSubscribers()));
+    }
+
+    std::shared_ptr<ClimateBroadcaster::SubscriberList> ClimateBroadcaster::getLiveSubscribers() const
+    {
+        auto current = std::atomic_load(&_subscribers);
+        auto subscribers = std::make_shared<SubscriberList>();
+
+        for (const auto& subscriber : *current)
+        {
+            if (!subscriber.expired())
+                subscribers->push_back(subscriber);
+        }
+
+        return subscribers;
+    }
+
+} // namespace beewatch
@@ -0,0 +1,192 @@
+//==============================================================================
+// Copyright (c) 2018 Eric Seguin, all rights reserved.
+//==============================================================================
+
+#include "util/climate_cache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+
+namespace beewatch
+{
+
+    //==============================================================================
+    constexpr size_t ClimateCache::DEFAULT_CAPACITY;
+
+    //==============================================================================
+    ClimateCache::Ring::Ring(size_t capacity)
+        : timestamps(capacity), data(capacity),
+          start(0), size(0), coveredSince(std::numeric_limits<int64_t>::min())
+    {
+    }
+
+    void ClimateCache::Ring::push_back(int64_t timestamp, const ClimateData<double>& sample)
+    {
+        if (size > 0 && timestamp < this->timestamp(size - 1))
+        {
+            // Late sample (e.g. clock set back): keep time order by only covering what
+            // follows the newest sample from now on, leaving earlier queries to the DB
+            coveredSince = std::max(coveredSince, this->timestamp(size - 1) + 1);
+            return;
+        }
+
+        if (size == timestamps.size())
+        {
+            coveredSince = std::max(coveredSince, timestamps[start] + 1);
+
+            start = index(1);
+            size--;
+        }
+
+        timestamps[index(size)] = timestamp;
+        data[index(size)] = sample;
+
+        size++;
+    }
+
+    //==============================================================================
+    ClimateCache::ClimateCache(size_t capacity)
+        : _capacity(capacity), _rings(std::make_shared<const RingMap>())
+    {
+        if (capacity == 0)
+        {
+            throw std::invalid_argument("Climate cache capacity must be strictly positive");
+        }
+    }
+
+    //==============================================================================
+    template <typename Function>
+    void ClimateCache::update(Function change)
+    {
+        auto rings = std::make_shared<RingMap>(*std::atomic_load(&_rings));
+
+        // Buffers copied by this update, so each is only copied once
+        std::map<std::string, std::shared_ptr<Ring>> copies;
+
+        auto getRing = [&](const std::string& sensorID) -> Ring& {
+                auto& copy = copies[sensorID];
+
+                if (!copy)
+                {
+                    auto it = rings->find(sensorID);
+
+                    copy = it != rings->end() ? std::make_shared<Ring>(*it->second)
+                                              : std::make_shared<Ring>(_capacity);
+
+                    (*rings)[sensorID] = copy;
+                }
+
+                return *copy;
+            };
+
+        change(getRing);
+
+        std::atomic_store(&_rings, std::shared_ptr<const RingMap>(std::move(rings)));
+    }
+
+    void ClimateCache::add(const std::vector<ClimateSample>& samples)
+    {
+        std::lock_guard<std::mutex> lock(_updateMutex);
+
+        update([&](auto& getRing) {
+                for (const auto& sample : samples)
+                {
+                    getRing(sample.sensorID).push_back(sample.timestamp, sample.data);
+                }
+            });
+    }
+
+    void ClimateCache::add(const std::string& sensorID, const ClimateSeries& series)
+    {
+        std::lock_guard<std::mutex> lock(_updateMutex);
+
+        update([&](auto& getRing) {
+                auto& ring = getRing(sensorID);
+
+                for (size_t i = 0; i < series.size(); ++i)
+                {
+                    ring.push_back(series.timestamps[i], series.data(i));
+                }
+            });
+    }
+
+    void ClimateCache::seed(const std::string& sensorID, const ClimateSeries& series, bool isComplete)
+    {
+        std::lock_guard<std::mutex> lock(_updateMutex);
+
+        update([&](auto& getRing) {
+                auto& ring = getRing(sensorID);
+                ring = Ring(_capacity);
+
+                if (!isComplete && !series.empty())
+                {
+                    // Earlier samples sharing the first timestamp may have been left out
+                    ring.coveredSince = series.timestamps.front() + 1;
+                }
+
+                for (size_t i = 0; i < series.size(); ++i)
+                {
+                    ring.push_back(series.timestamps[i], series.data(i));
+                }
+            });
+    }
+
+    void ClimateCache::clear()
+    {
+        std::lock_guard<std::mutex> lock(_updateMutex);
+
+        std::atomic_store(&_rings, std::make_shared<const RingMap>());
+    }
+
+    //==============================================================================
+    bool ClimateCache::get(const std::string& sensorID, int64_t since, int64_t until, size_t limit,
+                           ClimateSeries& series) const
+    {
+        // Snapshot stays valid (and unchanged) for as long as we hold it
+        auto rings = std::atomic_load(&_rings);
+        auto it = rings->find(sensorID);
+
+        if (it == rings->end() || since < it->second->coveredSince)
+        {
+            return false;
+        }
+
+        const auto& ring = *it->second;
+
+        // Find first sample at or after "since"
+        size_t first = 0;
+        size_t last = ring.size;
+
+        while (first < last)
+        {
+            size_t middle = first + (last - first) / 2;
+
+            if (ring.timestamp(middle) < since)
+                first = middle + 1;
+            else
+                last = middle;
+        }
+
+        last = limit > 0 ? std::min(ring.size, first + limit) : ring.size;
+
+        series.clear();
+        series.reserve(last - first);
+
+        for (size_t i = first; i < last && ring.timestamp(i) < until; ++i)
+        {
+            series.push_back(ring.timestamp(i), ring.data[ring.index(i)]);
+        }
+
+        return true;
+    }
+
+    int64_t ClimateCache::getCoveredSince(const std::string& sensorID) const
+    {
+        auto rings = std::atomic_load(&_rings);
+        auto it = rings->find(sensorID);
+
+        return it != rings->end() ? it->second->coveredSince : std::numeric_limits<int64_t>::max();
+    }
+
+} // namespace beewatch
@@ -8,7 +8,13 @@
 #include "util/string.h"
 #include "version.h"
 
-#include <pqxx/pqxx> 
+#include <pqxx/pqxx>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <set>
+#include <vector>
 
 namespace beewatch
 {
@@ -17,58 +23,672 @@ namespace beewatch
     struct DB::impl : public unique_ownership_t<impl>
     {
         //==============================================================================
-        /// Construct PostgreSQL client
-        /// TODO: Allow configuration of DB user/password
-        impl(std::string host, std::string port, std::string name,
+        /**
+         * @brief Construct PostgreSQL client backed by a pool of connections
+         *
+         * One connection is opened up front so that an unreachable DB is reported
+         * immediately, the others are opened on demand.
+         *
+         * TODO: Allow configuration of DB user/password
+         */
+        impl(std::string host, std::string port, std::string name, size_t poolSize,
              std::string username = "postgres", std::string password = "postgres")
-            : _db("dbname = " + name + " " +
-                  "user = " + username + " password = " + password + " " +
-                  "hostaddr = " + host + " port = " + port)
+            : _connectionString("dbname = " + name + " " +
+                                "user = " + username + " password = " + password + " " +
+                                "hostaddr = " + host + " port = " + port),
+              _maxConnections(std::max<size_t>(poolSize, 1)), _numConnections(1),
+              _backoff(0)
+        {
+            _idle.push_back(std::make_unique<Connection>(_connectionString));
+        }
+
+        //==============================================================================
+        /**
+         * @brief Run function on a new transaction, committing it once the function returns
+         *
+         * @param [in] fn   Function to run with the transaction: fn(txn)
+         *
+         * @returns True on success, false if an exception was caught (changes are rolled back)
+         */
+        template <typename Function>
+        bool transact(Function fn)
+        {
+            try
+            {
+                withConnection([&](Connection& connection) {
+                    pqxx::work txn(connection.db);
+                    fn(txn);
+                    txn.commit();
+                });
+
+                return true;
+            }
+            catch (std::exception& e)
+            {
+                g_logger.error("Caught exception while executing DB transaction: " +
+                               std::string(e.what()));
+
+                return false;
+            }
+        }
+
+        /// Execute statement in a single committed transaction, returning true on success
+        bool execCommand(std::string query)
         {
+            return transact([&](pqxx::work& txn) { txn.exec(query); });
         }
 
         //==============================================================================
-        /// Execute query in a single transaction and return results
-        pqxx::result exec(std::string query, bool commit)
+        /**
+         * @brief Register a parameterised query under the given name
+         *
+         * Each connection only sends the statement to the server on its first execution,
+         * after which it reuses the parsed & planned statement for every call.
+         */
+        void prepare(std::string name, std::string query)
         {
-            std::unique_lock<std::mutex> lock(_mutex);
+            std::lock_guard<std::mutex> lock(_statementMutex);
+            _statements[name] = query;
+        }
 
+        /// Execute prepared statement with the given parameters in a single transaction
+        template <typename... Args>
+        pqxx::result execPrepared(const std::string& name, bool commit, Args&&... args)
+        {
             pqxx::result results;
 
             try
             {
-                pqxx::work txn(_db);
-                results = txn.exec(query);
+                results = withConnection([&](Connection& connection) {
+                    ensurePrepared(connection, name);
+
+                    pqxx::work txn(connection.db);
+                    auto rows = txn.exec_prepared(name, args...);
+
+                    if (commit)
+                    {
+                        txn.commit();
+                    }
+
+                    return rows;
+                });
+            }
+            catch (std::exception& e)
+            {
+                g_logger.error("Caught exception while executing prepared statement \"" + name +
+                               "\": " + std::string(e.what()));
+            }
+
+            return results;
+        }
+
+        /**
+         * @brief Execute prepared statement once per row, committing all rows in a single transaction
+         *
+         * @param [in] name     Prepared statement name
+         * @param [in] rows     Rows to execute statement for
+         * @param [in] bind     Function executing the statement for one row: bind(txn, name, row)
+         *
+         * @returns True on success, false if an exception was caught (no row is committed)
+         */
+        template <typename Container, typename Binder>
+        bool execPreparedBatch(const std::string& name, const Container& rows, Binder bind)
+        {
+            try
+            {
+                withConnection([&](Connection& connection) {
+                    ensurePrepared(connection, name);
+
+                    pqxx::work txn(connection.db);
+
+                    for (const auto& row : rows)
+                    {
+                        bind(txn, name, row);
+                    }
+
+                    txn.commit();
+                });
 
-                if (commit)
+                return true;
+            }
+            catch (std::exception& e)
+            {
+                g_logger.error("Caught exception while executing prepared statement batch \"" + name +
+                               "\": " + std::string(e.what()));
+
+                return false;
+            }
+        }
+
+        //==============================================================================
+        /**
+         * @brief Run query through a server-side cursor, fetching its rows in fixed-size batches
+         *
+         * Only one batch of rows is held in memory at a time, so the result size is unbounded.
+         * The read isn't retried if the connection drops, since batches were already visited.
+         *
+         * @param [in] query        Query to declare cursor for
+         * @param [in] batchSize    Number of rows per fetch
+         * @param [in] visit        Function called with each batch: visit(rows), returning false to stop
+         *
+         * @returns True on success, false if an exception was caught
+         */
+        template <typename Visitor>
+        bool execCursor(const std::string& query, size_t batchSize, Visitor visit)
+        {
+            try
+            {
+                auto connection = acquire();
+
+                try
                 {
+                    pqxx::work txn(connection->db);
+
+                    txn.exec("DECLARE read_cursor NO SCROLL CURSOR FOR " + query + ";");
+
+                    auto fetch = "FETCH FORWARD " + std::to_string(std::max<size_t>(batchSize, 1)) + " FROM read_cursor;";
+
+                    while (true)
+                    {
+                        auto rows = txn.exec(fetch);
+
+                        if (rows.empty() || !visit(rows))
+                        {
+                            break;
+                        }
+                    }
+
+                    txn.exec("CLOSE read_cursor;");
                     txn.commit();
                 }
+                catch (const pqxx::broken_connection&)
+                {
+                    discard(*connection);
+                    throw;
+                }
+
+                return true;
             }
             catch (std::exception& e)
             {
-                g_logger.error("Caught exception while executing DB transaction: " +
-                               std::string(e.what()));
+                g_logger.error("Caught exception while reading through DB cursor: " + std::string(e.what()));
+                return false;
             }
+        }
 
-            return results;
+        /// Quote value for use as a literal in a query
+        template <typename T>
+        std::string quote(const T& value)
+        {
+            return withConnection([&](Connection& connection) { return connection.db.quote(value); });
         }
 
     private:
         //==============================================================================
-        /// PostgreSQL database connection
-        pqxx::connection _db;
+        /**
+         * @struct Connection
+         *
+         * Pooled connection & the prepared statements it knows about
+         */
+        struct Connection
+        {
+            Connection(const std::string& connectionString)
+                : db(connectionString), lastUsed(std::chrono::steady_clock::now())
+            {
+            }
+
+            pqxx::connection db;
+
+            /// Names of statements already prepared on this connection
+            std::set<std::string> preparedStatements;
+
+            std::chrono::steady_clock::time_point lastUsed;
+        };
+
+        /**
+         * @class Lease
+         *
+         * Exclusive use of a pooled connection, returned to the pool on destruction
+         */
+        class Lease
+        {
+        public:
+            Lease(impl& pool, std::unique_ptr<Connection> connection)
+                : _pool(pool), _connection(std::move(connection))
+            {
+            }
+
+            ~Lease()
+            {
+                _pool.release(std::move(_connection));
+            }
+
+            Lease(const Lease&) = delete;
+            Lease& operator=(const Lease&) = delete;
+
+            Connection& operator*() const { return *_connection; }
+            Connection * operator->() const { return _connection.get(); }
+
+        private:
+            impl& _pool;
+            std::unique_ptr<Connection> _connection;
+        };
+
+        //==============================================================================
+        /**
+         * @brief Take a healthy connection from the pool, opening a new one if needed
+         *
+         * Blocks while all connections are in use.
+         *
+         * @throws pqxx::broken_connection if no connection could be opened
+         */
+        Lease acquire()
+        {
+            std::unique_lock<std::mutex> lock(_poolMutex);
+
+            _poolCondition.wait(lock, [this]() { return !_idle.empty() || _numConnections < _maxConnections; });
+
+            // Reuse most recently used connection, dropping any that fail their health check
+            while (!_idle.empty())
+            {
+                auto connection = std::move(_idle.back());
+                _idle.pop_back();
+
+                bool mustCheck = connection->lastUsed < _lastFailure ||
+                                 std::chrono::steady_clock::now() - connection->lastUsed > HEALTH_CHECK_INTERVAL;
 
-        /// Transaction mutex
-        std::mutex _mutex;
+                lock.unlock();
+                bool isHealthy = isAlive(*connection, mustCheck);
+                lock.lock();
+
+                if (isHealthy)
+                {
+                    return Lease(*this, std::move(connection));
+                }
+
+                _numConnections--;
+            }
+
+            // Open new connection, unless still backing off after a failed attempt
+            auto now = std::chrono::steady_clock::now();
+
+            if (now < _nextConnectTime)
+            {
+                auto waitMs = std::chrono::duration_cast<std::chrono::milliseconds>(_nextConnectTime - now).count();
+                throw pqxx::broken_connection("DB unreachable, next connection attempt in " + std::to_string(waitMs) + " ms");
+            }
+
+            _numConnections++;
+            lock.unlock();
+
+            try
+            {
+                auto connection = std::make_unique<Connection>(_connectionString);
+
+                lock.lock();
+                _backoff = std::chrono::milliseconds(0);
+
+                return Lease(*this, std::move(connection));
+            }
+            catch (const std::exception& e)
+            {
+                if (!lock.owns_lock())
+                    lock.lock();
+
+                // Back off exponentially until the DB is reachable again
+                _numConnections--;
+                _backoff = std::min(std::max(2 * _backoff, MIN_BACKOFF), MAX_BACKOFF);
+                _nextConnectTime = std::chrono::steady_clock::now() + _backoff;
+                _poolCondition.notify_one();
+
+                g_logger.warning("Failed to connect to DB, retrying in " + std::to_string(_backoff.count()) +
+                                 " ms: " + std::string(e.what()));
+
+                throw;
+            }
+        }
+
+        /// Return connection to pool, dropping it if it was closed
+        void release(std::unique_ptr<Connection> connection)
+        {
+            std::lock_guard<std::mutex> lock(_poolMutex);
+
+            if (connection->db.is_open())
+            {
+                connection->lastUsed = std::chrono::steady_clock::now();
+                _idle.push_back(std::move(connection));
+            }
+            else
+            {
+                _numConnections--;
+            }
+
+            _poolCondition.notify_one();
+        }
+
+        /// Close broken connection so it is dropped on release, and check idle ones before reuse
+        void discard(Connection& connection)
+        {
+            connection.db.disconnect();
+
+            std::lock_guard<std::mutex> lock(_poolMutex);
+            _lastFailure = std::chrono::steady_clock::now();
+        }
+
+        /// Check whether connection is usable, optionally with a round trip to the server
+        static bool isAlive(Connection& connection, bool roundTrip)
+        {
+            if (!connection.db.is_open())
+            {
+                return false;
+            }
+
+            if (roundTrip)
+            {
+                try
+                {
+                    pqxx::nontransaction txn(connection.db);
+                    txn.exec("SELECT 1;");
+                }
+                catch (const std::exception&)
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        /**
+         * @brief Run function with a pooled connection: fn(connection)
+         *
+         * If the connection turns out to be broken, the function is retried once on a
+         * fresh connection (the failed transaction was rolled back by the server).
+         */
+        template <typename Function>
+        auto withConnection(Function fn)
+        {
+            for (int attempt = 0; ; ++attempt)
+            {
+                auto connection = acquire();
+
+                try
+                {
+                    return fn(*connection);
+                }
+                catch (const pqxx::broken_connection& e)
+                {
+                    discard(*connection);
+
+                    if (attempt > 0)
+                    {
+                        throw;
+                    }
+
+                    g_logger.warning("Lost DB connection, retrying on a new one: " + std::string(e.what()));
+                }
+            }
+        }
+
+        /// Prepare statement on connection if this is its first use there
+        void ensurePrepared(Connection& connection, const std::string& name)
+        {
+            if (connection.preparedStatements.find(name) == connection.preparedStatements.end())
+            {
+                std::string query;
+
+                {
+                    std::lock_guard<std::mutex> lock(_statementMutex);
+                    query = _statements.at(name);
+                }
+
+                connection.db.prepare(name, query);
+                connection.preparedStatements.insert(name);
+            }
+        }
+
+        //==============================================================================
+        static constexpr std::chrono::milliseconds MIN_BACKOFF { 500 };
+        static constexpr std::chrono::milliseconds MAX_BACKOFF { 30'000 };
+
+        /// Idle connections are checked with a round trip before reuse past this interval
+        static constexpr std::chrono::seconds HEALTH_CHECK_INTERVAL { 30 };
+
+        //==============================================================================
+        std::string _connectionString;
+
+        /// Connection pool
+        std::mutex _poolMutex;
+        std::condition_variable _poolCondition;
+
+        std::vector<std::unique_ptr<Connection>> _idle;
+
+        size_t _maxConnections;
+        size_t _numConnections;
+
+        /// Reconnection backoff state
+        std::chrono::milliseconds _backoff;
+        std::chrono::steady_clock::time_point _nextConnectTime;
+
+        /// Last time a broken connection was detected
+        std::chrono::steady_clock::time_point _lastFailure;
+
+        //==============================================================================
+        /// Registered prepared statements (name -> query)
+        std::mutex _statementMutex;
+        std::map<std::string, std::string> _statements;
     };
 
+    constexpr std::chrono::milliseconds DB::impl::MIN_BACKOFF;
+    constexpr std::chrono::milliseconds DB::impl::MAX_BACKOFF;
+    constexpr std::chrono::seconds DB::impl::HEALTH_CHECK_INTERVAL;
+
     //==============================================================================
-    DB::DB(std::string name, std::string host, uint16_t port)
-        : _name(name), _host(host), _port(port)
+    // Prepared statement names
+    namespace statement
+    {
+        static constexpr auto GET_CLIMATE_DATA        = "get_climate_data";
+        static constexpr auto GET_CLIMATE_DATA_MULTI  = "get_climate_data_multi";
+        static constexpr auto ADD_CLIMATE_DATA        = "add_climate_data";
+        static constexpr auto GET_CLIMATE_WATERMARKS  = "get_climate_watermarks";
+        static constexpr auto GET_LATEST_CLIMATE_DATA = "get_latest_climate_data";
+        static constexpr auto GET_CLIMATE_AGGREGATES  = "get_climate_aggregates";
+        static constexpr auto ADD_CLIMATE_AGGREGATE   = "add_climate_aggregate";
+        static constexpr auto ADD_SENSOR              = "add_sensor";
+        static constexpr auto GET_NAME                = "get_name";
+        static constexpr auto SET_NAME                = "set_name";
+    }
+
+    //==============================================================================
+    /**
+     * Climate data schema migrations, applied in order on construction. The migration
+     * at index i brings the schema from version i to version i + 1.
+     */
+    static const std::vector<std::string> climateSchemaMigrations = {
+        // Version 1: arbitrary-precision values, free-form sensor IDs & no index
+        "CREATE TABLE IF NOT EXISTS ClimateData ("
+        "  rowguid         SERIAL          PRIMARY KEY     NOT NULL,"
+        "  SensorID        VARCHAR(256)                    NOT NULL,"
+        "  Time            BIGINT                          NOT NULL,"
+        "  Temperature     NUMERIC                         NOT NULL,"
+        "  Humidity        NUMERIC                         NOT NULL"
+        "  )"
+        ";",
+
+        // Version 2: native float columns, sensor IDs interned in a lookup table & a
+        // BRIN index on (sensor, time), which stays tiny since rows are appended in time order
+        "CREATE TABLE Sensors ("
+        "  SensorKey       SERIAL          PRIMARY KEY     NOT NULL,"
+        "  Name            VARCHAR(256)    UNIQUE          NOT NULL"
+        "  )"
+        ";"
+        "INSERT INTO Sensors (Name)"
+        "  SELECT DISTINCT SensorID FROM ClimateData"
+        ";"
+        "ALTER TABLE ClimateData ADD COLUMN SensorKey INTEGER;"
+        "UPDATE ClimateData SET SensorKey = Sensors.SensorKey"
+        "  FROM Sensors"
+        "  WHERE Sensors.Name = ClimateData.SensorID"
+        ";"
+        "ALTER TABLE ClimateData"
+        "  DROP COLUMN rowguid,"
+        "  DROP COLUMN SensorID,"
+        "  ALTER COLUMN SensorKey SET NOT NULL,"
+        "  ALTER COLUMN Temperature TYPE REAL USING Temperature::REAL,"
+        "  ALTER COLUMN Humidity TYPE REAL USING Humidity::REAL"
+        ";"
+        "CREATE INDEX ClimateData_SensorKey_Time ON ClimateData USING BRIN (SensorKey, Time);",
+
+        // Version 3: B-tree index on (sensor, time), so pages of samples are read from their
+        // first row instead of sorting every block the BRIN index matches
+        "DROP INDEX ClimateData_SensorKey_Time;"
+        "CREATE INDEX ClimateData_SensorKey_Time ON ClimateData (SensorKey, Time);",
+
+        // Version 4: closed buckets of the rollup tiers, so that they are restored on startup
+        // instead of being recomputed from every sample
+        "CREATE TABLE ClimateAggregates ("
+        "  SensorKey       INTEGER                         NOT NULL,"
+        "  Period          BIGINT                          NOT NULL,"
+        "  Time            BIGINT                          NOT NULL,"
+        "  Count           INTEGER                         NOT NULL,"
+        "  MinTemperature  DOUBLE PRECISION                NOT NULL,"
+        "  MinHumidity     DOUBLE PRECISION                NOT NULL,"
+        "  MaxTemperature  DOUBLE PRECISION                NOT NULL,"
+        "  MaxHumidity     DOUBLE PRECISION                NOT NULL,"
+        "  MeanTemperature DOUBLE PRECISION                NOT NULL,"
+        "  MeanHumidity    DOUBLE PRECISION                NOT NULL,"
+        "  PRIMARY KEY (SensorKey, Period, Time)"
+        "  )"
+        ";",
+    };
+
+    //==============================================================================
+    constexpr size_t IDB::DEFAULT_BATCH_SIZE;
+    constexpr int64_t IDB::MAX_TIMESTAMP;
+
+    //==============================================================================
+    DB::DB(std::string name, std::string host, uint16_t port, size_t poolSize)
+        : _isClimateSchemaReady(false), _hasAboutTable(false),
+          _name(name), _host(host), _port(port)
     {
         // Create client for given host & database
-        pimpl = new impl(_host, std::to_string(port), _name);
+        pimpl = new impl(_host, std::to_string(port), _name, poolSize);
+
+        // Register hot queries so they are only parsed & planned once per connection
+        pimpl->prepare(statement::GET_CLIMATE_DATA,
+                       "SELECT Time, Temperature, Humidity"
+                       "  FROM ClimateData"
+                       "  WHERE SensorKey = (SELECT SensorKey FROM Sensors WHERE Name = $1)"
+                       "  AND Time >= $2"
+                       "  ORDER BY Time"
+                       ";");
+
+        // Each sensor's page is an index range scan stopping after $4 rows (NULL, i.e. 0, meaning all)
+        pimpl->prepare(statement::GET_CLIMATE_DATA_MULTI,
+                       "SELECT Sensors.Name, Samples.Time, Samples.Temperature, Samples.Humidity"
+                       "  FROM Sensors"
+                       "  CROSS JOIN LATERAL ("
+                       "    SELECT Time, Temperature, Humidity"
+                       "      FROM ClimateData"
+                       "      WHERE ClimateData.SensorKey = Sensors.SensorKey"
+                       "      AND Time >= $2"
+                       "      AND Time < $3"
+                       "      ORDER BY Time"
+                       "      LIMIT NULLIF($4::BIGINT, 0)"
+                       "    ) AS Samples"
+                       "  WHERE Sensors.Name = ANY($1::VARCHAR[])"
+                       "  ORDER BY Sensors.SensorKey, Samples.Time"
+                       ";");
+
+        pimpl->prepare(statement::ADD_CLIMATE_DATA,
+                       "INSERT INTO ClimateData ("
+                       "    SensorKey,"
+                       "    Time,"
+                       "    Temperature,"
+                       "    Humidity"
+                       "  )"
+                       "  VALUES ($1, $2, $3, $4)"
+                       ";");
+
+        // Counting is an index-only scan per sensor, no samples are sent
+        pimpl->prepare(statement::GET_CLIMATE_WATERMARKS,
+                       "SELECT Sensors.Name, Stats.Count, Stats.LastTime"
+                       "  FROM Sensors"
+                       "  CROSS JOIN LATERAL ("
+                       "    SELECT COUNT(*) AS Count, MAX(Time) AS LastTime"
+                       "      FROM ClimateData"
+                       "      WHERE ClimateData.SensorKey = Sensors.SensorKey"
+                       "    ) AS Stats"
+                       "  WHERE Sensors.Name = ANY($1::VARCHAR[])"
+                       "  AND Stats.Count > 0"
+                       ";");
+
+        // Each sensor's page is a backward index range scan stopping after $2 rows
+        pimpl->prepare(statement::GET_LATEST_CLIMATE_DATA,
+                       "SELECT Sensors.Name, Samples.Time, Samples.Temperature, Samples.Humidity"
+                       "  FROM Sensors"
+                       "  CROSS JOIN LATERAL ("
+                       "    SELECT Time, Temperature, Humidity"
+                       "      FROM ClimateData"
+                       "      WHERE ClimateData.SensorKey = Sensors.SensorKey"
+                       "      ORDER BY Time DESC"
+                       "      LIMIT $2"
+                       "    ) AS Samples"
+                       "  WHERE Sensors.Name = ANY($1::VARCHAR[])"
+                       "  ORDER BY Sensors.SensorKey, Samples.Time"
+                       ";");
+
+        pimpl->prepare(statement::GET_CLIMATE_AGGREGATES,
+                       "SELECT Time, Count,"
+                       "    MinTemperature, MinHumidity,"
+                       "    MaxTemperature, MaxHumidity,"
+                       "    MeanTemperature, MeanHumidity"
+                       "  FROM ClimateAggregates"
+                       "  WHERE SensorKey = (SELECT SensorKey FROM Sensors WHERE Name = $1)"
+                       "  AND Period = $2"
+                       "  ORDER BY Time"
+                       ";");
+
+        pimpl->prepare(statement::ADD_CLIMATE_AGGREGATE,
+                       "INSERT INTO ClimateAggregates ("
+                       "    SensorKey,"
+                       "    Period,"
+                       "    Time,"
+                       "    Count,"
+                       "    MinTemperature,"
+                       "    MinHumidity,"
+                       "    MaxTemperature,"
+                       "    MaxHumidity,"
+                       "    MeanTemperature,"
+                       "    MeanHumidity"
+                       "  )"
+                       "  VALUES ($1, $2, $3, $4, $5, $6, $7, $8, $9, $10)"
+                       "  ON CONFLICT (SensorKey, Period, Time) DO UPDATE SET"
+                       "    Count = EXCLUDED.Count,"
+                       "    MinTemperature = EXCLUDED.MinTemperature,"
+                       "    MinHumidity = EXCLUDED.MinHumidity,"
+                       "    MaxTemperature = EXCLUDED.MaxTemperature,"
+                       "    MaxHumidity = EXCLUDED.MaxHumidity,"
+                       "    MeanTemperature = EXCLUDED.MeanTemperature,"
+                       "    MeanHumidity = EXCLUDED.MeanHumidity"
+                       ";");
+
+        pimpl->prepare(statement::ADD_SENSOR,
+                       "INSERT INTO Sensors (Name)"
+                       "  VALUES ($1)"
+                       "  ON CONFLICT (Name) DO UPDATE SET Name = EXCLUDED.Name"
+                       "  RETURNING SensorKey"
+                       ";");
+
+        pimpl->prepare(statement::GET_NAME,
+                       "SELECT Name FROM About;");
+
+        pimpl->prepare(statement::SET_NAME,
+                       "UPDATE About SET Name = $1;");
+
+        // Create & migrate schema once up front so that queries never need to check for it
+        ensureClimateSchema();
+        ensureAboutTable();
     }
 
     DB::~DB()
@@ -77,44 +697,59 @@ namespace beewatch
     }
     
     //==============================================================================
-    bool DB::hasTable(std::string name)
+    void DB::ensureClimateSchema()
     {
-        // Query information table for given table name
-        auto query = "SELECT 1"
-                     "  FROM   pg_tables"
-                     "  WHERE  tablename = '" + string::tolower(name) + "'"
-                     ";";
+        if (_isClimateSchemaReady)
+        {
+            return;
+        }
 
-        auto results = pimpl->exec(query, false);
+        // Apply any migration newer than the DB's schema version in a single transaction
+        _isClimateSchemaReady = pimpl->transact([](pqxx::work& txn) {
+            txn.exec("CREATE TABLE IF NOT EXISTS SchemaVersion ("
+                     "  Version         INTEGER                         NOT NULL"
+                     "  )"
+                     ";"
+                     "LOCK TABLE SchemaVersion IN EXCLUSIVE MODE;");
 
-        return !results.empty();
-    }
+            auto results = txn.exec("SELECT COALESCE(MAX(Version), 0) FROM SchemaVersion;");
+            size_t version = results[0][0].as<size_t>();
 
-    void DB::createClimateDataTable()
-    {
-        // Create ClimateData table with unqualified schema
-        auto query = "CREATE TABLE ClimateData ("
-                     "  rowguid         SERIAL          PRIMARY KEY     NOT NULL,"
-                     "  SensorID        VARCHAR(256)                    NOT NULL,"
-                     "  Time            BIGINT                          NOT NULL,"
-                     "  Temperature     NUMERIC                         NOT NULL,"
-                     "  Humidity        NUMERIC                         NOT NULL"
-                     "  )"
-                     ";";
+            if (version > climateSchemaMigrations.size())
+            {
+                g_logger.warning("DB schema version " + std::to_string(version) + " is newer than "
+                                 "supported version " + std::to_string(climateSchemaMigrations.size()));
+            }
 
-        pimpl->exec(query, true);
+            for (; version < climateSchemaMigrations.size(); ++version)
+            {
+                g_logger.info("Migrating DB schema to version " + std::to_string(version + 1));
+
+                txn.exec(climateSchemaMigrations[version]);
+                txn.exec("INSERT INTO SchemaVersion (Version) VALUES (" + std::to_string(version + 1) + ");");
+            }
+        });
     }
 
-    void DB::createAboutTable()
+    void DB::ensureAboutTable()
     {
-        // Create About table with unqualified schema
-        auto query = "CREATE TABLE About ("
+        if (_hasAboutTable)
+        {
+            return;
+        }
+
+        // Create About table with unqualified schema, holding a single row with the default name
+        auto query = "CREATE TABLE IF NOT EXISTS About ("
                      "  rowguid         SERIAL          PRIMARY KEY     NOT NULL,"
                      "  Name            VARCHAR(256)                    NOT NULL"
                      "  )"
+                     ";"
+                     "INSERT INTO About (Name)"
+                     "  SELECT '" PROJECT_NAME "'"
+                     "  WHERE NOT EXISTS (SELECT 1 FROM About)"
                      ";";
 
-        pimpl->exec(query, true);
+        _hasAboutTable = pimpl->execCommand(query);
     }
     
     //==============================================================================
@@ -126,92 +761,341 @@ namespace beewatch
 
     void DB::clearClimateData()
     {
-        // Drop ClimateData table
-        auto query = "DROP TABLE ClimateData;";
-        pimpl->exec(query, true);
+        // Empty climate tables, keeping their schema, indices & sensor keys
+        auto query = "TRUNCATE TABLE ClimateData, ClimateAggregates;";
+
+        pimpl->execCommand(query);
     }
 
     void DB::clearAboutData()
     {
-        // Drop About table
-        auto query = "DROP TABLE About;";
-        pimpl->exec(query, true);
+        // Drop About table, recreating it on next use
+        auto query = "DROP TABLE IF EXISTS About;";
+
+        _hasAboutTable = false;
+        pimpl->execCommand(query);
     }
 
     //==============================================================================
-    std::map<int64_t, ClimateData<double>> DB::getClimateData(std::string sensorID, int64_t since)
+    ClimateSeries DB::getClimateData(std::string sensorID, int64_t since)
+    {
+        ensureClimateSchema();
+
+        // Find all data in "ClimateData" table with timestamps >= since (rows are ordered by time)
+        auto results = pimpl->execPrepared(statement::GET_CLIMATE_DATA, false, sensorID, since);
+
+        // Get sample data from results
+        ClimateSeries data;
+        data.reserve(results.size());
+
+        for (auto row : results)
+        {
+            data.timestamps.push_back(row[0].as<int64_t>());
+            data.temperature.push_back(row[1].as<double>());
+            data.humidity.push_back(row[2].as<double>());
+        }
+
+        return data;
+    }
+
+    /// Format strings as a PostgreSQL array literal, e.g. {"a","b\"c"}
+    static std::string toArrayLiteral(const std::vector<std::string>& values)
+    {
+        std::string literal = "{";
+
+        for (const auto& value : values)
+        {
+            if (literal.size() > 1)
+                literal += ',';
+
+            literal += '"';
+
+            for (char c : value)
+            {
+                if (c == '"' || c == '\\')
+                    literal += '\\';
+
+                literal += c;
+            }
+
+            literal += '"';
+        }
+
+        return literal + "}";
+    }
+
+    std::map<std::string, ClimateSeries> DB::getClimateData(const std::vector<std::string>& sensorIDs,
+                                                            int64_t since, int64_t until, size_t limit)
     {
-        // If ClimateData table does not exist, create it and return (no results stored yet)
-        if (!hasTable("ClimateData"))
+        ensureClimateSchema();
+
+        std::map<std::string, ClimateSeries> data;
+
+        if (sensorIDs.empty())
         {
-            createClimateDataTable();
-            return {};
+            return data;
         }
 
-        // Find all data in "ClimateData" table with timestamps >= since
+        // One round trip for all sensors instead of one per sensor (rows are grouped by sensor & ordered by time)
+        auto results = pimpl->execPrepared(statement::GET_CLIMATE_DATA_MULTI, false,
+                                           toArrayLiteral(sensorIDs), since, until, (int64_t)limit);
+
+        ClimateSeries * series = nullptr;
+        std::string sensorID;
+
+        for (auto row : results)
+        {
+            if (!series || sensorID != row[0].c_str())
+            {
+                sensorID = row[0].c_str();
+                series = &data[sensorID];
+            }
+
+            series->timestamps.push_back(row[1].as<int64_t>());
+            series->temperature.push_back(row[2].as<double>());
+            series->humidity.push_back(row[3].as<double>());
+        }
+
+        return data;
+    }
+
+    void DB::visitClimateData(std::string sensorID, int64_t since, const ClimateVisitor& visit, size_t batchSize)
+    {
+        ensureClimateSchema();
+
+        // Cursors can't be declared for prepared statements, so parameters are quoted inline
         auto query = "SELECT Time, Temperature, Humidity"
                      "  FROM ClimateData"
-                     "  WHERE SensorID = '" + sensorID + "'"
+                     "  WHERE SensorKey = (SELECT SensorKey FROM Sensors WHERE Name = " + pimpl->quote(sensorID) + ")"
                      "  AND Time >= " + std::to_string(since) +
-                     ";";
+                     "  ORDER BY Time";
 
-        auto results = pimpl->exec(query, false);
+        ClimateSeries batch;
+        batch.reserve(batchSize);
 
-        // Get sample data from results
-        std::map<int64_t, ClimateData<double>> data;
+        pimpl->execCursor(query, batchSize, [&](const pqxx::result& rows) {
+            batch.clear();
+
+            for (auto row : rows)
+            {
+                batch.timestamps.push_back(row[0].as<int64_t>());
+                batch.temperature.push_back(row[1].as<double>());
+                batch.humidity.push_back(row[2].as<double>());
+            }
+
+            return visit(batch);
+        });
+    }
+
+    void DB::addClimateData(std::string sensorID, int64_t timestamp, ClimateData<double> data)
+    {
+        ensureClimateSchema();
+
+        int sensorKey = getSensorKey(sensorID);
+
+        if (sensorKey < 0)
+        {
+            return;
+        }
+
+        // Insert sample using prepared statement
+        pimpl->execPrepared(statement::ADD_CLIMATE_DATA, true,
+                            sensorKey,                  // INTEGER
+                            timestamp,                  // BIGINT
+                            data.temperature,           // REAL
+                            data.humidity);             // REAL
+    }
+
+    bool DB::addClimateData(const std::vector<ClimateSample>& samples)
+    {
+        if (samples.empty())
+        {
+            return true;
+        }
+
+        ensureClimateSchema();
+
+        // Resolve sensor keys before opening the insert transaction (failing if the DB is unreachable)
+        std::map<std::string, int> sensorKeys;
+
+        for (const auto& sample : samples)
+        {
+            if (sensorKeys.find(sample.sensorID) == sensorKeys.end())
+            {
+                int sensorKey = getSensorKey(sample.sensorID);
+
+                if (sensorKey < 0)
+                {
+                    return false;
+                }
+
+                sensorKeys[sample.sensorID] = sensorKey;
+            }
+        }
+
+        // Insert all samples in a single transaction
+        return pimpl->execPreparedBatch(statement::ADD_CLIMATE_DATA, samples,
+            [&](pqxx::work& txn, const std::string& name, const ClimateSample& sample) {
+                txn.exec_prepared(name,
+                                  sensorKeys.at(sample.sensorID),   // INTEGER
+                                  sample.timestamp,                 // BIGINT
+                                  sample.data.temperature,          // REAL
+                                  sample.data.humidity);            // REAL
+            });
+    }
+
+    std::map<std::string, ClimateWatermark> DB::getClimateWatermarks(const std::vector<std::string>& sensorIDs)
+    {
+        ensureClimateSchema();
+
+        std::map<std::string, ClimateWatermark> watermarks;
+
+        if (sensorIDs.empty())
+        {
+            return watermarks;
+        }
+
+        auto results = pimpl->execPrepared(statement::GET_CLIMATE_WATERMARKS, false, toArrayLiteral(sensorIDs));
+
+        for (auto row : results)
+        {
+            auto& watermark = watermarks[row[0].c_str()];
+
+            watermark.count = row[1].as<uint64_t>();
+            watermark.lastTimestamp = row[2].as<int64_t>();
+        }
+
+        return watermarks;
+    }
+
+    std::map<std::string, ClimateSeries> DB::getLatestClimateData(const std::vector<std::string>& sensorIDs,
+                                                                  size_t limit)
+    {
+        ensureClimateSchema();
+
+        std::map<std::string, ClimateSeries> data;
+
+        if (sensorIDs.empty() || limit == 0)
+        {
+            return data;
+        }
+
+        // Rows are grouped by sensor & ordered by time
+        auto results = pimpl->execPrepared(statement::GET_LATEST_CLIMATE_DATA, false,
+                                           toArrayLiteral(sensorIDs), (int64_t)limit);
+
+        ClimateSeries * series = nullptr;
+        std::string sensorID;
 
         for (auto row : results)
         {
-            int64_t timestamp = row[0].as<int64_t>();
+            if (!series || sensorID != row[0].c_str())
+            {
+                sensorID = row[0].c_str();
+                series = &data[sensorID];
+            }
 
-            data[timestamp].temperature = row[1].as<double>();
-            data[timestamp].humidity = row[2].as<double>();
+            series->timestamps.push_back(row[1].as<int64_t>());
+            series->temperature.push_back(row[2].as<double>());
+            series->humidity.push_back(row[3].as<double>());
         }
 
         return data;
     }
 
-    void DB::addClimateData(std::string sensorID, int64_t timestamp, ClimateData<double> data)
+    std::map<int64_t, ClimateAggregate> DB::getClimateAggregates(std::string sensorID, int64_t period)
+    {
+        ensureClimateSchema();
+
+        auto results = pimpl->execPrepared(statement::GET_CLIMATE_AGGREGATES, false, sensorID, period);
+
+        std::map<int64_t, ClimateAggregate> aggregates;
+
+        for (auto row : results)
+        {
+            auto& aggregate = aggregates[row[0].as<int64_t>()];
+
+            aggregate.count = row[1].as<uint32_t>();
+            aggregate.min.temperature = row[2].as<double>();
+            aggregate.min.humidity = row[3].as<double>();
+            aggregate.max.temperature = row[4].as<double>();
+            aggregate.max.humidity = row[5].as<double>();
+            aggregate.mean.temperature = row[6].as<double>();
+            aggregate.mean.humidity = row[7].as<double>();
+        }
+
+        return aggregates;
+    }
+
+    bool DB::addClimateAggregates(std::string sensorID, int64_t period,
+                                  const std::map<int64_t, ClimateAggregate>& aggregates)
     {
-        // If ClimateData table does not exist, create it and add data
-        if (!hasTable("ClimateData"))
+        if (aggregates.empty())
         {
-            createClimateDataTable();
+            return true;
         }
 
-        // Build document for given data
-        auto query = "INSERT INTO ClimateData ("
-                     "    SensorID,"
-                     "    Time,"
-                     "    Temperature,"
-                     "    Humidity"
-                     "  )"
-                     "  VALUES ("
-                     "    '" + sensorID.substr(0, 256) + "',"         // VARCHAR(256)
-                     "    " + std::to_string(timestamp) + ","         // INT
-                     "    " + std::to_string(data.temperature) + ","  // NUMERIC
-                     "    " + std::to_string(data.humidity) +         // NUMERIC
-                     "  )"
-                     ";";
+        ensureClimateSchema();
 
-        auto results = pimpl->exec(query, true);
+        int sensorKey = getSensorKey(sensorID);
+
+        if (sensorKey < 0)
+        {
+            return false;
+        }
+
+        // Upsert all buckets in a single transaction
+        return pimpl->execPreparedBatch(statement::ADD_CLIMATE_AGGREGATE, aggregates,
+            [&](pqxx::work& txn, const std::string& name, const std::pair<const int64_t, ClimateAggregate>& bucket) {
+                const auto& aggregate = bucket.second;
+
+                txn.exec_prepared(name,
+                                  sensorKey,                        // INTEGER
+                                  period,                           // BIGINT
+                                  bucket.first,                     // BIGINT
+                                  (int64_t)aggregate.count,         // INTEGER
+                                  aggregate.min.temperature,        // DOUBLE PRECISION
+                                  aggregate.min.humidity,           // DOUBLE PRECISION
+                                  aggregate.max.temperature,        // DOUBLE PRECISION
+                                  aggregate.max.humidity,           // DOUBLE PRECISION
+                                  aggregate.mean.temperature,       // DOUBLE PRECISION
+                                  aggregate.mean.humidity);         // DOUBLE PRECISION
+            });
     }
 
-    //==============================================================================
-    std::string DB::getName()
+    int DB::getSensorKey(const std::string& sensorID)
     {
-        // If About table does not exist, create it, then store & return the default name
-        if (!hasTable("About"))
+        std::lock_guard<std::mutex> lock(_sensorKeyMutex);
+
+        auto itKey = _sensorKeys.find(sensorID);
+
+        if (itKey != _sensorKeys.end())
         {
-            createAboutTable();
-            setName(PROJECT_NAME);
+            return itKey->second;
+        }
+
+        // Register sensor on first use
+        auto results = pimpl->execPrepared(statement::ADD_SENSOR, true, sensorID.substr(0, 256));
 
-            return PROJECT_NAME;
+        if (results.empty())
+        {
+            g_logger.error("Failed to register sensor \"" + sensorID + "\" in DB");
+            return -1;
         }
 
+        int sensorKey = results[0][0].as<int>();
+        _sensorKeys[sensorID] = sensorKey;
+
+        return sensorKey;
+    }
+
+    //==============================================================================
+    std::string DB::getName()
+    {
+        ensureAboutTable();
+
         // Find name in "About" table
-        auto query = "SELECT Name FROM About;";
-        auto results = pimpl->exec(query, false);
+        auto results = pimpl->execPrepared(statement::GET_NAME, false);
 
         // Always use the first match (there should only ever be one row, but who knows!)
         if (results.size() > 0)
@@ -227,15 +1111,10 @@ namespace beewatch
 
     void DB::setName(std::string name)
     {
-        // If About table does not exist, create it and save the given name
-        if (!hasTable("About"))
-        {
-            createAboutTable();
-        }
+        ensureAboutTable();
 
         // Update row in "About" table
-        auto query = "UPDATE About SET Name = " + name + ";";
-        auto results = pimpl->exec(query, true);
+        pimpl->execPrepared(statement::SET_NAME, true, name.substr(0, 256));
     }
 
 } // namespace beewatch
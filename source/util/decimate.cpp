@@ -0,0 +1,101 @@
+//==============================================================================
+// Copyright (c) 2018 Eric Seguin, all rights reserved.
+//==============================================================================
+
+#include "util/decimate.h"
+
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+namespace beewatch
+{
+
+    //==============================================================================
+    ClimateSeries decimateLTTB(const ClimateSeries& series, size_t points)
+    {
+        if (points < 3)
+        {
+            throw std::invalid_argument("Cannot decimate series to less than 3 points (got " +
+                                        std::to_string(points) + ")");
+        }
+
+        const size_t size = series.size();
+
+        if (size <= points)
+        {
+            return series;
+        }
+
+        ClimateSeries result;
+        result.reserve(points);
+
+        // Times are taken relative to the first sample to keep precision in doubles
+        const int64_t origin = series.timestamps.front();
+
+        auto time = [&](size_t index) { return double(series.timestamps[index] - origin); };
+
+        // First & last samples are always kept; the others are split into buckets
+        const size_t numBuckets = points - 2;
+
+        auto bucketStart = [&](size_t bucket) { return bucket * (size - 2) / numBuckets + 1; };
+
+        size_t selected = 0;
+        result.push_back(series.timestamps[0], series.data(0));
+
+        for (size_t bucket = 0; bucket < numBuckets; ++bucket)
+        {
+            // Average of next bucket (or last sample, for the final bucket)
+            size_t nextBegin = bucketStart(bucket + 1);
+            size_t nextEnd = bucket + 1 < numBuckets ? bucketStart(bucket + 2) : size;
+
+            double avgTime = 0.0, avgTemperature = 0.0, avgHumidity = 0.0;
+
+            for (size_t i = nextBegin; i < nextEnd; ++i)
+            {
+                avgTime += time(i);
+                avgTemperature += series.temperature[i];
+                avgHumidity += series.humidity[i];
+            }
+
+            double count = double(nextEnd - nextBegin);
+
+            avgTime /= count;
+            avgTemperature /= count;
+            avgHumidity /= count;
+
+            // Keep sample forming largest triangle with previously kept sample & next average
+            const double selectedTime = time(selected);
+            const double selectedTemperature = series.temperature[selected];
+            const double selectedHumidity = series.humidity[selected];
+
+            double maxArea = -1.0;
+            size_t maxIndex = bucketStart(bucket);
+
+            for (size_t i = bucketStart(bucket); i < nextBegin; ++i)
+            {
+                double dt = selectedTime - avgTime;
+                double dtSample = selectedTime - time(i);
+
+                double area = std::abs(dt * (series.temperature[i] - selectedTemperature) -
+                                       dtSample * (avgTemperature - selectedTemperature)) +
+                              std::abs(dt * (series.humidity[i] - selectedHumidity) -
+                                       dtSample * (avgHumidity - selectedHumidity));
+
+                if (area > maxArea)
+                {
+                    maxArea = area;
+                    maxIndex = i;
+                }
+            }
+
+            selected = maxIndex;
+            result.push_back(series.timestamps[selected], series.data(selected));
+        }
+
+        result.push_back(series.timestamps[size - 1], series.data(size - 1));
+
+        return result;
+    }
+
+} // namespace beewatch
@@ -0,0 +1,1237 @@
+//==============================================================================
+// Copyright (c) 2018 Eric Seguin, all rights reserved.
+//==============================================================================
+
+#include "util/embedded_db.h"
+
+#include "global/logging.h"
+#include "util/file.h"
+#include "util/gorilla.h"
+#include "version.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <shared_mutex>
+#include <sstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <boost/filesystem.hpp>
+
+namespace beewatch
+{
+
+    namespace fs = boost::filesystem;
+
+    //==============================================================================
+    /// Fixed-width climate sample record, as stored in segment files
+    struct Record
+    {
+        int64_t time;
+        float temperature;
+        float humidity;
+    };
+
+    static_assert(sizeof(Record) == 16, "Unexpected padding in segment record");
+
+    /// Segment file header, followed by the segment's records
+    struct SegmentHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t recordSize;
+        uint64_t capacity;
+        uint64_t count;
+    };
+
+    static_assert(sizeof(SegmentHeader) == 32, "Unexpected padding in segment header");
+
+    static constexpr char SEGMENT_MAGIC[8] = { 'B', 'W', 'C', 'L', 'I', 'M', 'A', 'T' };
+    static constexpr uint32_t SEGMENT_VERSION = 1;
+
+    /// Extensions of segment files & of sealed segments' chunk files
+    static constexpr auto SEGMENT_EXTENSION = ".seg";
+    static constexpr auto CHUNK_EXTENSION = ".chunk";
+
+    //==============================================================================
+    /// Fixed-width rollup aggregate record, as stored in aggregate files
+    struct AggregateRecord
+    {
+        int64_t time;
+        uint64_t count;
+
+        double minTemperature;
+        double minHumidity;
+        double maxTemperature;
+        double maxHumidity;
+        double meanTemperature;
+        double meanHumidity;
+    };
+
+    static_assert(sizeof(AggregateRecord) == 64, "Unexpected padding in aggregate record");
+
+    static constexpr auto AGGREGATE_EXTENSION = ".agg";
+
+    //==============================================================================
+    /**
+     * @class Segment
+     *
+     * Append-only segment file mapped into memory. Once full, a segment is sealed:
+     * its records are compressed into a read-only Gorilla chunk file, which
+     * replaces the segment file.
+     */
+    class Segment : public unique_ownership_t<Segment>
+    {
+    public:
+        //==============================================================================
+        /**
+         * @brief Map segment file, creating it with the given capacity if it doesn't exist
+         *
+         * Files left without a header (e.g. by a crash while creating them) are initialised
+         * as new segments, and truncated files are extended to their capacity.
+         *
+         * @throws std::runtime_error if the file cannot be created, mapped or is invalid
+         */
+        Segment(const std::string& path, size_t capacity)
+            : _path(path)
+        {
+            _fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+
+            if (_fd < 0)
+            {
+                throw std::runtime_error("Failed to open segment \"" + path + "\": " + std::strerror(errno));
+            }
+
+            struct stat info;
+
+            if (::fstat(_fd, &info) < 0)
+            {
+                ::close(_fd);
+                throw std::runtime_error("Failed to stat segment \"" + path + "\": " + std::strerror(errno));
+            }
+
+            // Header is only missing if the file was never fully created (it is zero-filled until written)
+            SegmentHeader header {};
+
+            bool isNew = (size_t)info.st_size < sizeof(header) ||
+                         ::pread(_fd, &header, sizeof(header), 0) != sizeof(header) ||
+                         std::all_of(std::begin(header.magic), std::end(header.magic), [](char c) { return c == 0; });
+
+            if (!isNew)
+            {
+                // Use the existing file's capacity, which may differ from the current setting
+                if (!std::equal(std::begin(SEGMENT_MAGIC), std::end(SEGMENT_MAGIC), header.magic) ||
+                    header.version != SEGMENT_VERSION || header.recordSize != sizeof(Record) ||
+                    header.capacity == 0 || header.capacity > MAX_CAPACITY)
+                {
+                    ::close(_fd);
+                    throw std::runtime_error("Invalid segment header in \"" + path + "\"");
+                }
+
+                capacity = header.capacity;
+            }
+
+            _mapSize = sizeof(SegmentHeader) + capacity * sizeof(Record);
+
+            // Mapping past the end of the file would fault on access, so allocate the whole segment
+            if ((size_t)info.st_size < _mapSize)
+            {
+                if (!isNew)
+                {
+                    g_logger.warning("Segment \"" + path + "\" is truncated, dropping its missing records");
+                }
+
+                if (::ftruncate(_fd, _mapSize) < 0)
+                {
+                    ::close(_fd);
+                    throw std::runtime_error("Failed to allocate segment \"" + path + "\": " + std::strerror(errno));
+                }
+            }
+
+            _map = ::mmap(nullptr, _mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+
+            if (_map == MAP_FAILED)
+            {
+                ::close(_fd);
+                throw std::runtime_error("Failed to map segment \"" + path + "\": " + std::strerror(errno));
+            }
+
+            _header = static_cast<SegmentHeader*>(_map);
+            _records = reinterpret_cast<Record*>(static_cast<char*>(_map) + sizeof(SegmentHeader));
+
+            if (isNew)
+            {
+                std::copy(std::begin(SEGMENT_MAGIC), std::end(SEGMENT_MAGIC), _header->magic);
+                _header->version = SEGMENT_VERSION;
+                _header->recordSize = sizeof(Record);
+                _header->capacity = capacity;
+                _header->count = 0;
+            }
+            else
+            {
+                // Drop trailing records that never made it to disk (e.g. after a power loss or truncation)
+                _header->count = std::min<uint64_t>(_header->count, _header->capacity);
+
+                while (_header->count > 0 && _records[_header->count - 1].time == 0)
+                {
+                    _header->count--;
+                }
+            }
+        }
+
+        /**
+         * @brief Map sealed segment's chunk file
+         *
+         * @throws std::runtime_error if the file cannot be mapped or isn't a valid chunk
+         */
+        explicit Segment(const std::string& path)
+            : _path(path), _header(nullptr), _records(nullptr)
+        {
+            _fd = ::open(path.c_str(), O_RDONLY);
+
+            if (_fd < 0)
+            {
+                throw std::runtime_error("Failed to open sealed segment \"" + path + "\": " + std::strerror(errno));
+            }
+
+            struct stat info;
+
+            if (::fstat(_fd, &info) < 0 || info.st_size == 0)
+            {
+                ::close(_fd);
+                throw std::runtime_error("Invalid sealed segment \"" + path + "\"");
+            }
+
+            _mapSize = info.st_size;
+            _map = ::mmap(nullptr, _mapSize, PROT_READ, MAP_SHARED, _fd, 0);
+
+            if (_map == MAP_FAILED)
+            {
+                ::close(_fd);
+                throw std::runtime_error("Failed to map sealed segment \"" + path + "\": " + std::strerror(errno));
+            }
+
+            try
+            {
+                _chunk = std::make_unique<GorillaDecoder>(static_cast<const uint8_t*>(_map), _mapSize);
+            }
+            catch (const std::exception& e)
+            {
+                ::munmap(_map, _mapSize);
+                ::close(_fd);
+                throw std::runtime_error("Invalid sealed segment \"" + path + "\": " + e.what());
+            }
+        }
+
+        ~Segment()
+        {
+            ::munmap(_map, _mapSize);
+            ::close(_fd);
+        }
+
+        //==============================================================================
+        const std::string& path() const { return _path; }
+
+        size_t size() const { return _chunk ? _chunk->size() : _header->count; }
+        bool isFull() const { return _chunk || _header->count >= _header->capacity; }
+        bool isSealed() const { return _chunk != nullptr; }
+
+        /// Get first record's timestamp (NB: segment must not be empty)
+        int64_t firstTime() const { return _chunk ? _chunk->begin()->first : _records[0].time; }
+
+        /// Get last record (NB: segment must not be empty, sealed segments are decoded in full)
+        Record lastRecord() const
+        {
+            if (!_chunk)
+            {
+                return _records[_header->count - 1];
+            }
+
+            Record record {};
+
+            for (const auto& sample : *_chunk)
+            {
+                record = toRecord(sample);
+            }
+
+            return record;
+        }
+
+        /// Mapped records (NB: segment must not be sealed)
+        const Record * begin() const { return _records; }
+        const Record * end() const { return _records + _header->count; }
+
+        /// Chunk of sealed segment (NB: segment must be sealed)
+        const GorillaDecoder& chunk() const { return *_chunk; }
+
+        /// Append record (NB: segment must not be full)
+        void append(const Record& record)
+        {
+            _records[_header->count] = record;
+            _header->count++;
+        }
+
+        //==============================================================================
+        /**
+         * @brief Compress segment's records into a chunk file & map it
+         *
+         * The chunk is written to a temporary file which is synced, then renamed, so the
+         * chunk file is either complete or missing. The segment file is left for the
+         * caller to remove once it is unmapped.
+         *
+         * @param [in] segment      Full segment to seal
+         * @param [in] chunkPath    Path to chunk file
+         *
+         * @returns Sealed segment
+         *
+         * @throws std::runtime_error if the chunk file cannot be written
+         */
+        static Ptr seal(const Segment& segment, const std::string& chunkPath)
+        {
+            GorillaEncoder encoder;
+
+            for (const auto& record : segment)
+            {
+                encoder.append(record.time, { record.humidity, record.temperature });
+            }
+
+            const auto& bytes = encoder.bytes();
+            auto tmpPath = chunkPath + ".tmp";
+
+            int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+            if (fd < 0)
+            {
+                throw std::runtime_error("Failed to create sealed segment \"" + tmpPath + "\": " + std::strerror(errno));
+            }
+
+            size_t numWritten = 0;
+
+            while (numWritten < bytes.size())
+            {
+                auto result = ::write(fd, bytes.data() + numWritten, bytes.size() - numWritten);
+
+                if (result < 0 && errno == EINTR)
+                    continue;
+
+                if (result <= 0)
+                    break;
+
+                numWritten += result;
+            }
+
+            bool isWritten = numWritten == bytes.size() && ::fsync(fd) == 0;
+            ::close(fd);
+
+            if (!isWritten || ::rename(tmpPath.c_str(), chunkPath.c_str()) < 0)
+            {
+                std::string error = std::strerror(errno);
+                ::unlink(tmpPath.c_str());
+
+                throw std::runtime_error("Failed to write sealed segment \"" + chunkPath + "\": " + error);
+            }
+
+            return std::make_unique<Segment>(chunkPath);
+        }
+
+        /// Convert decoded chunk sample to record
+        static Record toRecord(const GorillaDecoder::Sample& sample)
+        {
+            return { sample.first, (float)sample.second.temperature, (float)sample.second.humidity };
+        }
+
+        //==============================================================================
+        /// Largest capacity accepted from a segment header
+        static constexpr uint64_t MAX_CAPACITY = std::numeric_limits<uint32_t>::max();
+
+    private:
+        //==============================================================================
+        std::string _path;
+
+        int _fd;
+
+        void * _map;
+        size_t _mapSize;
+
+        /// Mapped header & records, unless sealed
+        SegmentHeader * _header;
+        Record * _records;
+
+        /// Compressed records, once sealed
+        std::unique_ptr<GorillaDecoder> _chunk;
+    };
+
+    //==============================================================================
+    /**
+     * @struct Series
+     *
+     * All segments holding a given sensor's samples
+     */
+    struct Series
+    {
+        fs::path directory;
+
+        std::vector<Segment::Ptr> segments;
+
+        /// Index of next segment file to create
+        size_t nextIndex = 0;
+
+        /// Sparse time index: first timestamp of each segment (max value if segment is empty)
+        std::vector<int64_t> firstTimes;
+
+        std::shared_mutex mutex;
+    };
+
+    //==============================================================================
+    /// Encode sensor ID as a directory name, escaping anything but alphanumerics, '-' & '_'
+    static std::string toDirectoryName(const std::string& sensorID)
+    {
+        std::ostringstream oss;
+        oss << std::hex << std::uppercase << std::setfill('0');
+
+        for (unsigned char c : sensorID)
+        {
+            if (std::isalnum(c) || c == '-' || c == '_')
+                oss << c;
+            else
+                oss << '%' << std::setw(2) << (int)c;
+        }
+
+        return oss.str();
+    }
+
+    //==============================================================================
+    struct EmbeddedDB::impl : public unique_ownership_t<impl>
+    {
+        //==============================================================================
+        impl(std::string path, size_t segmentCapacity)
+            : _root(path), _segmentCapacity(std::max<size_t>(segmentCapacity, 1))
+        {
+            fs::create_directories(climateDirectory());
+        }
+
+        //==============================================================================
+        fs::path climateDirectory() const { return _root / "climate"; }
+        fs::path nameFile() const { return _root / "name"; }
+
+        //==============================================================================
+        /**
+         * @brief Get series for given sensor, mapping its existing segments on first use
+         *
+         * NB: _mutex must be held (shared or unique)
+         *
+         * @param [in] sensorID     Sensor to get series for
+         * @param [in] create       If true, create series if it doesn't exist yet
+         *
+         * @returns Series, or nullptr if the sensor has no data and create is false
+         */
+        Series * getSeries(const std::string& sensorID, bool create)
+        {
+            std::lock_guard<std::mutex> lock(_seriesMapMutex);
+
+            auto itSeries = _series.find(sensorID);
+
+            if (itSeries != _series.end())
+            {
+                return itSeries->second.get();
+            }
+
+            auto directory = climateDirectory() / toDirectoryName(sensorID);
+
+            if (!fs::exists(directory))
+            {
+                if (!create)
+                {
+                    return nullptr;
+                }
+
+                fs::create_directories(directory);
+            }
+
+            // Map existing segments in order (files are named after their index), preferring sealed ones
+            std::map<size_t, bool> indices;
+
+            for (const auto& entry : fs::directory_iterator(directory))
+            {
+                auto extension = entry.path().extension();
+                auto stem = entry.path().stem().string();
+
+                if ((extension == SEGMENT_EXTENSION || extension == CHUNK_EXTENSION) &&
+                    !stem.empty() && stem.size() < 10 &&
+                    std::all_of(stem.begin(), stem.end(), [](unsigned char c) { return std::isdigit(c); }))
+                {
+                    indices[std::stoul(stem)] |= extension == CHUNK_EXTENSION;
+                }
+            }
+
+            auto series = std::make_unique<Series>();
+            series->directory = directory;
+            series->nextIndex = indices.empty() ? 0 : indices.rbegin()->first + 1;
+
+            for (const auto& index : indices)
+            {
+                Segment::Ptr segment;
+
+                // Skip unreadable segments rather than losing access to the whole series
+                try
+                {
+                    if (index.second)
+                    {
+                        segment = std::make_unique<Segment>(chunkPath(*series, index.first));
+
+                        // Segment file is left behind if sealing was interrupted after writing its chunk
+                        boost::system::error_code error;
+                        fs::remove(segmentPath(*series, index.first), error);
+                    }
+                    else
+                    {
+                        segment = std::make_unique<Segment>(segmentPath(*series, index.first), _segmentCapacity);
+                    }
+                }
+                catch (const std::exception& e)
+                {
+                    g_logger.error("Skipping segment of sensor \"" + sensorID + "\": " + e.what());
+                    continue;
+                }
+
+                // Only the last segment may be empty, so that the time index stays sorted
+                if (segment->size() == 0 && index.first != indices.rbegin()->first)
+                {
+                    continue;
+                }
+
+                series->firstTimes.push_back(segment->size() > 0 ? segment->firstTime()
+                                                                 : std::numeric_limits<int64_t>::max());
+                series->segments.push_back(std::move(segment));
+            }
+
+            // Seal full segments which weren't sealed yet (e.g. written before segments were sealed)
+            for (size_t position = 0; position + 1 < series->segments.size(); ++position)
+            {
+                if (!series->segments[position]->isSealed() && series->segments[position]->isFull())
+                {
+                    seal(*series, position);
+                }
+            }
+
+            return (_series[sensorID] = std::move(series)).get();
+        }
+
+        std::string segmentPath(const Series& series, size_t index) const
+        {
+            return (series.directory / (std::to_string(index) + SEGMENT_EXTENSION)).string();
+        }
+
+        std::string chunkPath(const Series& series, size_t index) const
+        {
+            return (series.directory / (std::to_string(index) + CHUNK_EXTENSION)).string();
+        }
+
+        /**
+         * @brief Replace full segment with a sealed one, keeping it as is if sealing fails
+         *
+         * NB: series mutex must be held exclusively, unless the series isn't shared yet
+         */
+        void seal(Series& series, size_t position)
+        {
+            auto& segment = series.segments[position];
+            auto recordsPath = segment->path();
+
+            try
+            {
+                segment = Segment::seal(*segment, fs::path(recordsPath).replace_extension(CHUNK_EXTENSION).string());
+                fs::remove(recordsPath);
+            }
+            catch (const std::exception& e)
+            {
+                g_logger.warning("Failed to seal segment \"" + recordsPath + "\": " + e.what());
+            }
+        }
+
+        //==============================================================================
+        /// Append record to series, returning false if it is out of order
+        bool append(Series& series, const Record& record)
+        {
+            std::unique_lock<std::shared_mutex> lock(series.mutex);
+
+            if (!series.segments.empty() && series.segments.back()->size() > 0)
+            {
+                auto last = series.segments.back()->lastRecord();
+
+                if (record.time < last.time)
+                {
+                    return false;
+                }
+
+                // Retried batches may hold records appended before the write failed
+                if (record.time == last.time && record.temperature == last.temperature &&
+                    record.humidity == last.humidity)
+                {
+                    return true;
+                }
+            }
+
+            // Seal current segment & start new one when current one is full
+            if (series.segments.empty() || series.segments.back()->isFull())
+            {
+                if (!series.segments.empty() && !series.segments.back()->isSealed())
+                {
+                    seal(series, series.segments.size() - 1);
+                }
+
+                series.segments.push_back(std::make_unique<Segment>(segmentPath(series, series.nextIndex), _segmentCapacity));
+                series.nextIndex++;
+                series.firstTimes.push_back(std::numeric_limits<int64_t>::max());
+            }
+
+            auto& segment = series.segments.back();
+
+            if (segment->size() == 0)
+            {
+                series.firstTimes.back() = record.time;
+            }
+
+            segment->append(record);
+
+            return true;
+        }
+
+        //==============================================================================
+        /// Find segment index of first record with time >= since (NB: series mutex must be held)
+        static size_t findSegment(const Series& series, int64_t since)
+        {
+            // Last segment starting at or before since
+            auto itFirst = std::upper_bound(series.firstTimes.begin(), series.firstTimes.end(), since);
+            return itFirst == series.firstTimes.begin() ? 0 : (itFirst - series.firstTimes.begin()) - 1;
+        }
+
+        /// Find first record with time >= since in segment
+        static const Record * findRecord(const Segment& segment, int64_t since)
+        {
+            return std::lower_bound(segment.begin(), segment.end(), since,
+                                    [](const Record& record, int64_t time) { return record.time < time; });
+        }
+
+        /// Visit records with time >= since, in time order, until visitor returns false
+        template <typename Visitor>
+        void read(Series& series, int64_t since, Visitor visit)
+        {
+            std::shared_lock<std::shared_mutex> lock(series.mutex);
+
+            for (size_t index = findSegment(series, since); index < series.segments.size(); ++index)
+            {
+                const auto& segment = *series.segments[index];
+
+                // Sealed segments are decoded on the fly, skipping records older than since
+                if (segment.isSealed())
+                {
+                    for (const auto& sample : segment.chunk())
+                    {
+                        if (sample.first >= since && !visit(Segment::toRecord(sample)))
+                        {
+                            return;
+                        }
+                    }
+
+                    continue;
+                }
+
+                for (auto record = findRecord(segment, since); record != segment.end(); ++record)
+                {
+                    if (!visit(*record))
+                    {
+                        return;
+                    }
+                }
+            }
+        }
+
+        /// Count records with time >= since
+        size_t count(Series& series, int64_t since)
+        {
+            std::shared_lock<std::shared_mutex> lock(series.mutex);
+
+            size_t numRecords = 0;
+
+            for (size_t index = findSegment(series, since); index < series.segments.size(); ++index)
+            {
+                const auto& segment = *series.segments[index];
+
+                if (!segment.isSealed())
+                {
+                    numRecords += segment.end() - findRecord(segment, since);
+                }
+                else if (segment.firstTime() >= since)
+                {
+                    numRecords += segment.size();
+                }
+                else
+                {
+                    const auto& chunk = segment.chunk();
+                    numRecords += std::count_if(chunk.begin(), chunk.end(),
+                                                [since](const GorillaDecoder::Sample& sample) { return sample.first >= since; });
+                }
+            }
+
+            return numRecords;
+        }
+
+        /// Visit last records of series, in time order, until visitor returns false
+        template <typename Visitor>
+        void readLast(Series& series, size_t limit, Visitor visit)
+        {
+            std::shared_lock<std::shared_mutex> lock(series.mutex);
+
+            size_t numRecords = 0;
+
+            for (const auto& segment : series.segments)
+            {
+                numRecords += segment->size();
+            }
+
+            // Skip whole segments preceding the last records, only decoding a sealed one if it holds some
+            size_t numSkipped = numRecords > limit ? numRecords - limit : 0;
+
+            for (const auto& segment : series.segments)
+            {
+                if (numSkipped >= segment->size())
+                {
+                    numSkipped -= segment->size();
+                    continue;
+                }
+
+                if (segment->isSealed())
+                {
+                    for (const auto& sample : segment->chunk())
+                    {
+                        if (numSkipped > 0)
+                        {
+                            numSkipped--;
+                        }
+                        else if (!visit(Segment::toRecord(sample)))
+                        {
+                            return;
+                        }
+                    }
+
+                    continue;
+                }
+
+                for (auto record = segment->begin() + numSkipped; record != segment->end(); ++record)
+                {
+                    if (!visit(*record))
+                    {
+                        return;
+                    }
+                }
+
+                numSkipped = 0;
+            }
+        }
+
+        /// Get watermark of series from segment sizes & last record, without generation
+        ClimateWatermark watermark(Series& series)
+        {
+            std::shared_lock<std::shared_mutex> lock(series.mutex);
+
+            ClimateWatermark watermark;
+
+            for (const auto& segment : series.segments)
+            {
+                watermark.count += segment->size();
+            }
+
+            // Only the last segment may be empty
+            for (auto segment = series.segments.rbegin(); segment != series.segments.rend(); ++segment)
+            {
+                if ((*segment)->size() > 0)
+                {
+                    watermark.lastTimestamp = (*segment)->lastRecord().time;
+                    break;
+                }
+            }
+
+            return watermark;
+        }
+
+        //==============================================================================
+        std::string aggregatePath(const Series& series, int64_t period) const
+        {
+            return (series.directory / (std::to_string(period) + AGGREGATE_EXTENSION)).string();
+        }
+
+        //==============================================================================
+        fs::path _root;
+        size_t _segmentCapacity;
+
+        /// Guards the store as a whole (held exclusively when deleting files)
+        std::shared_mutex _mutex;
+
+        /// Guards the map of loaded series
+        std::mutex _seriesMapMutex;
+        std::map<std::string, std::unique_ptr<Series>> _series;
+    };
+
+    //==============================================================================
+    constexpr uint64_t Segment::MAX_CAPACITY;
+    constexpr size_t EmbeddedDB::DEFAULT_SEGMENT_CAPACITY;
+
+    //==============================================================================
+    EmbeddedDB::EmbeddedDB(std::string path, size_t segmentCapacity)
+    {
+        try
+        {
+            pimpl = new impl(path, segmentCapacity);
+        }
+        catch (const std::exception& e)
+        {
+            throw std::runtime_error("Failed to open embedded DB in \"" + path + "\": " + e.what());
+        }
+    }
+
+    EmbeddedDB::~EmbeddedDB()
+    {
+        delete pimpl;
+    }
+
+    //==============================================================================
+    void EmbeddedDB::clear()
+    {
+        clearClimateData();
+        clearAboutData();
+    }
+
+    void EmbeddedDB::clearClimateData()
+    {
+        std::unique_lock<std::shared_mutex> lock(pimpl->_mutex);
+
+        try
+        {
+            // Unmap all segments before deleting their files
+            {
+                std::lock_guard<std::mutex> mapLock(pimpl->_seriesMapMutex);
+                pimpl->_series.clear();
+            }
+
+            fs::remove_all(pimpl->climateDirectory());
+            fs::create_directories(pimpl->climateDirectory());
+        }
+        catch (const std::exception& e)
+        {
+            g_logger.error("Caught exception while clearing embedded DB climate data: " + std::string(e.what()));
+        }
+    }
+
+    void EmbeddedDB::clearAboutData()
+    {
+        std::unique_lock<std::shared_mutex> lock(pimpl->_mutex);
+
+        boost::system::error_code error;
+        fs::remove(pimpl->nameFile(), error);
+    }
+
+    //==============================================================================
+    ClimateSeries EmbeddedDB::getClimateData(std::string sensorID, int64_t since)
+    {
+        std::shared_lock<std::shared_mutex> lock(pimpl->_mutex);
+
+        ClimateSeries data;
+
+        try
+        {
+            auto series = pimpl->getSeries(sensorID, false);
+
+            if (series)
+            {
+                // Samples may be appended between counting & reading, in which case buffers grow as usual
+                data.reserve(pimpl->count(*series, since));
+
+                pimpl->read(*series, since, [&](const Record& record) {
+                    data.timestamps.push_back(record.time);
+                    data.temperature.push_back(record.temperature);
+                    data.humidity.push_back(record.humidity);
+
+                    return true;
+                });
+            }
+        }
+        catch (const std::exception& e)
+        {
+            g_logger.error("Caught exception while reading climate data from embedded DB: " + std::string(e.what()));
+        }
+
+        return data;
+    }
+
+    std::map<std::string, ClimateSeries> EmbeddedDB::getClimateData(const std::vector<std::string>& sensorIDs,
+                                                                    int64_t since, int64_t until, size_t limit)
+    {
+        std::shared_lock<std::shared_mutex> lock(pimpl->_mutex);
+
+        std::map<std::string, ClimateSeries> data;
+
+        try
+        {
+            for (const auto& sensorID : sensorIDs)
+            {
+                auto series = pimpl->getSeries(sensorID, false);
+
+                if (!series)
+                {
+                    continue;
+                }
+
+                size_t count = pimpl->count(*series, since);
+
+                if (limit > 0)
+                {
+                    count = std::min(count, limit);
+                }
+
+                ClimateSeries sensorData;
+                sensorData.reserve(count);
+
+                // Records are in time order, so reading stops at the end of the window or page
+                pimpl->read(*series, since, [&](const Record& record) {
+                    if (record.time >= until || (limit > 0 && sensorData.size() >= limit))
+                    {
+                        return false;
+                    }
+
+                    sensorData.timestamps.push_back(record.time);
+                    sensorData.temperature.push_back(record.temperature);
+                    sensorData.humidity.push_back(record.humidity);
+
+                    return true;
+                });
+
+                // Omit sensors without samples, as the PostgreSQL backend does
+                if (!sensorData.empty())
+                {
+                    data[sensorID] = std::move(sensorData);
+                }
+            }
+        }
+        catch (const std::exception& e)
+        {
+            g_logger.error("Caught exception while reading climate data from embedded DB: " + std::string(e.what()));
+        }
+
+        return data;
+    }
+
+    void EmbeddedDB::visitClimateData(std::string sensorID, int64_t since, const ClimateVisitor& visit,
+                                      size_t batchSize)
+    {
+        std::shared_lock<std::shared_mutex> lock(pimpl->_mutex);
+
+        batchSize = std::max<size_t>(batchSize, 1);
+
+        try
+        {
+            auto series = pimpl->getSeries(sensorID, false);
+
+            if (!series)
+            {
+                return;
+            }
+
+            ClimateSeries batch;
+            batch.reserve(batchSize);
+
+            bool isDone = false;
+
+            pimpl->read(*series, since, [&](const Record& record) {
+                batch.timestamps.push_back(record.time);
+                batch.temperature.push_back(record.temperature);
+                batch.humidity.push_back(record.humidity);
+
+                if (batch.size() < batchSize)
+                {
+                    return true;
+                }
+
+                isDone = !visit(batch);
+                batch.clear();
+
+                return !isDone;
+            });
+
+            if (!isDone && !batch.empty())
+            {
+                visit(batch);
+            }
+        }
+        catch (const std::exception& e)
+        {
+            g_logger.error("Caught exception while reading climate data from embedded DB: " + std::string(e.what()));
+        }
+    }
+
+    void EmbeddedDB::addClimateData(std::string sensorID, int64_t timestamp, ClimateData<double> data)
+    {
+        addClimateData(std::vector<ClimateSample>{ { sensorID, timestamp, data } });
+    }
+
+    bool EmbeddedDB::addClimateData(const std::vector<ClimateSample>& samples)
+    {
+        std::shared_lock<std::shared_mutex> lock(pimpl->_mutex);
+
+        try
+        {
+            for (const auto& sample : samples)
+            {
+                auto series = pimpl->getSeries(sample.sensorID, true);
+
+                Record record { sample.timestamp, (float)sample.data.temperature, (float)sample.data.humidity };
+
+                if (!pimpl->append(*series, record))
+                {
+                    g_logger.warning("Dropping out-of-order climate sample for sensor \"" + sample.sensorID +
+                                     "\" (t = " + std::to_string(sample.timestamp) + ")");
+                }
+            }
+
+            return true;
+        }
+        catch (const std::exception& e)
+        {
+            g_logger.error("Caught exception while writing climate data to embedded DB: " + std::string(e.what()));
+            return false;
+        }
+    }
+
+    std::map<std::string, ClimateWatermark> EmbeddedDB::getClimateWatermarks(const std::vector<std::string>& sensorIDs)
+    {
+        std::shared_lock<std::shared_mutex> lock(pimpl->_mutex);
+
+        std::map<std::string, ClimateWatermark> watermarks;
+
+        try
+        {
+            for (const auto& sensorID : sensorIDs)
+            {
+                auto series = pimpl->getSeries(sensorID, false);
+
+                if (!series)
+                {
+                    continue;
+                }
+
+                auto watermark = pimpl->watermark(*series);
+
+                if (watermark.count > 0)
+                {
+                    watermarks[sensorID] = watermark;
+                }
+            }
+        }
+        catch (const std::exception& e)
+        {
+            g_logger.error("Caught exception while reading climate data from embedded DB: " + std::string(e.what()));
+        }
+
+        return watermarks;
+    }
+
+    std::map<std::string, ClimateSeries> EmbeddedDB::getLatestClimateData(const std::vector<std::string>& sensorIDs,
+                                                                          size_t limit)
+    {
+        std::shared_lock<std::shared_mutex> lock(pimpl->_mutex);
+
+        std::map<std::string, ClimateSeries> data;
+
+        try
+        {
+            for (const auto& sensorID : sensorIDs)
+            {
+                auto series = pimpl->getSeries(sensorID, false);
+
+                if (!series || limit == 0)
+                {
+                    continue;
+                }
+
+                ClimateSeries sensorData;
+                sensorData.reserve(limit);
+
+                // Samples may be appended while reading, so the page is capped as it is filled
+                pimpl->readLast(*series, limit, [&](const Record& record) {
+                    if (sensorData.size() >= limit)
+                    {
+                        return false;
+                    }
+
+                    sensorData.timestamps.push_back(record.time);
+                    sensorData.temperature.push_back(record.temperature);
+                    sensorData.humidity.push_back(record.humidity);
+
+                    return true;
+                });
+
+                if (!sensorData.empty())
+                {
+                    data[sensorID] = std::move(sensorData);
+                }
+            }
+        }
+        catch (const std::exception& e)
+        {
+            g_logger.error("Caught exception while reading climate data from embedded DB: " + std::string(e.what()));
+        }
+
+        return data;
+    }
+
+    //==============================================================================
+    std::map<int64_t, ClimateAggregate> EmbeddedDB::getClimateAggregates(std::string sensorID, int64_t period)
+    {
+        std::shared_lock<std::shared_mutex> lock(pimpl->_mutex);
+
+        std::map<int64_t, ClimateAggregate> aggregates;
+
+        try
+        {
+            auto series = pimpl->getSeries(sensorID, false);
+
+            if (!series)
+            {
+                return aggregates;
+            }
+
+            std::shared_lock<std::shared_mutex> seriesLock(series->mutex);
+
+            std::ifstream stream(pimpl->aggregatePath(*series, period), std::ios::binary);
+            AggregateRecord record;
+
+            // Later records replace earlier ones of the same bucket, and a partially written last record is ignored
+            while (stream.read(reinterpret_cast<char*>(&record), sizeof(record)))
+            {
+                auto& aggregate = aggregates[record.time];
+
+                aggregate.count = (uint32_t)record.count;
+                aggregate.min.temperature = record.minTemperature;
+                aggregate.min.humidity = record.minHumidity;
+                aggregate.max.temperature = record.maxTemperature;
+                aggregate.max.humidity = record.maxHumidity;
+                aggregate.mean.temperature = record.meanTemperature;
+                aggregate.mean.humidity = record.meanHumidity;
+            }
+        }
+        catch (const std::exception& e)
+        {
+            g_logger.error("Caught exception while reading climate aggregates from embedded DB: " + std::string(e.what()));
+        }
+
+        return aggregates;
+    }
+
+    bool EmbeddedDB::addClimateAggregates(std::string sensorID, int64_t period,
+                                          const std::map<int64_t, ClimateAggregate>& aggregates)
+    {
+        if (aggregates.empty())
+        {
+            return true;
+        }
+
+        std::shared_lock<std::shared_mutex> lock(pimpl->_mutex);
+
+        try
+        {
+            auto series = pimpl->getSeries(sensorID, true);
+
+            std::unique_lock<std::shared_mutex> seriesLock(series->mutex);
+
+            auto path = pimpl->aggregatePath(*series, period);
+
+            // Drop any partially written record left by a crash, so that records stay aligned
+            if (fs::exists(path))
+            {
+                auto size = fs::file_size(path);
+
+                if (size % sizeof(AggregateRecord) != 0)
+                {
+                    fs::resize_file(path, size - size % sizeof(AggregateRecord));
+                }
+            }
+
+            std::ofstream stream(path, std::ios::binary | std::ios::app);
+
+            for (const auto& bucket : aggregates)
+            {
+                const auto& aggregate = bucket.second;
+
+                AggregateRecord record { bucket.first, aggregate.count,
+                                         aggregate.min.temperature, aggregate.min.humidity,
+                                         aggregate.max.temperature, aggregate.max.humidity,
+                                         aggregate.mean.temperature, aggregate.mean.humidity };
+
+                stream.write(reinterpret_cast<const char*>(&record), sizeof(record));
+            }
+
+            stream.flush();
+
+            if (!stream)
+            {
+                g_logger.error("Failed to write climate aggregates to \"" + path + "\"");
+                return false;
+            }
+
+            return true;
+        }
+        catch (const std::exception& e)
+        {
+            g_logger.error("Caught exception while writing climate aggregates to embedded DB: " + std::string(e.what()));
+            return false;
+        }
+    }
+
+    //==============================================================================
+    std::string EmbeddedDB::getName()
+    {
+        std::shared_lock<std::shared_mutex> lock(pimpl->_mutex);
+
+        auto path = pimpl->nameFile().string();
+
+        if (!file::isFile(path))
+        {
+            return PROJECT_NAME;
+        }
+
+        return file::readText(path);
+    }
+
+    void EmbeddedDB::setName(std::string name)
+    {
+        std::unique_lock<std::shared_mutex> lock(pimpl->_mutex);
+
+        // Write to temporary file, then rename it so the name file is never partially written
+        auto path = pimpl->nameFile();
+        auto tmpPath = path;
+        tmpPath += ".tmp";
+
+        try
+        {
+            {
+                std::ofstream stream(tmpPath.string(), std::ios::trunc);
+                stream << name.substr(0, 256);
+            }
+
+            fs::rename(tmpPath, path);
+        }
+        catch (const std::exception& e)
+        {
+            g_logger.error("Caught exception while writing name to embedded DB: " + std::string(e.what()));
+        }
+    }
+
+} // namespace beewatch
@@ -0,0 +1,356 @@
+//==============================================================================
+// Copyright (c) 2018 Eric Seguin, all rights reserved.
+//==============================================================================
+
+#include "util/gorilla.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace beewatch
+{
+
+    //==============================================================================
+    /// Delta-of-delta buckets: control bits, control bit count & value bit count
+    struct TimeBucket
+    {
+        uint64_t control;
+        unsigned controlBits;
+        unsigned valueBits;
+    };
+
+    static constexpr TimeBucket c_timeBuckets[] = {
+        { 0b10,   2, 7  },
+        { 0b110,  3, 9  },
+        { 0b1110, 4, 12 },
+        { 0b1111, 4, 64 }
+    };
+
+    static uint64_t toBits(double value)
+    {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    static double fromBits(uint64_t bits)
+    {
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    static uint64_t lowMask(unsigned numBits)
+    {
+        return numBits >= 64 ? ~uint64_t(0) : (uint64_t(1) << numBits) - 1;
+    }
+
+    /// Sign-extend the lowest numBits of given value
+    static int64_t signExtend(uint64_t value, unsigned numBits)
+    {
+        return numBits >= 64 ? (int64_t)value : (int64_t)(value << (64 - numBits)) >> (64 - numBits);
+    }
+
+    //==============================================================================
+    constexpr uint8_t GorillaEncoder::VERSION;
+    constexpr size_t GorillaEncoder::HEADER_SIZE;
+
+    //==============================================================================
+    GorillaEncoder::GorillaEncoder()
+        : _bytes(HEADER_SIZE, 0), _freeBits(0), _count(0)
+    {
+        _bytes[0] = VERSION;
+    }
+
+    //==============================================================================
+    void GorillaEncoder::append(int64_t time, const ClimateData<double>& data)
+    {
+        writeTime(time);
+        writeValue(data.temperature, _state.temperature);
+        writeValue(data.humidity, _state.humidity);
+
+        // Keep sample count in header up to date so the chunk is always readable
+        _count++;
+
+        for (size_t i = 0; i < 4; ++i)
+        {
+            _bytes[1 + i] = (_count >> (8 * i)) & 0xFF;
+        }
+    }
+
+    std::vector<uint8_t> GorillaEncoder::encode(const ClimateSeries& series)
+    {
+        GorillaEncoder encoder;
+
+        for (size_t i = 0; i < series.size(); ++i)
+        {
+            encoder.append(series.timestamps[i], series.data(i));
+        }
+
+        return encoder.bytes();
+    }
+
+    //==============================================================================
+    void GorillaEncoder::writeBits(uint64_t value, unsigned numBits)
+    {
+        // Bits are packed MSB first
+        while (numBits > 0)
+        {
+            if (_freeBits == 0)
+            {
+                _bytes.push_back(0);
+                _freeBits = 8;
+            }
+
+            unsigned n = std::min(numBits, _freeBits);
+            uint8_t chunk = (value >> (numBits - n)) & lowMask(n);
+
+            _bytes.back() |= chunk << (_freeBits - n);
+
+            _freeBits -= n;
+            numBits -= n;
+        }
+    }
+
+    void GorillaEncoder::writeTime(int64_t time)
+    {
+        if (_count == 0)
+        {
+            writeBits((uint64_t)time, 64);
+        }
+        else
+        {
+            // Wrap around on overflow rather than invoking undefined behaviour
+            int64_t delta = (int64_t)((uint64_t)time - (uint64_t)_state.prevTime);
+            int64_t deltaOfDelta = (int64_t)((uint64_t)delta - (uint64_t)_state.prevDelta);
+
+            if (deltaOfDelta == 0)
+            {
+                writeBits(0, 1);
+            }
+            else
+            {
+                for (const auto& bucket : c_timeBuckets)
+                {
+                    int64_t limit = bucket.valueBits >= 64 ? 0 : int64_t(1) << (bucket.valueBits - 1);
+
+                    if (bucket.valueBits >= 64 || (-limit <= deltaOfDelta && deltaOfDelta < limit))
+                    {
+                        writeBits(bucket.control, bucket.controlBits);
+                        writeBits((uint64_t)deltaOfDelta & lowMask(bucket.valueBits), bucket.valueBits);
+                        break;
+                    }
+                }
+            }
+
+            _state.prevDelta = delta;
+        }
+
+        _state.prevTime = time;
+    }
+
+    void GorillaEncoder::writeValue(double value, GorillaState::Value& state)
+    {
+        uint64_t bits = toBits(value);
+        uint64_t xorBits = bits ^ state.prevBits;
+
+        state.prevBits = bits;
+
+        if (xorBits == 0)
+        {
+            writeBits(0, 1);
+            return;
+        }
+
+        // Leading zero count is stored on 5 bits
+        unsigned leadingZeros = std::min(__builtin_clzll(xorBits), 31);
+        unsigned trailingZeros = __builtin_ctzll(xorBits);
+
+        if (state.hasWindow && leadingZeros >= state.leadingZeros && trailingZeros >= state.trailingZeros)
+        {
+            // Meaningful bits fit in previous window
+            writeBits(0b10, 2);
+            writeBits(xorBits >> state.trailingZeros, 64 - state.leadingZeros - state.trailingZeros);
+        }
+        else
+        {
+            // Store new window; a length of 64 is stored as 0 to fit on 6 bits
+            unsigned meaningfulBits = 64 - leadingZeros - trailingZeros;
+
+            writeBits(0b11, 2);
+            writeBits(leadingZeros, 5);
+            writeBits(meaningfulBits & 0x3F, 6);
+            writeBits(xorBits >> trailingZeros, meaningfulBits);
+
+            state.leadingZeros = leadingZeros;
+            state.trailingZeros = trailingZeros;
+            state.hasWindow = true;
+        }
+    }
+
+    //==============================================================================
+    GorillaDecoder::GorillaDecoder(const uint8_t * data, size_t size)
+        : _data(data), _size(size), _count(0)
+    {
+        if (size < GorillaEncoder::HEADER_SIZE)
+        {
+            throw std::invalid_argument("Chunk is too small to hold a header");
+        }
+
+        if (data[0] != GorillaEncoder::VERSION)
+        {
+            throw std::invalid_argument("Unsupported chunk version: " + std::to_string(data[0]));
+        }
+
+        for (size_t i = 0; i < 4; ++i)
+        {
+            _count |= size_t(data[1 + i]) << (8 * i);
+        }
+    }
+
+    GorillaDecoder::GorillaDecoder(const std::vector<uint8_t>& chunk)
+        : GorillaDecoder(chunk.data(), chunk.size())
+    {
+    }
+
+    ClimateSeries GorillaDecoder::decode(const std::vector<uint8_t>& chunk)
+    {
+        GorillaDecoder decoder(chunk);
+
+        ClimateSeries series;
+        series.reserve(decoder.size());
+
+        for (const auto& sample : decoder)
+        {
+            series.push_back(sample.first, sample.second);
+        }
+
+        return series;
+    }
+
+    //==============================================================================
+    GorillaDecoder::iterator::iterator(const GorillaDecoder& decoder, size_t index)
+        : _data(decoder._data), _size(decoder._size), _count(decoder._count),
+          _bitPos(8 * GorillaEncoder::HEADER_SIZE), _index(index)
+    {
+        if (_index < _count)
+        {
+            decodeNext();
+        }
+    }
+
+    GorillaDecoder::iterator& GorillaDecoder::iterator::operator++()
+    {
+        if (++_index < _count)
+        {
+            decodeNext();
+        }
+
+        return *this;
+    }
+
+    void GorillaDecoder::iterator::decodeNext()
+    {
+        _sample.first = readTime();
+        _sample.second.temperature = readValue(_state.temperature);
+        _sample.second.humidity = readValue(_state.humidity);
+    }
+
+    //==============================================================================
+    uint64_t GorillaDecoder::iterator::readBits(unsigned numBits)
+    {
+        uint64_t value = 0;
+
+        while (numBits > 0)
+        {
+            size_t bytePos = _bitPos / 8;
+
+            if (bytePos >= _size)
+            {
+                throw std::out_of_range("Chunk is truncated");
+            }
+
+            unsigned availableBits = 8 - _bitPos % 8;
+            unsigned n = std::min(numBits, availableBits);
+
+            value = (value << n) | ((_data[bytePos] >> (availableBits - n)) & lowMask(n));
+
+            _bitPos += n;
+            numBits -= n;
+        }
+
+        return value;
+    }
+
+    int64_t GorillaDecoder::iterator::readTime()
+    {
+        int64_t time;
+
+        if (_index == 0)
+        {
+            time = (int64_t)readBits(64);
+        }
+        else
+        {
+            int64_t deltaOfDelta = 0;
+
+            if (readBits(1) != 0)
+            {
+                // Read control bits until a bucket matches
+                uint64_t control = 1;
+                unsigned controlBits = 1;
+
+                for (const auto& bucket : c_timeBuckets)
+                {
+                    while (controlBits < bucket.controlBits)
+                    {
+                        control = (control << 1) | readBits(1);
+                        controlBits++;
+                    }
+
+                    if (control == bucket.control)
+                    {
+                        deltaOfDelta = signExtend(readBits(bucket.valueBits), bucket.valueBits);
+                        break;
+                    }
+                }
+            }
+
+            _state.prevDelta = (int64_t)((uint64_t)_state.prevDelta + (uint64_t)deltaOfDelta);
+            time = (int64_t)((uint64_t)_state.prevTime + (uint64_t)_state.prevDelta);
+        }
+
+        _state.prevTime = time;
+        return time;
+    }
+
+    double GorillaDecoder::iterator::readValue(GorillaState::Value& state)
+    {
+        if (readBits(1) != 0)
+        {
+            if (readBits(1) != 0)
+            {
+                state.leadingZeros = readBits(5);
+                unsigned meaningfulBits = readBits(6);
+
+                if (meaningfulBits == 0)
+                    meaningfulBits = 64;
+
+                if (state.leadingZeros + meaningfulBits > 64)
+                {
+                    throw std::out_of_range("Chunk is corrupted");
+                }
+
+                state.trailingZeros = 64 - state.leadingZeros - meaningfulBits;
+                state.hasWindow = true;
+            }
+
+            unsigned meaningfulBits = 64 - state.leadingZeros - state.trailingZeros;
+            state.prevBits ^= readBits(meaningfulBits) << state.trailingZeros;
+        }
+
+        return fromBits(state.prevBits);
+    }
+
+} // namespace beewatch
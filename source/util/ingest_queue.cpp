@@ -0,0 +1,238 @@
+//==============================================================================
+// Copyright (c) 2018 Eric Seguin, all rights reserved.
+//==============================================================================
+
+#include "util/ingest_queue.h"
+
+#include "global/logging.h"
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+
+namespace beewatch
+{
+
+    //==============================================================================
+    constexpr size_t IngestQueue::DEFAULT_CAPACITY;
+    constexpr size_t IngestQueue::DEFAULT_BATCH_SIZE;
+    constexpr std::chrono::milliseconds IngestQueue::DEFAULT_FLUSH_INTERVAL;
+    constexpr std::chrono::milliseconds IngestQueue::DEFAULT_RETRY_INTERVAL;
+    constexpr std::chrono::milliseconds IngestQueue::MAX_RETRY_INTERVAL;
+
+    //==============================================================================
+    IngestQueue::IngestQueue(FlushFunction flush, size_t capacity, size_t batchSize,
+                             std::chrono::milliseconds flushInterval, std::chrono::milliseconds retryInterval)
+        : _flush(flush),
+          _capacity(std::max<size_t>(capacity, 1)),
+          _batchSize(std::max<size_t>(std::min(batchSize, _capacity), 1)),
+          _flushInterval(flushInterval),
+          _retryInterval(std::max(retryInterval, std::chrono::milliseconds(1))),
+          _flushRequested(false), _writing(false), _stop(false),
+          _backoff(0), _numFailures(0)
+    {
+        if (!_flush)
+        {
+            throw std::invalid_argument("Received undefined flush function");
+        }
+
+        _thread = std::make_unique<std::thread>(&IngestQueue::writerLoop, this);
+    }
+
+    IngestQueue::~IngestQueue()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+
+        _wakeCondition.notify_one();
+        _thread->join();
+    }
+
+    //==============================================================================
+    bool IngestQueue::push(ClimateSample sample)
+    {
+        bool dropped = false;
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+
+            if (_queue.empty())
+            {
+                _oldestTime = std::chrono::steady_clock::now();
+            }
+            else if (_queue.size() >= _capacity)
+            {
+                _queue.pop_front();
+                dropped = true;
+            }
+
+            _queue.push_back(std::move(sample));
+        }
+
+        if (dropped)
+        {
+            g_logger.warning("Ingest queue is full, dropping oldest climate sample");
+        }
+
+        _wakeCondition.notify_one();
+        return !dropped;
+    }
+
+    bool IngestQueue::flush()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        size_t numFailures = _numFailures;
+
+        // Keep requesting flushes until samples queued in the meantime are written too
+        while (!_queue.empty() || _writing)
+        {
+            if (_numFailures != numFailures)
+            {
+                return false;
+            }
+
+            if (!_queue.empty())
+            {
+                _flushRequested = true;
+                _wakeCondition.notify_one();
+            }
+
+            _idleCondition.wait(lock);
+        }
+
+        return _numFailures == numFailures;
+    }
+
+    void IngestQueue::clear()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        _queue.clear();
+        _idleCondition.notify_all();
+
+        _idleCondition.wait(lock, [this]() { return !_writing; });
+    }
+
+    size_t IngestQueue::size() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _queue.size();
+    }
+
+    //==============================================================================
+    void IngestQueue::writerLoop()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        auto isReady = [this]() {
+            return _stop || _flushRequested || _queue.size() >= _batchSize;
+        };
+
+        while (true)
+        {
+            // Sleep until samples are queued
+            if (_queue.empty())
+            {
+                if (_stop)
+                {
+                    break;
+                }
+
+                _wakeCondition.wait(lock, [this]() { return _stop || !_queue.empty(); });
+                continue;
+            }
+
+            // Back off after a failed write, unless asked to flush or stop
+            if (!_stop && !_flushRequested && std::chrono::steady_clock::now() < _retryTime)
+            {
+                _wakeCondition.wait_until(lock, _retryTime, [this]() { return _stop || _flushRequested; });
+                continue;
+            }
+
+            // Wait until a batch is full, the oldest sample is due or we are asked to flush
+            if (!isReady())
+            {
+                auto deadline = _oldestTime + _flushInterval;
+                _wakeCondition.wait_until(lock, deadline, isReady);
+
+                if (_queue.empty() || (!isReady() && std::chrono::steady_clock::now() < deadline))
+                {
+                    continue;
+                }
+            }
+
+            // Write all queued samples outside of the lock so producers never wait on the DB
+            std::vector<ClimateSample> batch(std::make_move_iterator(_queue.begin()),
+                                             std::make_move_iterator(_queue.end()));
+            auto batchTime = _oldestTime;
+
+            _queue.clear();
+
+            _flushRequested = false;
+            _writing = true;
+
+            lock.unlock();
+
+            bool isWritten = false;
+
+            try
+            {
+                isWritten = _flush(batch);
+            }
+            catch (const std::exception& e)
+            {
+                g_logger.error("Caught exception while flushing " + std::to_string(batch.size()) +
+                               " climate samples: " + std::string(e.what()));
+            }
+
+            lock.lock();
+
+            if (isWritten)
+            {
+                _backoff = std::chrono::milliseconds(0);
+                _retryTime = std::chrono::steady_clock::time_point();
+            }
+            else if (_stop)
+            {
+                g_logger.error("Failed to flush climate samples while stopping, dropping " +
+                               std::to_string(batch.size() + _queue.size()) + " samples");
+                _queue.clear();
+                _numFailures++;
+            }
+            else
+            {
+                requeue(batch, batchTime);
+                _numFailures++;
+            }
+
+            _writing = false;
+            _idleCondition.notify_all();
+        }
+    }
+
+    void IngestQueue::requeue(std::vector<ClimateSample>& batch, std::chrono::steady_clock::time_point batchTime)
+    {
+        // Failed samples are older than any queued since, so they go back in front
+        _queue.insert(_queue.begin(), std::make_move_iterator(batch.begin()), std::make_move_iterator(batch.end()));
+        _oldestTime = batchTime;
+
+        size_t numDropped = 0;
+
+        while (_queue.size() > _capacity)
+        {
+            _queue.pop_front();
+            numDropped++;
+        }
+
+        _backoff = std::min(std::max(2 * _backoff, _retryInterval), std::max(MAX_RETRY_INTERVAL, _retryInterval));
+        _retryTime = std::chrono::steady_clock::now() + _backoff;
+
+        g_logger.warning("Failed to flush " + std::to_string(batch.size()) + " climate samples, retrying in " +
+                         std::to_string(_backoff.count()) + " ms" +
+                         (numDropped > 0 ? " (queue is full, dropped " + std::to_string(numDropped) + " oldest)" : ""));
+    }
+
+} // namespace beewatch
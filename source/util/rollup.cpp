@@ -0,0 +1,240 @@
+//==============================================================================
+// Copyright (c) 2018 Eric Seguin, all rights reserved.
+//==============================================================================
+
+#include "util/rollup.h"
+
+#include <algorithm>
+#include <iterator>
+#include <mutex>
+#include <stdexcept>
+
+namespace beewatch
+{
+
+    //==============================================================================
+    constexpr int64_t ClimateRollup::HOUR;
+    constexpr int64_t ClimateRollup::DAY;
+
+    //==============================================================================
+    ClimateRollup::ClimateRollup(std::vector<int64_t> periods)
+    {
+        std::sort(periods.begin(), periods.end());
+        periods.erase(std::unique(periods.begin(), periods.end()), periods.end());
+
+        for (auto period : periods)
+        {
+            if (period <= 0)
+            {
+                throw std::invalid_argument("Received invalid rollup period: " + std::to_string(period));
+            }
+
+            _tiers.push_back({ period, {}, {} });
+        }
+    }
+
+    //==============================================================================
+    int64_t ClimateRollup::Tier::bucketStart(int64_t time) const
+    {
+        // Round towards negative infinity so pre-epoch samples land in the right bucket
+        int64_t start = (time / period) * period;
+        return start > time ? start - period : start;
+    }
+
+    int64_t ClimateRollup::Tier::getPersistedUntil(const std::string& sensorID) const
+    {
+        auto it = persistedUntil.find(sensorID);
+        return it != persistedUntil.end() ? it->second : std::numeric_limits<int64_t>::min();
+    }
+
+    //==============================================================================
+    ClimateRollup::Tier& ClimateRollup::getTier(int64_t period)
+    {
+        return const_cast<Tier&>(static_cast<const ClimateRollup&>(*this).getTier(period));
+    }
+
+    const ClimateRollup::Tier& ClimateRollup::getTier(int64_t period) const
+    {
+        auto itTier = std::find_if(_tiers.begin(), _tiers.end(),
+                                   [period](const Tier& tier) { return tier.period == period; });
+
+        if (itTier == _tiers.end())
+        {
+            throw std::invalid_argument("No rollup tier with a period of " + std::to_string(period) + " s");
+        }
+
+        return *itTier;
+    }
+
+    //==============================================================================
+    void ClimateRollup::add(const ClimateSample& sample)
+    {
+        std::unique_lock<std::shared_mutex> lock(_mutex);
+
+        for (auto& tier : _tiers)
+        {
+            if (sample.timestamp >= tier.getPersistedUntil(sample.sensorID))
+            {
+                tier.buckets[sample.sensorID][tier.bucketStart(sample.timestamp)].add(sample.data);
+            }
+        }
+    }
+
+    void ClimateRollup::add(const std::vector<ClimateSample>& samples)
+    {
+        std::unique_lock<std::shared_mutex> lock(_mutex);
+
+        for (auto& tier : _tiers)
+        {
+            for (const auto& sample : samples)
+            {
+                if (sample.timestamp >= tier.getPersistedUntil(sample.sensorID))
+                {
+                    tier.buckets[sample.sensorID][tier.bucketStart(sample.timestamp)].add(sample.data);
+                }
+            }
+        }
+    }
+
+    void ClimateRollup::add(const std::string& sensorID, const ClimateSeries& series)
+    {
+        std::unique_lock<std::shared_mutex> lock(_mutex);
+
+        for (auto& tier : _tiers)
+        {
+            auto& buckets = tier.buckets[sensorID];
+            auto persistedUntil = tier.getPersistedUntil(sensorID);
+
+            for (size_t i = 0; i < series.size(); ++i)
+            {
+                if (series.timestamps[i] >= persistedUntil)
+                {
+                    buckets[tier.bucketStart(series.timestamps[i])].add(series.data(i));
+                }
+            }
+        }
+    }
+
+    void ClimateRollup::clear()
+    {
+        std::unique_lock<std::shared_mutex> lock(_mutex);
+
+        for (auto& tier : _tiers)
+        {
+            tier.buckets.clear();
+            tier.persistedUntil.clear();
+        }
+    }
+
+    //==============================================================================
+    int64_t ClimateRollup::restore(const std::string& sensorID, int64_t period,
+                                   std::map<int64_t, ClimateAggregate> buckets)
+    {
+        std::unique_lock<std::shared_mutex> lock(_mutex);
+
+        auto& tier = getTier(period);
+
+        if (buckets.empty())
+        {
+            return tier.getPersistedUntil(sensorID);
+        }
+
+        // Persisted buckets take precedence over any added so far
+        auto& sensorBuckets = tier.buckets[sensorID];
+
+        for (auto& bucket : buckets)
+        {
+            sensorBuckets[bucket.first] = bucket.second;
+        }
+
+        auto& persistedUntil = tier.persistedUntil[sensorID];
+        persistedUntil = buckets.rbegin()->first + period;
+
+        return persistedUntil;
+    }
+
+    std::vector<ClimateRollup::Closed> ClimateRollup::getUnpersisted() const
+    {
+        std::shared_lock<std::shared_mutex> lock(_mutex);
+
+        std::vector<Closed> unpersisted;
+
+        for (const auto& tier : _tiers)
+        {
+            for (const auto& sensor : tier.buckets)
+            {
+                const auto& buckets = sensor.second;
+
+                if (buckets.empty())
+                    continue;
+
+                // Latest bucket is still open
+                auto first = buckets.lower_bound(tier.getPersistedUntil(sensor.first));
+                auto last = std::prev(buckets.end());
+
+                if (first == buckets.end() || first->first >= last->first)
+                    continue;
+
+                unpersisted.push_back({ sensor.first, tier.period, { first, last } });
+            }
+        }
+
+        return unpersisted;
+    }
+
+    void ClimateRollup::setPersisted(const std::string& sensorID, int64_t period, int64_t until)
+    {
+        std::unique_lock<std::shared_mutex> lock(_mutex);
+
+        auto& tier = getTier(period);
+        auto persistedUntil = tier.getPersistedUntil(sensorID);
+
+        tier.persistedUntil[sensorID] = std::max(persistedUntil, until);
+    }
+
+    std::vector<int64_t> ClimateRollup::getPeriods() const
+    {
+        std::vector<int64_t> periods;
+
+        for (const auto& tier : _tiers)
+        {
+            periods.push_back(tier.period);
+        }
+
+        return periods;
+    }
+
+    //==============================================================================
+    int64_t ClimateRollup::selectPeriod(int64_t resolution) const
+    {
+        int64_t period = 0;
+
+        for (const auto& tier : _tiers)
+        {
+            if (tier.period <= resolution)
+                period = tier.period;
+        }
+
+        return period;
+    }
+
+    std::map<int64_t, ClimateAggregate> ClimateRollup::get(const std::string& sensorID, int64_t period,
+                                                           int64_t since) const
+    {
+        std::shared_lock<std::shared_mutex> lock(_mutex);
+
+        const auto& tier = getTier(period);
+        auto itSensor = tier.buckets.find(sensorID);
+
+        if (itSensor == tier.buckets.end())
+        {
+            return {};
+        }
+
+        // Include bucket containing since
+        const auto& buckets = itSensor->second;
+
+        return { buckets.lower_bound(tier.bucketStart(since)), buckets.end() };
+    }
+
+} // namespace beewatch
@@ -0,0 +1,155 @@
+//==============================================================================
+// Copyright (c) 2018 Eric Seguin, all rights reserved.
+//==============================================================================
+
+#include "util/worker_pool.h"
+
+#include "global/logging.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace beewatch
+{
+
+    //==============================================================================
+    constexpr size_t WorkerPool::DEFAULT_NUM_WORKERS;
+    constexpr size_t WorkerPool::DEFAULT_CAPACITY;
+
+    //==============================================================================
+    WorkerPool::WorkerPool(size_t numWorkers, size_t capacity)
+        : _capacity(capacity), _stop(false),
+          _running(0), _completed(0), _rejected(0), _expired(0),
+          _numWaits(0), _totalWaitMs(0.0), _maxWaitMs(0.0)
+    {
+        if (numWorkers == 0 || capacity == 0)
+        {
+            throw std::invalid_argument("Worker pool needs at least one worker and one queue slot");
+        }
+
+        for (size_t i = 0; i < numWorkers; ++i)
+        {
+            _workers.emplace_back(&WorkerPool::workerLoop, this);
+        }
+    }
+
+    WorkerPool::~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+
+        _wakeCondition.notify_all();
+
+        for (auto& worker : _workers)
+        {
+            worker.join();
+        }
+    }
+
+    //==============================================================================
+    bool WorkerPool::submit(Task task, std::chrono::milliseconds timeout, Task onExpired)
+    {
+        using namespace std::chrono;
+
+        auto now = steady_clock::now();
+
+        // Avoid overflowing the clock when waiting indefinitely
+        auto deadline = timeout < duration_cast<milliseconds>(steady_clock::time_point::max() - now)
+                        ? now + timeout
+                        : steady_clock::time_point::max();
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+
+            if (_stop || _queue.size() >= _capacity)
+            {
+                _rejected++;
+                return false;
+            }
+
+            _queue.push_back({ std::move(task), std::move(onExpired), now, deadline });
+        }
+
+        _wakeCondition.notify_one();
+        return true;
+    }
+
+    WorkerPool::Stats WorkerPool::getStats() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        Stats stats;
+
+        stats.numWorkers = _workers.size();
+        stats.capacity = _capacity;
+
+        stats.queued = _queue.size();
+        stats.running = _running;
+
+        stats.completed = _completed;
+        stats.rejected = _rejected;
+        stats.expired = _expired;
+
+        stats.meanWaitMs = _numWaits > 0 ? _totalWaitMs / _numWaits : 0.0;
+        stats.maxWaitMs = _maxWaitMs;
+
+        return stats;
+    }
+
+    //==============================================================================
+    void WorkerPool::workerLoop()
+    {
+        using namespace std::chrono;
+
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        while (true)
+        {
+            _wakeCondition.wait(lock, [this]() { return _stop || !_queue.empty(); });
+
+            // Queued tasks are still run (or expired) when stopping, so none is silently lost
+            if (_queue.empty())
+            {
+                return;
+            }
+
+            auto queuedTask = std::move(_queue.front());
+            _queue.pop_front();
+
+            auto now = steady_clock::now();
+            bool isExpired = now > queuedTask.deadline;
+
+            double waitMs = duration<double, std::milli>(now - queuedTask.queuedTime).count();
+
+            _numWaits++;
+            _totalWaitMs += waitMs;
+            _maxWaitMs = std::max(_maxWaitMs, waitMs);
+
+            _running++;
+            lock.unlock();
+
+            try
+            {
+                if (!isExpired)
+                    queuedTask.task();
+                else if (queuedTask.onExpired)
+                    queuedTask.onExpired();
+            }
+            catch (const std::exception& e)
+            {
+                g_logger.error("Caught exception in worker thread: " + std::string(e.what()));
+            }
+
+            lock.lock();
+            _running--;
+
+            if (isExpired)
+                _expired++;
+            else
+                _completed++;
+        }
+    }
+
+} // namespace beewatch
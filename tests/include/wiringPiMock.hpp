@@ -46,5 +46,18 @@ public:
     int currentEdgeType = rand();
     void(*currentISR)(void);
 
-    virtual int setISR(int pin, int edgeType, void(*function)(void)) override { lastPin = pin; currentEdgeType = edgeType; currentISR = function; return 0; }
+    int numISRsSet = 0;                 // Number of ISRs set, timestamped or not (wiringPi starts a thread for each)
+
+    virtual int setISR(int pin, int edgeType, void(*function)(void)) override { lastPin = pin; currentEdgeType = edgeType; currentISR = function; numISRsSet++; return 0; }
+
+    bool hasTimestampedISR = false;     // Whether edges are timestamped as they occur
+    TimestampedISR currentTimestampedISR = nullptr;
+
+    virtual int setTimestampedISR(int pin, int edgeType, TimestampedISR function) override
+    {
+        if (!hasTimestampedISR)
+            return -1;
+
+        lastPin = pin; currentEdgeType = edgeType; currentTimestampedISR = function; numISRsSet++; return 0;
+    }
 };
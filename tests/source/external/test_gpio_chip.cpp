@@ -0,0 +1,124 @@
+//==============================================================================
+// Copyright (c) 2018 Eric Seguin, all rights reserved.
+//==============================================================================
+
+#include "external/gpioChip.h"
+#include "io/gpio.h"
+
+#include "global/logging.h"
+#include "global/time.hpp"
+
+#include "catch.hpp"
+
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+/**
+ * How to write tests with Catch:
+ * https://github.com/catchorg/Catch2/blob/master/docs/tutorial.md#bdd-style
+ */
+
+using namespace beewatch;
+
+using external::GpioChip;
+using io::GPIO;
+using io::LogicalState;
+
+//==============================================================================
+SCENARIO("Open the GPIO character device", "[gpiochip][external][core]")
+{
+    // Disable logger
+    g_logger.setVerbosity(Logger::Level::Unattainable);
+
+    WHEN("we open a chip which doesn't exist")
+    {
+        THEN("a runtime_error exception should be thrown")
+        {
+            REQUIRE_THROWS_AS(GpioChip("/dev/gpiochip-does-not-exist"), std::runtime_error);
+        }
+    }
+
+    WHEN("we open a device which isn't a GPIO chip")
+    {
+        THEN("a runtime_error exception should be thrown")
+        {
+            REQUIRE_THROWS_AS(GpioChip("/dev/null"), std::runtime_error);
+        }
+    }
+}
+
+//==============================================================================
+/**
+ * Requires a simulated chip from the gpio-sim module, e.g.:
+ *
+ *  GPIO_SIM_CHIP=/dev/gpiochip1 GPIO_SIM_SYSFS=/sys/devices/platform/gpio-sim.0/gpiochip1 \
+ *      testbeewatch "[gpiochip][sim]"
+ */
+SCENARIO("Read pins & timestamped edges from a simulated GPIO chip", "[gpiochip][sim][external][!hide]")
+{
+    const char* chipPath = std::getenv("GPIO_SIM_CHIP");
+    const char* sysfsPath = std::getenv("GPIO_SIM_SYSFS");
+
+    if (!chipPath || !sysfsPath)
+    {
+        WARN("GPIO_SIM_CHIP & GPIO_SIM_SYSFS must point to a gpio-sim chip");
+        return;
+    }
+
+    // Drive simulated line 0 from outside
+    auto pull = [&](const std::string& direction) {
+            std::ofstream(std::string(sysfsPath) + "/sim_gpio0/pull") << direction;
+        };
+
+    GIVEN("GPIO 0 of a simulated chip")
+    {
+        pull("pull-down");
+
+        auto gpio = GPIO::claim(0, std::make_shared<GpioChip>(chipPath));
+        REQUIRE(gpio != nullptr);
+
+        WHEN("the line is pulled up, then down")
+        {
+            pull("pull-up");
+            LogicalState hi = gpio->read();
+
+            pull("pull-down");
+            LogicalState lo = gpio->read();
+
+            THEN("its state is read back")
+            {
+                REQUIRE(hi == LogicalState::HI);
+                REQUIRE(lo == LogicalState::LO);
+            }
+        }
+
+        WHEN("edges are captured while the line toggles")
+        {
+            double startMs = g_timeRaw.now();
+
+            gpio->startEdgeCapture(GPIO::EdgeType::Both, 16);
+
+            for (int i = 0; i < 4; ++i)
+            {
+                pull(i % 2 == 0 ? "pull-up" : "pull-down");
+                g_timeRaw.wait(2.0);
+            }
+
+            auto edges = gpio->stopEdgeCapture();
+
+            THEN("they are timestamped by the kernel, in order")
+            {
+                REQUIRE(edges.size() == 4);
+
+                for (size_t i = 0; i < edges.size(); ++i)
+                {
+                    REQUIRE(edges[i].state == (i % 2 == 0 ? LogicalState::HI : LogicalState::LO));
+                    REQUIRE(edges[i].timeMs >= (i == 0 ? startMs : edges[i - 1].timeMs + 1.0));
+                    REQUIRE(edges[i].timeMs <= g_timeRaw.now());
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,233 @@
+//==============================================================================
+// Copyright (c) 2018 Eric Seguin, all rights reserved.
+//==============================================================================
+
+#include "external/gpioMem.h"
+#include "io/gpio.h"
+
+#include "global/logging.h"
+
+#include "catch.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include <unistd.h>
+
+/**
+ * How to write tests with Catch:
+ * https://github.com/catchorg/Catch2/blob/master/docs/tutorial.md#bdd-style
+ */
+
+using namespace beewatch;
+
+using external::GpioMem;
+using io::GPIO;
+using io::LogicalState;
+
+/// Temporary file standing in for the GPIO registers
+class FakeRegisterFile
+{
+public:
+    explicit FakeRegisterFile(size_t size = GpioMem::BLOCK_SIZE)
+    {
+        char path[] = "/tmp/beewatch-gpiomem-XXXXXX";
+
+        _fd = ::mkstemp(path);
+        REQUIRE(_fd >= 0);
+        REQUIRE(::ftruncate(_fd, (off_t)size) == 0);
+
+        this->path = path;
+    }
+
+    ~FakeRegisterFile()
+    {
+        ::close(_fd);
+        ::unlink(path.c_str());
+    }
+
+    /// Register mappings share the file's pages, so they see these accesses
+    uint32_t read(size_t offset) const
+    {
+        uint32_t value = 0;
+        REQUIRE(::pread(_fd, &value, sizeof(value), (off_t)(offset * sizeof(value))) == sizeof(value));
+
+        return value;
+    }
+
+    void write(size_t offset, uint32_t value)
+    {
+        REQUIRE(::pwrite(_fd, &value, sizeof(value), (off_t)(offset * sizeof(value))) == sizeof(value));
+    }
+
+    std::string path;
+
+private:
+    int _fd;
+};
+
+//==============================================================================
+SCENARIO("Drive pins through mapped GPIO registers", "[gpiomem][external][core]")
+{
+    // Disable logger
+    g_logger.setVerbosity(Logger::Level::Unattainable);
+
+    WHEN("we map registers which don't exist")
+    {
+        THEN("a runtime_error exception should be thrown")
+        {
+            REQUIRE_THROWS_AS(GpioMem("/dev/gpiomem-does-not-exist"), std::runtime_error);
+        }
+    }
+
+    WHEN("we map a register file smaller than a register block")
+    {
+        FakeRegisterFile file(16);
+
+        THEN("a runtime_error exception should be thrown")
+        {
+            REQUIRE_THROWS_AS(GpioMem(file.path), std::runtime_error);
+        }
+    }
+
+    GIVEN("registers mapped from a fake register file")
+    {
+        FakeRegisterFile file;
+        auto registers = std::make_shared<GpioMem>(file.path);
+
+        WHEN("we set & clear pins with masks")
+        {
+            registers->set(0b1010);
+            uint32_t setMask = file.read(GpioMem::GPSET0);
+
+            registers->clear(0b0101);
+            uint32_t clearMask = file.read(GpioMem::GPCLR0);
+
+            THEN("the masks are written to the set & clear registers")
+            {
+                REQUIRE(setMask == 0b1010);
+                REQUIRE(clearMask == 0b0101);
+            }
+        }
+
+        WHEN("pins are at various levels")
+        {
+            file.write(GpioMem::GPLEV0, 1u << 4 | 1u << 17);
+
+            THEN("their levels are read from the level register")
+            {
+                REQUIRE(registers->level() == (1u << 4 | 1u << 17));
+
+                REQUIRE(registers->digitalRead(4) == registers->c_high);
+                REQUIRE(registers->digitalRead(5) == registers->c_low);
+            }
+        }
+
+        WHEN("we set a pin's mode")
+        {
+            file.write(GpioMem::GPFSEL0 + 1, 0xFFFFFFFF);
+            registers->pinMode(14, registers->c_input);
+
+            uint32_t inputSelect = file.read(GpioMem::GPFSEL0 + 1);
+
+            registers->pinMode(14, registers->c_output);
+
+            uint32_t outputSelect = file.read(GpioMem::GPFSEL0 + 1);
+
+            THEN("only its bits of the function select register change")
+            {
+                REQUIRE(inputSelect == (0xFFFFFFFF & ~(7u << 12)));
+                REQUIRE(outputSelect == (inputSelect | 1u << 12));
+            }
+        }
+
+        WHEN("a GPIO is claimed on the registers")
+        {
+            GPIO::Ptr gpio = GPIO::claim(14, registers);
+            REQUIRE(gpio != nullptr);
+
+            file.write(GpioMem::GPLEV0, 1u << 14);
+            LogicalState state = gpio->read();
+
+            gpio->setMode(GPIO::Mode::Output);
+            gpio->write(LogicalState::HI);
+
+            THEN("it reads & writes its pin directly")
+            {
+                REQUIRE(state == LogicalState::HI);
+                REQUIRE(file.read(GpioMem::GPSET0) == 1u << 14);
+            }
+        }
+    }
+}
+
+//==============================================================================
+SCENARIO("Benchmark GPIO toggles through wiringPi and mapped registers", "[gpiomem][benchmark][!hide]")
+{
+    using namespace std::chrono;
+
+    static constexpr int c_numToggles = 1'000'000;
+
+    // Disable logger
+    g_logger.setVerbosity(Logger::Level::Unattainable);
+
+    FakeRegisterFile file;
+    auto registers = std::make_shared<GpioMem>(file.path);
+
+    auto benchmark = [](const std::string& name, auto toggle) {
+            auto startTime = steady_clock::now();
+
+            for (int i = 0; i < c_numToggles; ++i)
+                toggle();
+
+            double elapsedMs = duration<double, std::milli>(steady_clock::now() - startTime).count();
+
+            std::cout << name << ": " << (int64_t)(c_numToggles / (elapsedMs / 1e3)) << " toggles/s" << std::endl;
+
+            return elapsedMs;
+        };
+
+    GIVEN("a GPIO output")
+    {
+        double wiringPiMs;
+        double registersMs;
+        double maskMs;
+
+        {
+            GPIO::Ptr gpio = GPIO::claim(14, external::WiringPi::getInstance());
+            gpio->setMode(GPIO::Mode::Output);
+
+            wiringPiMs = benchmark("GPIO::write() through wiringPi", [&]() {
+                    gpio->write(LogicalState::HI);
+                    gpio->write(LogicalState::LO);
+                });
+        }
+
+        {
+            GPIO::Ptr gpio = GPIO::claim(14, registers);
+            gpio->setMode(GPIO::Mode::Output);
+
+            registersMs = benchmark("GPIO::write() through registers", [&]() {
+                    gpio->write(LogicalState::HI);
+                    gpio->write(LogicalState::LO);
+                });
+        }
+
+        maskMs = benchmark("GpioMem::set()/clear() with a mask", [&]() {
+                registers->set(1u << 14);
+                registers->clear(1u << 14);
+            });
+
+        std::cout << "Speedup through registers: " << wiringPiMs / registersMs << "x (GPIO), "
+                  << wiringPiMs / maskMs << "x (masks)" << std::endl;
+
+        THEN("the pin is left LO")
+        {
+            REQUIRE(file.read(GpioMem::GPCLR0) == 1u << 14);
+        }
+    }
+}
@@ -0,0 +1,238 @@
+//==============================================================================
+// Copyright (c) 2018 Eric Seguin, all rights reserved.
+//==============================================================================
+
+#include "http/cbor_writer.h"
+#include "http/json_writer.h"
+
+#include "catch.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+/**
+ * How to write tests with Catch:
+ * https://github.com/catchorg/Catch2/blob/master/docs/tutorial.md#bdd-style
+ */
+
+using namespace beewatch;
+using namespace beewatch::http;
+
+//==============================================================================
+/// Serialise with a given function & return output as bytes
+template <typename Function>
+static std::vector<uint8_t> toCbor(Function function, size_t chunkSize = CborWriter::DEFAULT_CHUNK_SIZE)
+{
+    std::vector<uint8_t> output;
+
+    CborWriter writer([&](const char * data, size_t size) { output.insert(output.end(), data, data + size); },
+                      chunkSize);
+
+    function(writer);
+    writer.flush();
+
+    return output;
+}
+
+static ClimateSeries makeSeries(size_t numSamples)
+{
+    ClimateSeries series;
+    series.reserve(numSamples);
+
+    for (size_t i = 0; i < numSamples; ++i)
+    {
+        // DHT22 readings have a 0.1 resolution
+        series.push_back(1'500'000'000 + 300 * (int64_t)i,
+                         { std::round(500.0 + 100.0 * std::sin(i / 50.0)) / 10.0,
+                           std::round(200.0 + 50.0 * std::cos(i / 70.0)) / 10.0 });
+    }
+
+    return series;
+}
+
+//==============================================================================
+SCENARIO("Values are serialised as CBOR", "[cbor][http][core]")
+{
+    // Examples from RFC 8949, appendix A
+    THEN("integers use the shortest encoding")
+    {
+        REQUIRE(toCbor([](CborWriter& w) { w.value((int64_t)0); }) == std::vector<uint8_t>{ 0x00 });
+        REQUIRE(toCbor([](CborWriter& w) { w.value((int64_t)23); }) == std::vector<uint8_t>{ 0x17 });
+        REQUIRE(toCbor([](CborWriter& w) { w.value((int64_t)24); }) == std::vector<uint8_t>{ 0x18, 0x18 });
+        REQUIRE(toCbor([](CborWriter& w) { w.value((int64_t)1000); }) == std::vector<uint8_t>{ 0x19, 0x03, 0xe8 });
+
+        REQUIRE(toCbor([](CborWriter& w) { w.value((int64_t)1000000); }) ==
+                std::vector<uint8_t>{ 0x1a, 0x00, 0x0f, 0x42, 0x40 });
+
+        REQUIRE(toCbor([](CborWriter& w) { w.value((int64_t)1000000000000); }) ==
+                std::vector<uint8_t>{ 0x1b, 0x00, 0x00, 0x00, 0xe8, 0xd4, 0xa5, 0x10, 0x00 });
+
+        REQUIRE(toCbor([](CborWriter& w) { w.value((int64_t)-1); }) == std::vector<uint8_t>{ 0x20 });
+        REQUIRE(toCbor([](CborWriter& w) { w.value((int64_t)-1000); }) == std::vector<uint8_t>{ 0x39, 0x03, 0xe7 });
+    }
+
+    THEN("doubles are written in full precision")
+    {
+        REQUIRE(toCbor([](CborWriter& w) { w.value(1.1); }) ==
+                std::vector<uint8_t>{ 0xfb, 0x3f, 0xf1, 0x99, 0x99, 0x99, 0x99, 0x99, 0x9a });
+    }
+
+    THEN("strings and maps are written with their length")
+    {
+        REQUIRE(toCbor([](CborWriter& w) { w.value(std::string("IETF")); }) ==
+                std::vector<uint8_t>{ 0x64, 0x49, 0x45, 0x54, 0x46 });
+
+        REQUIRE(toCbor([](CborWriter& w) { w.beginMap(1).value("a").value((int64_t)1); }) ==
+                std::vector<uint8_t>{ 0xa1, 0x61, 0x61, 0x01 });
+
+        REQUIRE(toCbor([](CborWriter& w) { w.beginMap().value("a").value((int64_t)1).end(); }) ==
+                std::vector<uint8_t>{ 0xbf, 0x61, 0x61, 0x01, 0xff });
+    }
+
+    THEN("numeric columns are written as little-endian typed arrays")
+    {
+        REQUIRE(toCbor([](CborWriter& w) { w.int64Array({ 1, -2 }); }) ==
+                std::vector<uint8_t>{ 0xd8, 79, 0x50,
+                                      0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                                      0xfe, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff });
+
+        REQUIRE(toCbor([](CborWriter& w) { w.uint32Array({ 258 }); }) ==
+                std::vector<uint8_t>{ 0xd8, 70, 0x44, 0x02, 0x01, 0x00, 0x00 });
+
+        REQUIRE(toCbor([](CborWriter& w) { w.float32Array({ 1.0, -2.0 }); }) ==
+                std::vector<uint8_t>{ 0xd8, 85, 0x48, 0x00, 0x00, 0x80, 0x3f, 0x00, 0x00, 0x00, 0xc0 });
+    }
+
+    THEN("an undefined sink is refused")
+    {
+        REQUIRE_THROWS_AS(CborWriter(nullptr), std::invalid_argument);
+    }
+}
+
+SCENARIO("Climate series are serialised as CBOR typed arrays", "[cbor][http][core]")
+{
+    GIVEN("a climate series")
+    {
+        auto series = makeSeries(1000);
+
+        WHEN("it is serialised in small chunks")
+        {
+            auto output = toCbor([&](CborWriter& w) { writeClimateSeries(w, series); }, 100);
+
+            THEN("output is the same as in a single chunk")
+            {
+                REQUIRE(output == toCbor([&](CborWriter& w) { writeClimateSeries(w, series); }));
+            }
+
+            THEN("columns can be read back in place")
+            {
+                // Map of 3, then "timestamps" key (11 bytes), tag 79 & 2-byte length header
+                REQUIRE(output[0] == 0xa3);
+                REQUIRE(output[12] == 0xd8);
+                REQUIRE(output[13] == 79);
+                REQUIRE(output[14] == 0x59);
+                REQUIRE((output[15] << 8 | output[16]) == 8 * series.size());
+
+                const uint8_t * timestamps = output.data() + 17;
+
+                // Then "temperature" key (12 bytes), tag 85 (2 bytes) & length header (3 bytes)
+                const uint8_t * temperature = timestamps + 8 * series.size() + 12 + 2 + 3;
+
+                for (size_t i = 0; i < series.size(); ++i)
+                {
+                    int64_t timestamp;
+                    std::memcpy(&timestamp, timestamps + 8 * i, sizeof(timestamp));
+
+                    float value;
+                    std::memcpy(&value, temperature + 4 * i, sizeof(value));
+
+                    REQUIRE(timestamp == series.timestamps[i]);
+                    REQUIRE(value == (float)series.temperature[i]);
+                }
+            }
+
+            THEN("it takes 16 bytes per sample")
+            {
+                REQUIRE(output.size() < 16 * series.size() + 64);
+            }
+        }
+    }
+
+    GIVEN("climate aggregates")
+    {
+        std::map<int64_t, ClimateAggregate> aggregates;
+
+        aggregates[0].add({ 40.0, 20.0 });
+        aggregates[3600].add({ 60.0, 30.0 });
+
+        auto output = toCbor([&](CborWriter& w) { writeClimateAggregates(w, aggregates); });
+
+        THEN("they are written as a map of 6 columns, ending with counts")
+        {
+            REQUIRE(output[0] == 0xa6);
+
+            std::vector<uint8_t> counts = { 0x65, 'c', 'o', 'u', 'n', 't', 0xd8, 70, 0x48,
+                                            0x01, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00 };
+
+            REQUIRE(std::equal(counts.begin(), counts.end(), output.end() - counts.size()));
+        }
+    }
+}
+
+//==============================================================================
+SCENARIO("Benchmark CBOR against JSON for climate history", "[cbor][benchmark][!hide]")
+{
+    using namespace std::chrono;
+
+    static constexpr size_t c_numSamples = 100'000;
+    static constexpr int c_numRuns = 10;
+
+    GIVEN("a history of " + std::to_string(c_numSamples) + " climate samples")
+    {
+        auto series = makeSeries(c_numSamples);
+
+        WHEN("it is serialised as JSON, then as CBOR")
+        {
+            size_t jsonSize = 0;
+            auto startTime = steady_clock::now();
+
+            for (int run = 0; run < c_numRuns; ++run)
+            {
+                jsonSize = 0;
+
+                JsonWriter writer([&](const char *, size_t size) { jsonSize += size; });
+
+                writeClimateSeries(writer, series);
+                writer.flush();
+            }
+
+            double jsonMs = duration<double, std::milli>(steady_clock::now() - startTime).count() / c_numRuns;
+
+            size_t cborSize = 0;
+            startTime = steady_clock::now();
+
+            for (int run = 0; run < c_numRuns; ++run)
+            {
+                cborSize = 0;
+
+                CborWriter writer([&](const char *, size_t size) { cborSize += size; });
+
+                writeClimateSeries(writer, series);
+                writer.flush();
+            }
+
+            double cborMs = duration<double, std::milli>(steady_clock::now() - startTime).count() / c_numRuns;
+
+            std::cout << "JSON: " << jsonSize << " bytes in " << jsonMs << " ms" << std::endl;
+            std::cout << "CBOR: " << cborSize << " bytes in " << cborMs << " ms ("
+                      << (double)jsonSize / cborSize << "x smaller, " << jsonMs / cborMs << "x faster)" << std::endl;
+
+            THEN("CBOR is smaller")
+            {
+                REQUIRE(cborSize < jsonSize);
+            }
+        }
+    }
+}
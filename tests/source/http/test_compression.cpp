@@ -0,0 +1,218 @@
+//==============================================================================
+// Copyright (c) 2018 Eric Seguin, all rights reserved.
+//==============================================================================
+
+#include "http/compression.h"
+#include "http/json_writer.h"
+
+#include "catch.hpp"
+
+#include <zlib.h>
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+
+/**
+ * How to write tests with Catch:
+ * https://github.com/catchorg/Catch2/blob/master/docs/tutorial.md#bdd-style
+ */
+
+using namespace beewatch;
+using namespace beewatch::http;
+
+//==============================================================================
+/// Decompress gzip or zlib data, detecting the container from its header
+static std::string inflate(const std::string& compressed)
+{
+    z_stream z = z_stream();
+
+    if (inflateInit2(&z, 15 + 32) != Z_OK)
+        throw std::runtime_error("Failed to initialise zlib stream");
+
+    z.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(compressed.data()));
+    z.avail_in = (uInt)compressed.size();
+
+    std::string output;
+    char buffer[4096];
+    int result;
+
+    do
+    {
+        z.next_out = reinterpret_cast<Bytef *>(buffer);
+        z.avail_out = sizeof(buffer);
+
+        result = inflate(&z, Z_NO_FLUSH);
+
+        if (result != Z_OK && result != Z_STREAM_END)
+        {
+            inflateEnd(&z);
+            throw std::runtime_error("Failed to decompress data");
+        }
+
+        output.append(buffer, sizeof(buffer) - z.avail_out);
+    }
+    while (result != Z_STREAM_END);
+
+    inflateEnd(&z);
+    return output;
+}
+
+static ClimateSeries makeSeries(size_t numSamples)
+{
+    ClimateSeries series;
+    series.reserve(numSamples);
+
+    for (size_t i = 0; i < numSamples; ++i)
+    {
+        // DHT22 readings have a 0.1 resolution
+        series.push_back(1'500'000'000 + 300 * (int64_t)i,
+                         { std::round(500.0 + 100.0 * std::sin(i / 50.0)) / 10.0,
+                           std::round(200.0 + 50.0 * std::cos(i / 70.0)) / 10.0 });
+    }
+
+    return series;
+}
+
+static std::string toJson(const ClimateSeries& series)
+{
+    std::string json;
+
+    JsonWriter writer([&](const char * data, size_t size) { json.append(data, size); });
+
+    writer.beginObject().key("interior");
+    writeClimateSeries(writer, series);
+    writer.endObject();
+
+    writer.flush();
+
+    return json;
+}
+
+//==============================================================================
+SCENARIO("Responses are compressed as a stream", "[compression][http][core]")
+{
+    GIVEN("a climate history serialised as JSON")
+    {
+        auto json = toJson(makeSeries(5000));
+
+        THEN("invalid compressors are refused")
+        {
+            auto sink = [](const char *, size_t) {};
+
+            REQUIRE_THROWS_AS(Compressor(ContentEncoding::Gzip, 0, sink), std::invalid_argument);
+            REQUIRE_THROWS_AS(Compressor(ContentEncoding::Gzip, 10, sink), std::invalid_argument);
+            REQUIRE_THROWS_AS(Compressor(ContentEncoding::Identity, 6, sink), std::invalid_argument);
+            REQUIRE_THROWS_AS(Compressor(ContentEncoding::Gzip, 6, nullptr), std::invalid_argument);
+        }
+
+        for (auto encoding : { ContentEncoding::Gzip, ContentEncoding::Deflate })
+        {
+            WHEN("it is compressed with " + toString(encoding) + " in small pieces")
+            {
+                std::string compressed;
+                size_t numChunks = 0;
+
+                Compressor compressor(encoding, 6, [&](const char * data, size_t size) {
+                        compressed.append(data, size);
+                        ++numChunks;
+                    }, 1024);
+
+                for (size_t i = 0; i < json.size(); i += 1000)
+                    compressor.write(json.data() + i, std::min<size_t>(1000, json.size() - i));
+
+                compressor.finish();
+
+                THEN("output comes in several chunks and is much smaller")
+                {
+                    REQUIRE(numChunks > 1);
+                    REQUIRE(compressed.size() * 4 < json.size());
+                }
+
+                THEN("it has the right container")
+                {
+                    if (encoding == ContentEncoding::Gzip)
+                    {
+                        REQUIRE((uint8_t)compressed[0] == 0x1f);
+                        REQUIRE((uint8_t)compressed[1] == 0x8b);
+                    }
+                    else
+                    {
+                        REQUIRE((compressed[0] & 0x0f) == Z_DEFLATED);
+                    }
+                }
+
+                THEN("it decompresses to the original JSON")
+                {
+                    REQUIRE(inflate(compressed) == json);
+                }
+
+                THEN("writing after finishing is refused")
+                {
+                    REQUIRE_THROWS_AS(compressor.write("{}", 2), std::logic_error);
+                }
+            }
+        }
+    }
+}
+
+//==============================================================================
+SCENARIO("Benchmark compressed climate history over a slow link", "[compression][benchmark][!hide]")
+{
+    using namespace std::chrono;
+
+    // Pi Zero W Wi-Fi under realistic conditions
+    static constexpr double c_linkBitsPerSecond = 2e6;
+    static constexpr size_t c_numSamples = 100'000;
+
+    GIVEN("a history of " + std::to_string(c_numSamples) + " climate samples")
+    {
+        auto series = makeSeries(c_numSamples);
+
+        WHEN("it is sent uncompressed, then at several compression levels")
+        {
+            for (int level : { 0, 1, 6, 9 })
+            {
+                auto startTime = steady_clock::now();
+                size_t size = 0;
+
+                {
+                    Compressor::Ptr compressor;
+
+                    if (level > 0)
+                    {
+                        compressor = std::make_unique<Compressor>(ContentEncoding::Gzip, level,
+                                                                  [&](const char *, size_t n) { size += n; });
+                    }
+
+                    JsonWriter writer([&](const char * data, size_t n) {
+                            if (compressor)
+                                compressor->write(data, n);
+                            else
+                                size += n;
+                        });
+
+                    writer.beginObject().key("interior");
+                    writeClimateSeries(writer, series);
+                    writer.endObject();
+
+                    writer.flush();
+
+                    if (compressor)
+                        compressor->finish();
+                }
+
+                double cpuMs = duration<double, std::milli>(steady_clock::now() - startTime).count();
+                double transferMs = size * 8 / c_linkBitsPerSecond * 1e3;
+
+                std::cout << (level == 0 ? std::string("Uncompressed") : "gzip level " + std::to_string(level))
+                          << ": " << size << " bytes, " << cpuMs << " ms serialising + " << transferMs
+                          << " ms transfer at " << c_linkBitsPerSecond / 1e6 << " Mbit/s = "
+                          << cpuMs + transferMs << " ms" << std::endl;
+
+                REQUIRE(size > 0);
+            }
+        }
+    }
+}
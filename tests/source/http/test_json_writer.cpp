@@ -0,0 +1,294 @@
+//==============================================================================
+// Copyright (c) 2018 Eric Seguin, all rights reserved.
+//==============================================================================
+
+#include "http/json_writer.h"
+
+#include "catch.hpp"
+
+#include <cpprest/json.h>
+
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <limits>
+
+/**
+ * How to write tests with Catch:
+ * https://github.com/catchorg/Catch2/blob/master/docs/tutorial.md#bdd-style
+ */
+
+using namespace beewatch;
+using namespace beewatch::http;
+
+//==============================================================================
+static ClimateSeries makeSeries(size_t numSamples)
+{
+    ClimateSeries series;
+    series.reserve(numSamples);
+
+    for (size_t i = 0; i < numSamples; ++i)
+    {
+        series.push_back(1'500'000'000 + 60 * (int64_t)i,
+                         { 50.0 + 10.0 * std::sin(i / 500.0), 20.0 + 5.0 * std::cos(i / 700.0) });
+    }
+
+    return series;
+}
+
+//==============================================================================
+SCENARIO("JSON is serialised in chunks without building a DOM", "[json][http][core]")
+{
+    GIVEN("a writer appending chunks to a string")
+    {
+        std::string output;
+        size_t numChunks = 0;
+
+        auto sink = [&](const char * data, size_t size) {
+            output.append(data, size);
+            ++numChunks;
+        };
+
+        THEN("it refuses an undefined sink")
+        {
+            REQUIRE_THROWS_AS(JsonWriter(nullptr), std::invalid_argument);
+        }
+
+        WHEN("we write nested objects and arrays")
+        {
+            JsonWriter writer(sink);
+
+            writer.beginObject()
+                  .key("a").value((int64_t)-12)
+                  .key("b").beginArray()
+                      .value(1.5)
+                      .beginObject().endObject()
+                      .beginArray().endArray()
+                      .null()
+                  .endArray()
+                  .key("c").value(std::string("x"))
+                  .endObject();
+
+            THEN("nothing is passed to the sink before flushing")
+            {
+                REQUIRE(output.empty());
+            }
+
+            writer.flush();
+
+            THEN("commas and colons are inserted where needed")
+            {
+                REQUIRE(output == R"({"a":-12,"b":[1.5,{},[],null],"c":"x"})");
+                REQUIRE(numChunks == 1);
+            }
+        }
+
+        WHEN("we write strings containing special characters")
+        {
+            JsonWriter writer(sink);
+
+            writer.value(std::string("quote\" backslash\\ newline\n tab\t bell\x07"));
+            writer.flush();
+
+            THEN("they are escaped")
+            {
+                REQUIRE(output == R"("quote\" backslash\\ newline\n tab\t bell\u0007")");
+            }
+        }
+
+        WHEN("we write non-finite numbers")
+        {
+            JsonWriter writer(sink);
+
+            writer.beginArray()
+                  .value(std::numeric_limits<double>::quiet_NaN())
+                  .value(std::numeric_limits<double>::infinity())
+                  .endArray();
+
+            writer.flush();
+
+            THEN("they are written as null")
+            {
+                REQUIRE(output == "[null,null]");
+            }
+        }
+
+        WHEN("we write doubles")
+        {
+            JsonWriter writer(sink);
+
+            writer.value(0.1);
+            writer.flush();
+
+            THEN("they are written with enough digits to round-trip")
+            {
+                REQUIRE(std::stod(output) == 0.1);
+            }
+        }
+
+        WHEN("we write a series larger than the chunk size")
+        {
+            auto series = makeSeries(1000);
+
+            std::string reference;
+
+            {
+                JsonWriter writer([&](const char * data, size_t size) { reference.append(data, size); }, 1 << 20);
+
+                writeClimateSeries(writer, series);
+                writer.flush();
+            }
+
+            JsonWriter writer(sink, 100);
+
+            writeClimateSeries(writer, series);
+            writer.flush();
+
+            THEN("output is split across several chunks")
+            {
+                REQUIRE(numChunks > 1);
+                REQUIRE(output == reference);
+            }
+
+            THEN("output follows the API's climate data format")
+            {
+                auto json = web::json::value::parse(output);
+
+                REQUIRE(json["timestamps"].size() == series.size());
+                REQUIRE(json["samples"].size() == series.size());
+
+                for (size_t i = 0; i < series.size(); ++i)
+                {
+                    REQUIRE(json["timestamps"][i].as_number().to_int64() == series.timestamps[i]);
+                    REQUIRE(json["samples"][i]["temperature"].as_double() == series.temperature[i]);
+                    REQUIRE(json["samples"][i]["humidity"].as_double() == series.humidity[i]);
+                }
+            }
+        }
+
+        WHEN("we write climate aggregates")
+        {
+            std::map<int64_t, ClimateAggregate> aggregates;
+
+            aggregates[3600].add({ 40.0, 20.0 });
+            aggregates[3600].add({ 60.0, 30.0 });
+
+            JsonWriter writer(sink);
+
+            writeClimateAggregates(writer, aggregates);
+            writer.flush();
+
+            THEN("each sample holds the mean values along with extrema and count")
+            {
+                REQUIRE(output == R"({"timestamps":[3600],"samples":[{"temperature":25,"humidity":50,)"
+                                  R"("min":{"temperature":20,"humidity":40},)"
+                                  R"("max":{"temperature":30,"humidity":60},"count":2}]})");
+            }
+        }
+    }
+}
+
+//==============================================================================
+/// Get peak resident set size since last reset, in kB
+static size_t getPeakRSS()
+{
+    std::ifstream status("/proc/self/status");
+    std::string line;
+
+    while (std::getline(status, line))
+    {
+        if (line.compare(0, 6, "VmHWM:") == 0)
+            return std::stoul(line.substr(6));
+    }
+
+    return 0;
+}
+
+/// Reset peak resident set size to current value (Linux >= 4.0)
+static void resetPeakRSS()
+{
+    std::ofstream("/proc/self/clear_refs") << "5";
+}
+
+SCENARIO("Benchmark streaming JSON against cpprest's DOM", "[json][benchmark][!hide]")
+{
+    using namespace std::chrono;
+
+    static constexpr size_t c_numSamples = 100'000;
+
+    GIVEN("a history of " + std::to_string(c_numSamples) + " climate samples")
+    {
+        auto series = makeSeries(c_numSamples);
+
+        WHEN("it is serialised through a DOM, then streamed")
+        {
+            size_t baseRSS;
+
+            // DOM, as built by the server before streaming
+            resetPeakRSS();
+            baseRSS = getPeakRSS();
+
+            auto startTime = steady_clock::now();
+            size_t domSize;
+
+            {
+                auto answer = web::json::value::object();
+
+                answer["interior"] = web::json::value::object(true);
+                answer["interior"]["timestamps"] = web::json::value::array(series.size());
+                answer["interior"]["samples"] = web::json::value::array(series.size());
+
+                auto& timestamps = answer["interior"]["timestamps"];
+                auto& samples = answer["interior"]["samples"];
+
+                for (size_t i = 0; i < series.size(); ++i)
+                {
+                    timestamps[i] = web::json::value::number((int64_t)series.timestamps[i]);
+
+                    samples[i] = web::json::value::object({
+                            { "temperature", series.temperature[i] },
+                            { "humidity", series.humidity[i] }
+                        }, true);
+                }
+
+                domSize = answer.serialize().size();
+            }
+
+            double domMs = duration<double, std::milli>(steady_clock::now() - startTime).count();
+            size_t domRSS = getPeakRSS() - baseRSS;
+
+            // Streaming writer, with chunks discarded as they would be once sent
+            resetPeakRSS();
+            baseRSS = getPeakRSS();
+
+            startTime = steady_clock::now();
+            size_t streamSize = 0;
+
+            {
+                JsonWriter writer([&](const char *, size_t size) { streamSize += size; });
+
+                writer.beginObject().key("interior");
+                writeClimateSeries(writer, series);
+                writer.endObject();
+
+                writer.flush();
+            }
+
+            double streamMs = duration<double, std::milli>(steady_clock::now() - startTime).count();
+            size_t streamRSS = getPeakRSS() - baseRSS;
+
+            std::cout << "DOM: " << domMs << " ms, peak RSS +" << domRSS << " kB (" << domSize
+                      << " bytes)" << std::endl;
+
+            std::cout << "Streaming: " << streamMs << " ms, peak RSS +" << streamRSS << " kB ("
+                      << streamSize << " bytes)" << std::endl;
+
+            THEN("both produce a document")
+            {
+                REQUIRE(domSize > 0);
+                REQUIRE(streamSize > 0);
+            }
+        }
+    }
+}
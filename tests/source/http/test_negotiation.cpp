@@ -0,0 +1,123 @@
+//==============================================================================
+// Copyright (c) 2018 Eric Seguin, all rights reserved.
+//==============================================================================
+
+#include "http/negotiation.h"
+
+#include "catch.hpp"
+
+/**
+ * How to write tests with Catch:
+ * https://github.com/catchorg/Catch2/blob/master/docs/tutorial.md#bdd-style
+ */
+
+using namespace beewatch::http;
+
+//==============================================================================
+SCENARIO("Negotiation headers are parsed into quality values", "[negotiation][http][core]")
+{
+    auto qualities = parseQualityValues(" GZIP;q=0.5 , deflate,br ; q=0,, ");
+
+    REQUIRE(qualities.size() == 3);
+
+    REQUIRE(qualities["gzip"] == 0.5);
+    REQUIRE(qualities["deflate"] == 1.0);
+    REQUIRE(qualities["br"] == 0.0);
+}
+
+SCENARIO("Response encoding is negotiated from Accept-Encoding", "[negotiation][http][core]")
+{
+    THEN("gzip is preferred when accepted")
+    {
+        REQUIRE(negotiateEncoding("gzip, deflate, br") == ContentEncoding::Gzip);
+        REQUIRE(negotiateEncoding("deflate, GZIP") == ContentEncoding::Gzip);
+        REQUIRE(negotiateEncoding("*") == ContentEncoding::Gzip);
+    }
+
+    THEN("quality values are honoured")
+    {
+        REQUIRE(negotiateEncoding("gzip;q=0.5, deflate") == ContentEncoding::Deflate);
+        REQUIRE(negotiateEncoding("gzip; q=0, deflate;q=0.1") == ContentEncoding::Deflate);
+        REQUIRE(negotiateEncoding("gzip;q=0") == ContentEncoding::Identity);
+    }
+
+    THEN("unsupported or missing encodings fall back to identity")
+    {
+        REQUIRE(negotiateEncoding("") == ContentEncoding::Identity);
+        REQUIRE(negotiateEncoding("br, identity") == ContentEncoding::Identity);
+    }
+
+    THEN("encodings map to their Content-Encoding tokens")
+    {
+        REQUIRE(toString(ContentEncoding::Gzip) == "gzip");
+        REQUIRE(toString(ContentEncoding::Deflate) == "deflate");
+    }
+}
+
+SCENARIO("Response format is negotiated from Accept", "[negotiation][http][core]")
+{
+    THEN("JSON is the default")
+    {
+        REQUIRE(negotiateMediaType("") == MediaType::Json);
+        REQUIRE(negotiateMediaType("*/*") == MediaType::Json);
+        REQUIRE(negotiateMediaType("application/json, text/plain, */*") == MediaType::Json);
+    }
+
+    THEN("CBOR is picked when explicitly preferred")
+    {
+        REQUIRE(negotiateMediaType("application/cbor") == MediaType::Cbor);
+        REQUIRE(negotiateMediaType("application/cbor, application/json;q=0.9") == MediaType::Cbor);
+        REQUIRE(negotiateMediaType("application/cbor, */*") == MediaType::Cbor);
+    }
+
+    THEN("JSON is kept when preferred over CBOR")
+    {
+        REQUIRE(negotiateMediaType("application/cbor;q=0.5, application/json") == MediaType::Json);
+        REQUIRE(negotiateMediaType("application/cbor;q=0") == MediaType::Json);
+    }
+
+    THEN("formats map to their MIME types")
+    {
+        REQUIRE(toString(MediaType::Json) == "application/json");
+        REQUIRE(toString(MediaType::Cbor) == "application/cbor");
+    }
+}
+
+SCENARIO("Conditional requests are matched against entity tags", "[negotiation][http][core]")
+{
+    const std::string etag = "\"3-1200-1545097428\"";
+
+    THEN("strong and weak tags match alike")
+    {
+        REQUIRE(matchesETag("\"3-1200-1545097428\"", etag));
+        REQUIRE(matchesETag("W/\"3-1200-1545097428\"", etag));
+        REQUIRE(matchesETag("\"3-1200-1545097428\"", "W/" + etag));
+    }
+
+    THEN("any tag of a list matches, regardless of whitespace")
+    {
+        REQUIRE(matchesETag("\"1-10-1545000000\", W/\"3-1200-1545097428\"", etag));
+        REQUIRE(matchesETag("\"1-10-1545000000\",\t \"3-1200-1545097428\" ", etag));
+        REQUIRE(matchesETag(" W/\"3-1200-1545097428\" ,\"1-10-1545000000\"", etag));
+    }
+
+    THEN("a wildcard matches any tag")
+    {
+        REQUIRE(matchesETag("*", etag));
+        REQUIRE(matchesETag(" * ", etag));
+    }
+
+    THEN("other tags don't match")
+    {
+        REQUIRE_FALSE(matchesETag("", etag));
+        REQUIRE_FALSE(matchesETag("\"3-1201-1545097428\"", etag));
+        REQUIRE_FALSE(matchesETag("W/\"3-1200-1545097428-cbor\", \"2-1200-1545097428\"", etag));
+        REQUIRE_FALSE(matchesETag("3-1200-1545097428", etag));
+    }
+}
+
+SCENARIO("Timestamps are formatted as HTTP dates", "[negotiation][http][core]")
+{
+    REQUIRE(formatHttpDate(784111777) == "Sun, 06 Nov 1994 08:49:37 GMT");
+    REQUIRE(formatHttpDate(1545097428) == "Tue, 18 Dec 2018 01:43:48 GMT");
+}
@@ -9,6 +9,10 @@
 #include "catch.hpp"
 #include "wiringPiMock.hpp"
 
+#include <array>
+#include <cstdint>
+#include <vector>
+
 /**
  * How to write tests with Catch:
  * https://github.com/catchorg/Catch2/blob/master/docs/tutorial.md#bdd-style
@@ -17,6 +21,44 @@
 using namespace beewatch;
 
 using hw::DHTxx;
+using io::GPIO;
+using io::LogicalState;
+
+/// Build the edges seen on the data line during a transfer: start signal, response & data bits
+static std::vector<GPIO::Edge> simulateTransfer(const std::array<uint8_t, DHTxx::READ_BYTES>& bytes,
+                                                double jitterMs = 0.0)
+{
+    std::vector<GPIO::Edge> edges;
+    double timeMs = 0.0;
+
+    auto addEdge = [&](LogicalState state, double durationMs) {
+            // Alternate early & late edges to widen & narrow pulses
+            double jitter = edges.size() % 2 == 0 ? jitterMs : -jitterMs;
+
+            edges.push_back({ timeMs + jitter, state });
+            timeMs += durationMs;
+        };
+
+    // Start signal, then response
+    addEdge(LogicalState::LO, 20.0);
+    addEdge(LogicalState::HI, 60e-3);
+    addEdge(LogicalState::LO, 80e-3);
+    addEdge(LogicalState::HI, 80e-3);
+
+    for (int bit = 0; bit < DHTxx::READ_BITS; ++bit)
+    {
+        bool isSet = bytes[bit / 8] & (0b1000'0000 >> (bit % 8));
+
+        addEdge(LogicalState::LO, 50e-3);
+        addEdge(LogicalState::HI, isSet ? 70e-3 : 27e-3);
+    }
+
+    // End of transfer, then line is released
+    addEdge(LogicalState::LO, 50e-3);
+    addEdge(LogicalState::HI, 0.0);
+
+    return edges;
+}
 
 //==============================================================================
 SCENARIO("Application can communicate with a mocked DHT11 sensor", "[dht][hw]")
@@ -24,3 +66,63 @@ SCENARIO("Application can communicate with a mocked DHT11 sensor", "[dht][hw]")
     // Disable logger
     g_logger.setVerbosity(Logger::Level::Unattainable);
 }
+
+//==============================================================================
+SCENARIO("DHT transfers are decoded from timestamped edges", "[dht][hw]")
+{
+    // Disable logger
+    g_logger.setVerbosity(Logger::Level::Unattainable);
+
+    const std::array<uint8_t, DHTxx::READ_BYTES> bytes { { 0x02, 0x8C, 0x01, 0x5F, 0xEE } };
+    const std::array<uint8_t, DHTxx::READ_BYTES> readError { { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF } };
+
+    GIVEN("the edges of a complete transfer")
+    {
+        auto edges = simulateTransfer(bytes);
+
+        THEN("the bytes sent are decoded")
+        {
+            REQUIRE(DHTxx::decodeEdges(edges) == bytes);
+        }
+    }
+
+    GIVEN("the edges of a transfer timestamped with some latency")
+    {
+        auto edges = simulateTransfer(bytes, 8e-3);
+
+        THEN("the bytes sent are still decoded")
+        {
+            REQUIRE(DHTxx::decodeEdges(edges) == bytes);
+        }
+    }
+
+    GIVEN("a transfer in which a bit's edges were missed")
+    {
+        auto edges = simulateTransfer(bytes);
+        edges.erase(edges.begin() + 40, edges.begin() + 42);
+
+        THEN("it is reported as incomplete")
+        {
+            REQUIRE(DHTxx::decodeEdges(edges) == readError);
+        }
+    }
+
+    GIVEN("a transfer cut short")
+    {
+        auto edges = simulateTransfer(bytes);
+        edges.resize(50);
+
+        THEN("it is reported as incomplete")
+        {
+            REQUIRE(DHTxx::decodeEdges(edges) == readError);
+        }
+    }
+
+    GIVEN("no edges at all")
+    {
+        THEN("nothing is decoded")
+        {
+            REQUIRE(DHTxx::decodeEdges({}) == readError);
+        }
+    }
+}
@@ -10,8 +10,14 @@
 #include "catch.hpp"
 #include "wiringPiMock.hpp"
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <cstdlib>
 #include <ctime>
+#include <iostream>
+#include <string>
+#include <thread>
 
 /**
  * How to write tests with Catch:
@@ -25,6 +31,46 @@ using io::GPIO;
 
 static void mockCallback() {}
 
+/// Models the BCM283x function select registers, which pack the modes of 10 pins each
+class SharedRegisterWiringPi final : public external::IWiringPi
+{
+public:
+    uint32_t functionSelect[3] = { 0, 0, 0 };
+
+    /// Number of times a register was modified while another change was in progress
+    std::atomic<int> numOverlaps{ 0 };
+
+    virtual void pinMode(int pin, int mode) override
+    {
+        if (_numWriters++ > 0)
+            numOverlaps++;
+
+        auto& reg = functionSelect[pin / 10];
+        int shift = 3 * (pin % 10);
+
+        // Read-modify-write, slowed down so unserialised updates would overlap
+        uint32_t value = reg;
+        std::this_thread::yield();
+        reg = (value & ~(7u << shift)) | ((uint32_t)mode << shift);
+
+        _numWriters--;
+    }
+
+    int getPinMode(int pin) const { return (functionSelect[pin / 10] >> 3 * (pin % 10)) & 7; }
+
+    virtual int digitalRead(int) override { return c_low; }
+    virtual void digitalWrite(int, int) override {}
+    virtual void pwmWrite(int, int) override {}
+    virtual void pullUpDnControl(int, int) override {}
+    virtual void pwmSetMode(int) override {}
+    virtual void pwmSetRange(unsigned int) override {}
+    virtual void pwmSetClock(int) override {}
+    virtual int setISR(int, int, void(*)(void)) override { return 0; }
+
+private:
+    std::atomic<int> _numWriters{ 0 };
+};
+
 //==============================================================================
 SCENARIO("Claim and release GPIOs", "[gpio][io][core]")
 {
@@ -305,6 +351,107 @@ SCENARIO("Configure, read & write pins using a GPIO object", "[gpio][io][core]")
             }
         }
 
+        // Edge capture
+        WHEN("we capture edges into a buffer")
+        {
+            gpio->startEdgeCapture(GPIO::EdgeType::Both, 4);
+
+            REQUIRE(gpio->getEdgeDetection() == GPIO::EdgeType::Both);
+            REQUIRE(wiringPiMock->currentEdgeType == wiringPiMock->c_intEdgeBoth);
+
+            // Simulate more edges than the buffer can hold
+            for (int i = 0; i < 6; ++i)
+            {
+                wiringPiMock->currentValue = i % 2 == 0 ? wiringPiMock->c_low : wiringPiMock->c_high;
+                wiringPiMock->currentISR();
+            }
+
+            auto edges = gpio->stopEdgeCapture();
+
+            THEN("edges are timestamped in order with the state they lead to, up to the buffer's capacity")
+            {
+                REQUIRE(edges.size() == 4);
+
+                for (size_t i = 0; i < edges.size(); ++i)
+                {
+                    REQUIRE(edges[i].state == (i % 2 == 0 ? LogicalState::LO : LogicalState::HI));
+
+                    if (i > 0)
+                        REQUIRE(edges[i].timeMs >= edges[i - 1].timeMs);
+                }
+            }
+
+            THEN("edge detection is disabled once capture stops, leaving the capture ISR set")
+            {
+                REQUIRE(gpio->getEdgeDetection() == GPIO::EdgeType::None);
+                REQUIRE(wiringPiMock->currentISR != &GPIO::nop);
+            }
+
+            AND_WHEN("we capture edges again")
+            {
+                int numISRsSet = wiringPiMock->numISRsSet;
+
+                // Edges between captures are ignored
+                wiringPiMock->currentISR();
+
+                gpio->startEdgeCapture(GPIO::EdgeType::Both, 4);
+
+                wiringPiMock->currentValue = wiringPiMock->c_high;
+                wiringPiMock->currentISR();
+
+                auto newEdges = gpio->stopEdgeCapture();
+
+                THEN("the capture ISR isn't set again, unless the edge type changes")
+                {
+                    REQUIRE(wiringPiMock->numISRsSet == numISRsSet);
+
+                    REQUIRE(newEdges.size() == 1);
+                    REQUIRE(newEdges[0].state == LogicalState::HI);
+
+                    gpio->startEdgeCapture(GPIO::EdgeType::Rising, 4);
+
+                    REQUIRE(wiringPiMock->numISRsSet == numISRsSet + 1);
+                    REQUIRE(wiringPiMock->currentEdgeType == wiringPiMock->c_intEdgeRising);
+
+                    gpio->stopEdgeCapture();
+                }
+            }
+        }
+
+        WHEN("we capture edges timestamped as they occurred by the wiringPi implementation")
+        {
+            wiringPiMock->hasTimestampedISR = true;
+
+            gpio->startEdgeCapture(GPIO::EdgeType::Both, 4);
+
+            REQUIRE(wiringPiMock->currentTimestampedISR != nullptr);
+
+            wiringPiMock->currentTimestampedISR(4, wiringPiMock->c_high, 1.5);
+            wiringPiMock->currentTimestampedISR(4, wiringPiMock->c_low, 1.6);
+
+            auto edges = gpio->stopEdgeCapture();
+
+            THEN("their timestamps are kept")
+            {
+                REQUIRE(edges.size() == 2);
+
+                REQUIRE(edges[0].timeMs == Approx(1.5));
+                REQUIRE(edges[0].state == LogicalState::HI);
+
+                REQUIRE(edges[1].timeMs == Approx(1.6));
+                REQUIRE(edges[1].state == LogicalState::LO);
+            }
+        }
+
+        WHEN("we capture edges without an edge type or a buffer")
+        {
+            THEN("an invalid_argument exception should be thrown")
+            {
+                REQUIRE_THROWS_AS(gpio->startEdgeCapture(GPIO::EdgeType::None, 4), std::invalid_argument);
+                REQUIRE_THROWS_AS(gpio->startEdgeCapture(GPIO::EdgeType::Both, 0), std::invalid_argument);
+            }
+        }
+
         // Read
         AND_GIVEN("the GPIO is configured as input")
         {
@@ -401,3 +548,98 @@ SCENARIO("Configure, read & write pins using a GPIO object", "[gpio][io][core]")
         }
     }
 }
+
+SCENARIO("Configure GPIOs sharing a register from several threads", "[gpio][io][core]")
+{
+    // Disable logger
+    g_logger.setVerbosity(Logger::Level::Unattainable);
+
+    GIVEN("two GPIOs whose modes are held in the same register")
+    {
+        static constexpr int c_numChanges = 10000;
+
+        auto wiringPi = std::make_shared<SharedRegisterWiringPi>();
+
+        GPIO::Ptr first = GPIO::claim(14, wiringPi);
+        GPIO::Ptr second = GPIO::claim(16, wiringPi);
+
+        REQUIRE(first != nullptr);
+        REQUIRE(second != nullptr);
+
+        WHEN("each one is switched between input & output on its own thread")
+        {
+            auto toggle = [](GPIO& gpio) {
+                for (int i = 0; i < c_numChanges; ++i)
+                    gpio.setMode(i % 2 == 0 ? GPIO::Mode::Output : GPIO::Mode::Input);
+
+                gpio.setMode(GPIO::Mode::Output);
+            };
+
+            std::thread firstThread(toggle, std::ref(*first));
+            std::thread secondThread(toggle, std::ref(*second));
+
+            firstThread.join();
+            secondThread.join();
+
+            THEN("no mode change is lost")
+            {
+                REQUIRE(wiringPi->numOverlaps == 0);
+                REQUIRE(wiringPi->getPinMode(14) == wiringPi->c_output);
+                REQUIRE(wiringPi->getPinMode(16) == wiringPi->c_output);
+            }
+        }
+    }
+}
+
+//==============================================================================
+SCENARIO("Benchmark per-call cost of GPIO reads, writes & configuration", "[gpio][benchmark][!hide]")
+{
+    using namespace std::chrono;
+
+    static constexpr int c_numCalls = 1'000'000;
+
+    // Disable logger
+    g_logger.setVerbosity(Logger::Level::Unattainable);
+
+    auto benchmark = [](const std::string& name, auto call) {
+            auto startTime = steady_clock::now();
+
+            for (int i = 0; i < c_numCalls; ++i)
+                call(i);
+
+            double elapsedNs = duration<double, std::nano>(steady_clock::now() - startTime).count();
+
+            std::cout << name << ": " << elapsedNs / c_numCalls << " ns/call" << std::endl;
+        };
+
+    GIVEN("a GPIO with a mocked wiringPi implementation")
+    {
+        auto wiringPiMock = std::make_shared<WiringPiMocked>();
+        GPIO::Ptr gpio = GPIO::claim(4, wiringPiMock);
+
+        gpio->setMode(GPIO::Mode::Output);
+
+        benchmark("GPIO::write()", [&](int i) {
+                gpio->write(i % 2 == 0 ? LogicalState::HI : LogicalState::LO);
+            });
+
+        gpio->setMode(GPIO::Mode::Input);
+        wiringPiMock->currentValue = wiringPiMock->c_high;
+
+        int numHigh = 0;
+
+        benchmark("GPIO::read()", [&](int) {
+                numHigh += gpio->read() == LogicalState::HI;
+            });
+
+        benchmark("GPIO::setResistorMode()", [&](int i) {
+                gpio->setResistorMode(i % 2 == 0 ? GPIO::Resistor::PullUp : GPIO::Resistor::PullDown);
+            });
+
+        THEN("all calls reach the wiringPi implementation")
+        {
+            REQUIRE(numHigh == c_numCalls);
+            REQUIRE(wiringPiMock->currentPudMode == wiringPiMock->c_pudDown);
+        }
+    }
+}
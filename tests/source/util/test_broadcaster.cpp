@@ -0,0 +1,139 @@
+//==============================================================================
+// Copyright (c) 2018 Eric Seguin, all rights reserved.
+//==============================================================================
+
+#include "util/broadcaster.h"
+
+#include "catch.hpp"
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+/**
+ * How to write tests with Catch:
+ * https://github.com/catchorg/Catch2/blob/master/docs/tutorial.md#bdd-style
+ */
+
+using namespace beewatch;
+using namespace std::chrono;
+
+//==============================================================================
+static ClimateSample makeSample(int64_t timestamp)
+{
+    return { "interior", timestamp, { 50.0, 20.0 } };
+}
+
+//==============================================================================
+SCENARIO("Live climate samples are fanned out to subscribers", "[broadcaster][util][core]")
+{
+    GIVEN("a broadcaster with two subscribers, one of them with a small queue")
+    {
+        ClimateBroadcaster broadcaster;
+
+        auto fast = broadcaster.subscribe();
+        auto slow = broadcaster.subscribe(2);
+
+        REQUIRE(broadcaster.size() == 2);
+
+        THEN("waiting for samples times out when none are published")
+        {
+            auto startTime = steady_clock::now();
+
+            REQUIRE(fast->pop(milliseconds(20)).empty());
+            REQUIRE(steady_clock::now() - startTime >= milliseconds(20));
+        }
+
+        WHEN("we publish samples")
+        {
+            for (int64_t i = 0; i < 5; ++i)
+                broadcaster.publish(makeSample(i));
+
+            THEN("each subscriber receives them in order")
+            {
+                auto samples = fast->pop(milliseconds(0));
+
+                REQUIRE(samples.size() == 5);
+
+                for (int64_t i = 0; i < 5; ++i)
+                    REQUIRE(samples[i].timestamp == i);
+
+                REQUIRE(fast->dropped() == 0);
+                REQUIRE(fast->pop(milliseconds(0)).empty());
+            }
+
+            THEN("a subscriber falling behind only keeps the latest samples")
+            {
+                auto samples = slow->pop(milliseconds(0));
+
+                REQUIRE(samples.size() == 2);
+                REQUIRE(samples[0].timestamp == 3);
+                REQUIRE(samples[1].timestamp == 4);
+
+                REQUIRE(slow->dropped() == 3);
+            }
+        }
+
+        WHEN("a subscriber is released")
+        {
+            slow.reset();
+            broadcaster.publish(makeSample(0));
+
+            THEN("it is removed and others still receive samples")
+            {
+                REQUIRE(broadcaster.size() == 1);
+                REQUIRE(fast->pop(milliseconds(0)).size() == 1);
+            }
+        }
+
+        WHEN("a consumer waits on another thread")
+        {
+            std::vector<ClimateSample> received;
+
+            std::thread consumer([&]() { received = fast->pop(seconds(5)); });
+
+            std::this_thread::sleep_for(milliseconds(20));
+            broadcaster.publish(makeSample(42));
+
+            consumer.join();
+
+            THEN("it is woken up by the published sample")
+            {
+                REQUIRE(received.size() == 1);
+                REQUIRE(received[0].timestamp == 42);
+            }
+        }
+
+        WHEN("a subscription is closed")
+        {
+            std::thread consumer([&]() { fast->pop(seconds(5)); });
+
+            auto startTime = steady_clock::now();
+
+            fast->close();
+            consumer.join();
+
+            broadcaster.publish(makeSample(0));
+
+            THEN("waiting consumers return immediately and no more samples are queued")
+            {
+                REQUIRE(steady_clock::now() - startTime < seconds(5));
+                REQUIRE(fast->isClosed());
+                REQUIRE(fast->pop(milliseconds(0)).empty());
+            }
+        }
+    }
+
+    GIVEN("a subscription outliving its broadcaster")
+    {
+        auto broadcaster = std::make_unique<ClimateBroadcaster>();
+        auto subscription = broadcaster->subscribe();
+
+        broadcaster.reset();
+
+        THEN("it is closed")
+        {
+            REQUIRE(subscription->isClosed());
+        }
+    }
+}
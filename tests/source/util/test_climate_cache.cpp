@@ -0,0 +1,198 @@
+//==============================================================================
+// Copyright (c) 2018 Eric Seguin, all rights reserved.
+//==============================================================================
+
+#include "util/climate_cache.h"
+
+#include "catch.hpp"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+/**
+ * How to write tests with Catch:
+ * https://github.com/catchorg/Catch2/blob/master/docs/tutorial.md#bdd-style
+ */
+
+using namespace beewatch;
+
+//==============================================================================
+static ClimateSeries makeSeries(int64_t firstTime, size_t numSamples)
+{
+    ClimateSeries series;
+
+    for (size_t i = 0; i < numSamples; ++i)
+        series.push_back(firstTime + 300 * (int64_t)i, { 50.0 + i, 20.0 + i });
+
+    return series;
+}
+
+//==============================================================================
+SCENARIO("Recent climate samples are served from a ring buffer", "[cache][util][core]")
+{
+    static constexpr int64_t c_maxTime = std::numeric_limits<int64_t>::max();
+
+    THEN("an empty buffer is refused")
+    {
+        REQUIRE_THROWS_AS(ClimateCache(0), std::invalid_argument);
+    }
+
+    GIVEN("a cache holding up to 10 samples per sensor")
+    {
+        ClimateCache cache(10);
+        ClimateSeries series;
+
+        THEN("unknown sensors are left to the DB")
+        {
+            REQUIRE_FALSE(cache.get("interior", 0, c_maxTime, 0, series));
+        }
+
+        WHEN("a sensor's first samples are added")
+        {
+            cache.add("interior", makeSeries(1000, 5));
+
+            THEN("its whole history is served")
+            {
+                REQUIRE(cache.get("interior", 0, c_maxTime, 0, series));
+                REQUIRE(series.timestamps == std::vector<int64_t>{ 1000, 1300, 1600, 1900, 2200 });
+                REQUIRE(series.humidity[2] == 52.0);
+                REQUIRE(series.temperature[2] == 22.0);
+            }
+
+            THEN("windows and pages are served")
+            {
+                REQUIRE(cache.get("interior", 1300, 2200, 0, series));
+                REQUIRE(series.timestamps == std::vector<int64_t>{ 1300, 1600, 1900 });
+
+                REQUIRE(cache.get("interior", 1001, c_maxTime, 2, series));
+                REQUIRE(series.timestamps == std::vector<int64_t>{ 1300, 1600 });
+
+                REQUIRE(cache.get("interior", 2201, c_maxTime, 0, series));
+                REQUIRE(series.empty());
+            }
+        }
+
+        WHEN("more samples are added than it can hold")
+        {
+            cache.add("interior", makeSeries(1000, 8));
+
+            std::vector<ClimateSample> samples;
+
+            for (int64_t t = 3400; t <= 4000; t += 300)
+            {
+                samples.push_back({ "interior", t, { 60.0, 30.0 } });
+                samples.push_back({ "exterior", t, { 80.0, 10.0 } });
+            }
+
+            cache.add(samples);
+
+            THEN("only the most recent samples are kept")
+            {
+                REQUIRE(cache.getCoveredSince("interior") == 1001);
+
+                REQUIRE(cache.get("interior", 1001, c_maxTime, 0, series));
+                REQUIRE(series.size() == 10);
+                REQUIRE(series.timestamps.front() == 1300);
+                REQUIRE(series.timestamps.back() == 4000);
+                REQUIRE(series.humidity.back() == 60.0);
+            }
+
+            THEN("queries reaching past the oldest sample are left to the DB")
+            {
+                REQUIRE_FALSE(cache.get("interior", 1000, c_maxTime, 0, series));
+                REQUIRE(cache.get("exterior", 0, c_maxTime, 0, series));
+                REQUIRE(series.size() == 3);
+            }
+        }
+
+        WHEN("a sample arrives out of order")
+        {
+            cache.add("interior", makeSeries(1000, 5));
+            cache.add({ { "interior", 1500, { 0.0, 0.0 } } });
+
+            THEN("only samples after the newest one are still served")
+            {
+                REQUIRE_FALSE(cache.get("interior", 1400, c_maxTime, 0, series));
+                REQUIRE(cache.getCoveredSince("interior") == 2201);
+            }
+        }
+
+        WHEN("it is seeded with a sensor's latest samples")
+        {
+            cache.add("interior", makeSeries(0, 3));
+            cache.seed("interior", makeSeries(1000, 5), false);
+            cache.seed("exterior", makeSeries(1000, 5), true);
+
+            THEN("they replace the buffer, which only covers what follows the first one unless complete")
+            {
+                REQUIRE(cache.getCoveredSince("interior") == 1001);
+                REQUIRE_FALSE(cache.get("interior", 1000, c_maxTime, 0, series));
+
+                REQUIRE(cache.get("interior", 1001, c_maxTime, 0, series));
+                REQUIRE(series.timestamps == std::vector<int64_t>{ 1300, 1600, 1900, 2200 });
+
+                REQUIRE(cache.get("exterior", 0, c_maxTime, 0, series));
+                REQUIRE(series.size() == 5);
+            }
+        }
+
+        WHEN("it is cleared")
+        {
+            cache.add("interior", makeSeries(1000, 5));
+            cache.clear();
+
+            THEN("samples are no longer served")
+            {
+                REQUIRE_FALSE(cache.get("interior", 0, c_maxTime, 0, series));
+            }
+        }
+    }
+
+    GIVEN("readers querying the cache while samples are added")
+    {
+        ClimateCache cache(100);
+        cache.add("interior", makeSeries(0, 1));
+
+        std::atomic<bool> isWriting(true);
+        std::atomic<size_t> numInconsistentReads(0);
+        std::vector<std::thread> readers;
+
+        for (int i = 0; i < 4; ++i)
+        {
+            readers.emplace_back([&]() {
+                ClimateSeries series;
+
+                while (isWriting)
+                {
+                    cache.get("interior", 0, c_maxTime, 0, series);
+
+                    // Each snapshot holds consecutive samples, with matching columns
+                    for (size_t j = 1; j < series.size(); ++j)
+                    {
+                        if (series.timestamps[j] != series.timestamps[j - 1] + 300 ||
+                            series.humidity[j] - series.humidity[j - 1] != 1.0)
+                        {
+                            numInconsistentReads++;
+                        }
+                    }
+                }
+            });
+        }
+
+        auto series = makeSeries(0, 1000);
+
+        for (size_t i = 1; i < series.size(); ++i)
+            cache.add({ { "interior", series.timestamps[i], series.data(i) } });
+
+        isWriting = false;
+
+        for (auto& reader : readers)
+            reader.join();
+
+        THEN("they always see consistent snapshots")
+        {
+            REQUIRE(numInconsistentReads == 0);
+        }
+    }
+}
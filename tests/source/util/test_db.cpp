@@ -0,0 +1,402 @@
+//==============================================================================
+// Copyright (c) 2018 Eric Seguin, all rights reserved.
+//==============================================================================
+
+#include "util/db.h"
+
+#include "global/logging.h"
+#include "global/time.hpp"
+
+#include "catch.hpp"
+
+#include <pqxx/pqxx>
+
+#include <atomic>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * How to write tests with Catch:
+ * https://github.com/catchorg/Catch2/blob/master/docs/tutorial.md#bdd-style
+ *
+ * NB: The scenarios below need a PostgreSQL instance reachable with the default
+ *     DB settings, which is why they are hidden unless requested explicitly:
+ *
+ *     testbeewatch "[db]"
+ */
+
+using namespace beewatch;
+
+//==============================================================================
+static constexpr auto c_testDBName = "beewatch_test";
+
+static std::string getConnectionString(std::string dbName = DB::DEFAULT_NAME)
+{
+    return "dbname = " + dbName + " "
+           "user = postgres password = postgres "
+           "hostaddr = " + DB::DEFAULT_HOST + " port = " + std::to_string(DB::DEFAULT_PORT);
+}
+
+/// Drop & recreate scratch database, used by scenarios that work on the application's tables
+static void resetTestDB()
+{
+    pqxx::connection conn(getConnectionString("postgres"));
+    pqxx::nontransaction txn(conn);
+
+    txn.exec(std::string("DROP DATABASE IF EXISTS ") + c_testDBName + ";");
+    txn.exec(std::string("CREATE DATABASE ") + c_testDBName + ";");
+}
+
+/// Run query in autocommit mode, so that its effects (e.g. ANALYZE) persist, and return its duration in milliseconds
+static double timeQuery(pqxx::connection& conn, std::string query)
+{
+    double startMs = g_timeRaw.now();
+
+    pqxx::nontransaction txn(conn);
+    txn.exec(query);
+
+    return g_timeRaw.now() - startMs;
+}
+
+static void printRate(std::string label, int count, double elapsedMs)
+{
+    std::cout << label << ": " << count << " inserts in " << elapsedMs << " ms ("
+              << (int)(count / (elapsedMs / 1e3)) << " inserts/s)" << std::endl;
+}
+
+//==============================================================================
+SCENARIO("Benchmark climate sample inserts with and without prepared statements", "[db][benchmark][!hide]")
+{
+    // Disable logger
+    g_logger.setVerbosity(Logger::Level::Unattainable);
+
+    static constexpr int c_numInserts = 1000;
+
+    GIVEN("a connection to the default DB and an empty scratch table")
+    {
+        pqxx::connection conn(getConnectionString());
+
+        {
+            pqxx::work txn(conn);
+            txn.exec("DROP TABLE IF EXISTS ClimateDataBench;");
+            txn.exec("CREATE TABLE ClimateDataBench ("
+                     "  rowguid         SERIAL          PRIMARY KEY     NOT NULL,"
+                     "  SensorID        VARCHAR(256)                    NOT NULL,"
+                     "  Time            BIGINT                          NOT NULL,"
+                     "  Temperature     NUMERIC                         NOT NULL,"
+                     "  Humidity        NUMERIC                         NOT NULL"
+                     "  );");
+            txn.commit();
+        }
+
+        WHEN("we insert samples one transaction at a time, building each query as a string")
+        {
+            double startMs = g_timeRaw.now();
+
+            for (int i = 0; i < c_numInserts; ++i)
+            {
+                pqxx::work txn(conn);
+                txn.exec("INSERT INTO ClimateDataBench (SensorID, Time, Temperature, Humidity)"
+                         "  VALUES ('interior', " + std::to_string(i) + ", " +
+                         std::to_string(20.5) + ", " + std::to_string(55.0) + ");");
+                txn.commit();
+            }
+
+            double elapsedMs = g_timeRaw.now() - startMs;
+            printRate("String-built INSERT", c_numInserts, elapsedMs);
+
+            THEN("all samples are stored")
+            {
+                pqxx::work txn(conn);
+                REQUIRE(txn.exec("SELECT 1 FROM ClimateDataBench;").size() == (size_t)c_numInserts);
+            }
+        }
+
+        WHEN("we insert samples one transaction at a time through a prepared statement")
+        {
+            conn.prepare("bench_insert",
+                         "INSERT INTO ClimateDataBench (SensorID, Time, Temperature, Humidity)"
+                         "  VALUES ($1, $2, $3, $4);");
+
+            double startMs = g_timeRaw.now();
+
+            for (int i = 0; i < c_numInserts; ++i)
+            {
+                pqxx::work txn(conn);
+                txn.exec_prepared("bench_insert", std::string("interior"), (int64_t)i, 20.5, 55.0);
+                txn.commit();
+            }
+
+            double elapsedMs = g_timeRaw.now() - startMs;
+            printRate("Prepared INSERT", c_numInserts, elapsedMs);
+
+            THEN("all samples are stored")
+            {
+                pqxx::work txn(conn);
+                REQUIRE(txn.exec("SELECT 1 FROM ClimateDataBench;").size() == (size_t)c_numInserts);
+            }
+        }
+
+        // Clean up scratch table
+        pqxx::work txn(conn);
+        txn.exec("DROP TABLE IF EXISTS ClimateDataBench;");
+        txn.commit();
+    }
+}
+
+//==============================================================================
+SCENARIO("Benchmark climate data queries before and after the schema migration", "[db][benchmark][!hide]")
+{
+    // Disable logger
+    g_logger.setVerbosity(Logger::Level::Unattainable);
+
+    static constexpr int c_tableSizes[] { 10'000, 100'000, 1'000'000 };
+    static constexpr int64_t c_firstTime = 1'500'000'000;
+    static constexpr int64_t c_sampleIntervalS = 300;
+
+    for (int tableSize : c_tableSizes)
+    GIVEN("a scratch DB holding " + std::to_string(tableSize) + " samples in the original schema")
+    {
+        resetTestDB();
+
+        pqxx::connection conn(getConnectionString(c_testDBName));
+
+        {
+            pqxx::work txn(conn);
+            txn.exec("CREATE TABLE ClimateData ("
+                     "  rowguid         SERIAL          PRIMARY KEY     NOT NULL,"
+                     "  SensorID        VARCHAR(256)                    NOT NULL,"
+                     "  Time            BIGINT                          NOT NULL,"
+                     "  Temperature     NUMERIC                         NOT NULL,"
+                     "  Humidity        NUMERIC                         NOT NULL"
+                     "  );");
+
+            // Two sensors sampled every 5 minutes
+            txn.exec("INSERT INTO ClimateData (SensorID, Time, Temperature, Humidity)"
+                     "  SELECT CASE WHEN i % 2 = 0 THEN 'interior' ELSE 'exterior' END,"
+                     "         " + std::to_string(c_firstTime) + " + (i / 2) * " + std::to_string(c_sampleIntervalS) + ","
+                     "         20.0 + (i % 10) * 0.5,"
+                     "         50.0 + (i % 7)"
+                     "  FROM generate_series(0, " + std::to_string(tableSize - 1) + ") AS i;");
+            txn.exec("ANALYZE ClimateData;");
+            txn.commit();
+        }
+
+        // Query the last day of samples for one sensor
+        const int64_t lastTime = c_firstTime + (tableSize / 2 - 1) * c_sampleIntervalS;
+        const int64_t since = lastTime - 24 * 3600;
+
+        WHEN("we query the last day of samples, then migrate the schema and query them again")
+        {
+            double legacyMs = timeQuery(conn,
+                "SELECT Time, Temperature, Humidity FROM ClimateData"
+                "  WHERE SensorID = 'interior' AND Time >= " + std::to_string(since) + ";");
+
+            double startMs = g_timeRaw.now();
+            DB db(c_testDBName);
+            double migrationMs = g_timeRaw.now() - startMs;
+
+            timeQuery(conn, "ANALYZE ClimateData;");
+
+            startMs = g_timeRaw.now();
+            auto samples = db.getClimateData("interior", since);
+            double migratedMs = g_timeRaw.now() - startMs;
+
+            std::cout << tableSize << " samples: original schema " << legacyMs << " ms, "
+                      << "migrated schema " << migratedMs << " ms "
+                      << "(migration took " << migrationMs << " ms)" << std::endl;
+
+            THEN("the migrated schema returns the same day of samples")
+            {
+                REQUIRE(samples.size() == 24 * 3600 / c_sampleIntervalS + 1);
+                REQUIRE(samples.timestamps.front() == since);
+            }
+        }
+    }
+}
+
+//==============================================================================
+SCENARIO("Benchmark concurrent climate data reads with and without a connection pool", "[db][benchmark][!hide]")
+{
+    // Disable logger
+    g_logger.setVerbosity(Logger::Level::Unattainable);
+
+    static constexpr int c_numReaders = 4;
+    static constexpr int c_numReadsPerReader = 50;
+    static constexpr int64_t c_firstTime = 1'500'000'000;
+
+    for (size_t poolSize : { (size_t)1, (size_t)c_numReaders })
+    GIVEN("a scratch DB holding a week of samples and a pool of " + std::to_string(poolSize) + " connection(s)")
+    {
+        resetTestDB();
+
+        DB db(c_testDBName, DB::DEFAULT_HOST, DB::DEFAULT_PORT, poolSize);
+
+        std::vector<ClimateSample> samples;
+
+        for (int64_t t = c_firstTime; t < c_firstTime + 7 * 24 * 3600; t += 300)
+            samples.push_back({ "interior", t, { 50.0, 20.0 } });
+
+        db.addClimateData(samples);
+
+        WHEN("several threads read the whole history at once")
+        {
+            std::atomic<size_t> numSamplesRead(0);
+            std::vector<std::thread> readers;
+
+            double startMs = g_timeRaw.now();
+
+            for (int i = 0; i < c_numReaders; ++i)
+            {
+                readers.emplace_back([&]() {
+                    for (int j = 0; j < c_numReadsPerReader; ++j)
+                        numSamplesRead += db.getClimateData("interior").size();
+                });
+            }
+
+            for (auto& reader : readers)
+                reader.join();
+
+            double elapsedMs = g_timeRaw.now() - startMs;
+
+            std::cout << "Pool of " << poolSize << ": " << c_numReaders * c_numReadsPerReader << " reads in "
+                      << elapsedMs << " ms (" << (int)(c_numReaders * c_numReadsPerReader / (elapsedMs / 1e3))
+                      << " reads/s)" << std::endl;
+
+            THEN("every read returns the whole history")
+            {
+                REQUIRE(numSamplesRead == samples.size() * c_numReaders * c_numReadsPerReader);
+            }
+        }
+    }
+}
+
+//==============================================================================
+SCENARIO("Benchmark climate data reads for several sensors, one query per sensor or a single query",
+         "[db][benchmark][!hide]")
+{
+    // Disable logger
+    g_logger.setVerbosity(Logger::Level::Unattainable);
+
+    static constexpr int c_numReads = 50;
+    static constexpr int64_t c_firstTime = 1'500'000'000;
+
+    GIVEN("a scratch DB holding a day of samples for several sensors, one of them named with quotes")
+    {
+        resetTestDB();
+
+        DB db(c_testDBName);
+
+        const std::vector<std::string> sensorIDs = { "interior", "exterior", "hive \"2\"", "hive\\3" };
+        std::vector<ClimateSample> samples;
+
+        for (const auto& sensorID : sensorIDs)
+            for (int64_t t = c_firstTime; t < c_firstTime + 24 * 3600; t += 60)
+                samples.push_back({ sensorID, t, { 50.0, 20.0 } });
+
+        db.addClimateData(samples);
+
+        WHEN("we read all sensors one query at a time, then in a single query")
+        {
+            size_t numSamplesPerSensor = 0;
+            double startMs = g_timeRaw.now();
+
+            for (int i = 0; i < c_numReads; ++i)
+                for (const auto& sensorID : sensorIDs)
+                    numSamplesPerSensor += db.getClimateData(sensorID).size();
+
+            double perSensorMs = (g_timeRaw.now() - startMs) / c_numReads;
+
+            size_t numSamplesSingle = 0;
+            std::map<std::string, ClimateSeries> data;
+            startMs = g_timeRaw.now();
+
+            for (int i = 0; i < c_numReads; ++i)
+            {
+                data = db.getClimateData(sensorIDs);
+
+                for (const auto& series : data)
+                    numSamplesSingle += series.second.size();
+            }
+
+            double singleMs = (g_timeRaw.now() - startMs) / c_numReads;
+
+            std::cout << sensorIDs.size() << " sensors: one query per sensor " << perSensorMs << " ms, "
+                      << "single query " << singleMs << " ms" << std::endl;
+
+            THEN("both return the same samples, grouped by sensor")
+            {
+                REQUIRE(numSamplesSingle == numSamplesPerSensor);
+                REQUIRE(data.size() == sensorIDs.size());
+
+                for (const auto& sensorID : sensorIDs)
+                    REQUIRE(data[sensorID].timestamps == db.getClimateData(sensorID).timestamps);
+            }
+        }
+    }
+}
+
+//==============================================================================
+SCENARIO("Benchmark climate data pages at the start and end of histories of growing size",
+         "[db][benchmark][!hide]")
+{
+    // Disable logger
+    g_logger.setVerbosity(Logger::Level::Unattainable);
+
+    static constexpr int c_tableSizes[] { 10'000, 100'000, 1'000'000 };
+    static constexpr size_t c_pageSize = 1000;
+    static constexpr int c_numReads = 20;
+    static constexpr int64_t c_firstTime = 1'500'000'000;
+
+    for (int tableSize : c_tableSizes)
+    GIVEN("a scratch DB holding " + std::to_string(tableSize) + " samples of a single sensor")
+    {
+        resetTestDB();
+
+        DB db(c_testDBName);
+
+        std::vector<ClimateSample> samples;
+
+        for (int i = 0; i < tableSize; ++i)
+            samples.push_back({ "interior", c_firstTime + 60 * (int64_t)i, { 50.0, 20.0 } });
+
+        db.addClimateData(samples);
+
+        {
+            pqxx::connection conn(getConnectionString(c_testDBName));
+            timeQuery(conn, "ANALYZE ClimateData;");
+        }
+
+        const std::vector<std::string> sensorIDs = { "interior" };
+
+        WHEN("we read the first and last pages of " + std::to_string(c_pageSize) + " samples")
+        {
+            const int64_t lastPageTime = samples[tableSize - c_pageSize].timestamp;
+            size_t numSamplesRead = 0;
+
+            double startMs = g_timeRaw.now();
+
+            for (int i = 0; i < c_numReads; ++i)
+                numSamplesRead += db.getClimateData(sensorIDs, 0, IDB::MAX_TIMESTAMP, c_pageSize)["interior"].size();
+
+            double firstPageMs = (g_timeRaw.now() - startMs) / c_numReads;
+            startMs = g_timeRaw.now();
+
+            for (int i = 0; i < c_numReads; ++i)
+                numSamplesRead += db.getClimateData(sensorIDs, lastPageTime, IDB::MAX_TIMESTAMP, c_pageSize)["interior"].size();
+
+            double lastPageMs = (g_timeRaw.now() - startMs) / c_numReads;
+
+            std::cout << tableSize << " samples: first page " << firstPageMs << " ms, "
+                      << "last page " << lastPageMs << " ms" << std::endl;
+
+            THEN("every page is full")
+            {
+                REQUIRE(numSamplesRead == 2 * c_numReads * c_pageSize);
+            }
+        }
+    }
+}
@@ -0,0 +1,94 @@
+//==============================================================================
+// Copyright (c) 2018 Eric Seguin, all rights reserved.
+//==============================================================================
+
+#include "util/decimate.h"
+
+#include "catch.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+/**
+ * How to write tests with Catch:
+ * https://github.com/catchorg/Catch2/blob/master/docs/tutorial.md#bdd-style
+ */
+
+using namespace beewatch;
+
+//==============================================================================
+SCENARIO("Climate series are decimated for display with LTTB", "[decimate][util][core]")
+{
+    GIVEN("a week of minute samples with a single temperature spike")
+    {
+        static constexpr size_t c_numSamples = 7 * 24 * 60;
+        static constexpr size_t c_spikeIndex = 4321;
+
+        ClimateSeries series;
+
+        for (size_t i = 0; i < c_numSamples; ++i)
+        {
+            ClimateData<double> data;
+
+            data.temperature = 20.0 + std::sin(i / 300.0) + (i == c_spikeIndex ? 15.0 : 0.0);
+            data.humidity = 50.0 + 5.0 * std::cos(i / 500.0);
+
+            series.push_back(1'500'000'000 + 60 * (int64_t)i, data);
+        }
+
+        THEN("too few points are rejected")
+        {
+            REQUIRE_THROWS_AS(decimateLTTB(series, 2), std::invalid_argument);
+        }
+
+        WHEN("we request more points than samples")
+        {
+            auto result = decimateLTTB(series, c_numSamples + 1);
+
+            THEN("the series is left untouched")
+            {
+                REQUIRE(result.timestamps == series.timestamps);
+                REQUIRE(result.temperature == series.temperature);
+                REQUIRE(result.humidity == series.humidity);
+            }
+        }
+
+        WHEN("we decimate it to 1000 points")
+        {
+            auto result = decimateLTTB(series, 1000);
+
+            THEN("exactly 1000 samples are kept, in time order")
+            {
+                REQUIRE(result.size() == 1000);
+                REQUIRE(result.temperature.size() == 1000);
+                REQUIRE(result.humidity.size() == 1000);
+
+                REQUIRE(std::is_sorted(result.timestamps.begin(), result.timestamps.end()));
+                REQUIRE(std::adjacent_find(result.timestamps.begin(), result.timestamps.end()) == result.timestamps.end());
+            }
+
+            THEN("the first and last samples are kept")
+            {
+                REQUIRE(result.timestamps.front() == series.timestamps.front());
+                REQUIRE(result.timestamps.back() == series.timestamps.back());
+            }
+
+            THEN("kept samples are original samples")
+            {
+                for (size_t i = 0; i < result.size(); ++i)
+                {
+                    size_t index = (result.timestamps[i] - series.timestamps.front()) / 60;
+
+                    REQUIRE(result.temperature[i] == series.temperature[index]);
+                    REQUIRE(result.humidity[i] == series.humidity[index]);
+                }
+            }
+
+            THEN("the spike is preserved")
+            {
+                REQUIRE(*std::max_element(result.temperature.begin(), result.temperature.end()) ==
+                        series.temperature[c_spikeIndex]);
+            }
+        }
+    }
+}
@@ -0,0 +1,388 @@
+//==============================================================================
+// Copyright (c) 2018 Eric Seguin, all rights reserved.
+//==============================================================================
+
+#include "util/embedded_db.h"
+
+#include "global/logging.h"
+#include "version.h"
+
+#include "catch.hpp"
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <fstream>
+
+/**
+ * How to write tests with Catch:
+ * https://github.com/catchorg/Catch2/blob/master/docs/tutorial.md#bdd-style
+ */
+
+using namespace beewatch;
+
+namespace fs = boost::filesystem;
+
+//==============================================================================
+/// Create an empty temporary directory, removed when going out of scope
+struct TempDirectory
+{
+    TempDirectory()
+        : path(fs::temp_directory_path() / fs::unique_path("beewatch-test-%%%%-%%%%"))
+    {
+        fs::create_directories(path);
+    }
+
+    ~TempDirectory()
+    {
+        boost::system::error_code error;
+        fs::remove_all(path, error);
+    }
+
+    fs::path path;
+};
+
+//==============================================================================
+SCENARIO("Climate data is stored in and read from the embedded DB", "[embedded][util][core]")
+{
+    // Disable logger
+    g_logger.setVerbosity(Logger::Level::Unattainable);
+
+    GIVEN("an empty embedded DB with small segments")
+    {
+        TempDirectory dir;
+        auto db = std::make_unique<EmbeddedDB>(dir.path.string(), 4);
+
+        THEN("it holds no climate data and the default name")
+        {
+            REQUIRE(db->getClimateData("interior").empty());
+            REQUIRE(db->getName() == PROJECT_NAME);
+        }
+
+        WHEN("we add samples spanning multiple segments")
+        {
+            std::vector<ClimateSample> samples;
+
+            for (int64_t t = 1; t <= 10; ++t)
+                samples.push_back({ "interior", t * 100, { 40.0 + t, 20.0 + t } });
+
+            db->addClimateData(samples);
+            db->addClimateData("exterior", 150, { 80.0, -5.0 });
+
+            THEN("all samples are read back in order")
+            {
+                auto data = db->getClimateData("interior");
+
+                REQUIRE(data.size() == 10);
+                REQUIRE(data.timestamps.front() == 100);
+                REQUIRE(data.timestamps.back() == 1000);
+                REQUIRE(data.timestamps[4] == 500);
+                REQUIRE(data.humidity[4] == Approx(45.0));
+                REQUIRE(data.temperature[4] == Approx(25.0));
+                REQUIRE(std::is_sorted(data.timestamps.begin(), data.timestamps.end()));
+
+                REQUIRE(db->getClimateData("exterior").size() == 1);
+                REQUIRE(fs::exists(dir.path / "climate" / "interior" / "2.seg"));
+            }
+
+            THEN("full segments are sealed into compressed chunks")
+            {
+                auto directory = dir.path / "climate" / "interior";
+
+                REQUIRE(fs::exists(directory / "0.chunk"));
+                REQUIRE(fs::exists(directory / "1.chunk"));
+                REQUIRE(!fs::exists(directory / "0.seg"));
+                REQUIRE(!fs::exists(directory / "1.seg"));
+
+                REQUIRE(fs::file_size(directory / "0.chunk") < fs::file_size(directory / "2.seg"));
+
+                AND_WHEN("the DB is reopened after sealing was interrupted before removing a segment file")
+                {
+                    db.reset();
+
+                    std::ofstream((directory / "1.seg").string());
+
+                    db = std::make_unique<EmbeddedDB>(dir.path.string(), 4);
+
+                    THEN("the sealed segment is used and the segment file removed")
+                    {
+                        auto data = db->getClimateData("interior");
+
+                        REQUIRE(data.size() == 10);
+                        REQUIRE(data.timestamps[5] == 600);
+                        REQUIRE(data.humidity[5] == Approx(46.0));
+                        REQUIRE(!fs::exists(directory / "1.seg"));
+                    }
+                }
+            }
+
+            THEN("reads since a given time only return newer samples")
+            {
+                auto data = db->getClimateData("interior", 450);
+
+                REQUIRE(data.size() == 6);
+                REQUIRE(data.timestamps.front() == 500);
+
+                REQUIRE(db->getClimateData("interior", 900).size() == 2);
+                REQUIRE(db->getClimateData("interior", 1001).empty());
+            }
+
+            THEN("several sensors can be read at once")
+            {
+                std::vector<std::string> sensorIDs = { "interior", "exterior", "unknown" };
+
+                auto data = db->getClimateData(sensorIDs, 450);
+
+                REQUIRE(data.size() == 1);
+                REQUIRE(data["interior"].size() == 6);
+                REQUIRE(data["interior"].timestamps == db->getClimateData("interior", 450).timestamps);
+
+                data = db->getClimateData(sensorIDs);
+
+                REQUIRE(data.size() == 2);
+                REQUIRE(data["exterior"].size() == 1);
+                REQUIRE(data["exterior"].humidity.front() == Approx(80.0));
+            }
+
+            THEN("reads can be bounded in time and paged")
+            {
+                std::vector<std::string> sensorIDs = { "interior", "exterior" };
+
+                auto data = db->getClimateData(sensorIDs, 200, 500);
+
+                REQUIRE(data["interior"].timestamps == std::vector<int64_t>{ 200, 300, 400 });
+                REQUIRE(data["exterior"].size() == 0);
+
+                data = db->getClimateData(sensorIDs, 0, IDB::MAX_TIMESTAMP, 4);
+
+                REQUIRE(data["interior"].timestamps == std::vector<int64_t>{ 100, 200, 300, 400 });
+                REQUIRE(data["exterior"].size() == 1);
+
+                data = db->getClimateData(sensorIDs, 401, IDB::MAX_TIMESTAMP, 4);
+
+                REQUIRE(data.size() == 1);
+                REQUIRE(data["interior"].timestamps == std::vector<int64_t>{ 500, 600, 700, 800 });
+            }
+
+            THEN("samples can be streamed in fixed-size batches")
+            {
+                std::vector<size_t> batchSizes;
+                std::vector<int64_t> timestamps;
+
+                db->visitClimateData("interior", 250, [&](const ClimateSeries& batch) {
+                    batchSizes.push_back(batch.size());
+                    timestamps.insert(timestamps.end(), batch.timestamps.begin(), batch.timestamps.end());
+
+                    return true;
+                }, 3);
+
+                REQUIRE(batchSizes == std::vector<size_t>{ 3, 3, 2 });
+                REQUIRE(timestamps.front() == 300);
+                REQUIRE(timestamps.back() == 1000);
+                REQUIRE(std::is_sorted(timestamps.begin(), timestamps.end()));
+            }
+
+            THEN("watermarks and latest samples are read without reading whole histories")
+            {
+                std::vector<std::string> sensorIDs = { "interior", "exterior", "unknown" };
+
+                auto watermarks = db->getClimateWatermarks(sensorIDs);
+
+                REQUIRE(watermarks.size() == 2);
+                REQUIRE(watermarks["interior"].count == 10);
+                REQUIRE(watermarks["interior"].lastTimestamp == 1000);
+                REQUIRE(watermarks["exterior"].count == 1);
+
+                auto latest = db->getLatestClimateData(sensorIDs, 6);
+
+                REQUIRE(latest.size() == 2);
+                REQUIRE(latest["interior"].timestamps == std::vector<int64_t>{ 500, 600, 700, 800, 900, 1000 });
+                REQUIRE(latest["interior"].humidity.front() == Approx(45.0));
+                REQUIRE(latest["exterior"].size() == 1);
+
+                REQUIRE(db->getLatestClimateData(sensorIDs, 20)["interior"].size() == 10);
+            }
+
+            THEN("streaming stops when the visitor returns false")
+            {
+                size_t numBatches = 0;
+
+                db->visitClimateData("interior", 0, [&](const ClimateSeries&) {
+                    return ++numBatches < 2;
+                }, 3);
+
+                REQUIRE(numBatches == 2);
+            }
+
+            AND_WHEN("we add an out-of-order sample")
+            {
+                db->addClimateData("interior", 50, { 0.0, 0.0 });
+
+                THEN("it is dropped")
+                {
+                    auto data = db->getClimateData("interior");
+
+                    REQUIRE(data.size() == 10);
+                    REQUIRE(data.timestamps.front() == 100);
+                }
+            }
+
+            AND_WHEN("the last samples of the batch are written again, as when a write is retried")
+            {
+                std::vector<ClimateSample> retried(samples.end() - 2, samples.end());
+                retried.push_back({ "interior", 1100, { 51.0, 31.0 } });
+
+                REQUIRE(db->addClimateData(retried));
+
+                THEN("samples which were already stored aren't duplicated")
+                {
+                    auto data = db->getClimateData("interior", 900);
+
+                    REQUIRE(data.timestamps == std::vector<int64_t>{ 900, 1000, 1100 });
+                }
+            }
+
+            AND_WHEN("the DB is reopened")
+            {
+                db.reset();
+                db = std::make_unique<EmbeddedDB>(dir.path.string(), 4);
+
+                db->addClimateData("interior", 1100, { 51.0, 31.0 });
+
+                THEN("previously stored samples are still there")
+                {
+                    auto data = db->getClimateData("interior");
+
+                    REQUIRE(data.size() == 11);
+                    REQUIRE(data.timestamps.back() == 1100);
+                    REQUIRE(db->getClimateData("interior", 950).size() == 2);
+                }
+            }
+
+            AND_WHEN("the DB is reopened after a crash while creating a segment")
+            {
+                db.reset();
+
+                auto directory = dir.path / "climate" / "interior";
+
+                std::ofstream((directory / "3.seg").string());
+                std::ofstream((directory / "backup.seg").string()) << "not a segment";
+
+                db = std::make_unique<EmbeddedDB>(dir.path.string(), 4);
+
+                THEN("the empty segment is reused and stray files are ignored")
+                {
+                    REQUIRE(db->getClimateData("interior").size() == 10);
+                    REQUIRE(db->addClimateData({ { "interior", 1100, { 51.0, 31.0 } } }));
+
+                    auto data = db->getClimateData("interior", 950);
+
+                    REQUIRE(data.timestamps == std::vector<int64_t>{ 1000, 1100 });
+                    REQUIRE(fs::file_size(directory / "3.seg") > 0);
+                }
+            }
+
+            AND_WHEN("the DB is reopened after its last segment was truncated")
+            {
+                db.reset();
+
+                // Header & first record of last segment are left
+                fs::resize_file(dir.path / "climate" / "interior" / "2.seg", 32 + 16);
+
+                db = std::make_unique<EmbeddedDB>(dir.path.string(), 4);
+
+                THEN("the records which were cut off are dropped")
+                {
+                    auto data = db->getClimateData("interior");
+
+                    REQUIRE(data.size() == 9);
+                    REQUIRE(data.timestamps.back() == 900);
+
+                    REQUIRE(db->addClimateData({ { "interior", 1100, { 51.0, 31.0 } } }));
+                    REQUIRE(db->getClimateData("interior", 950).timestamps == std::vector<int64_t>{ 1100 });
+                }
+            }
+
+            AND_WHEN("rollup aggregates are persisted, some of them twice")
+            {
+                ClimateAggregate hour;
+                hour.add({ 50.0, 20.0 });
+                hour.add({ 60.0, 30.0 });
+
+                REQUIRE(db->addClimateAggregates("interior", 3600, { { 0, hour }, { 3600, hour } }));
+
+                hour.add({ 40.0, 10.0 });
+
+                REQUIRE(db->addClimateAggregates("interior", 3600, { { 3600, hour } }));
+                REQUIRE(db->addClimateAggregates("interior", 86400, { { 0, hour } }));
+
+                THEN("the latest aggregates of each bucket are read back, across instances")
+                {
+                    db.reset();
+
+                    // A record cut off by a crash is ignored
+                    std::ofstream((dir.path / "climate" / "interior" / "3600.agg").string(),
+                                  std::ios::binary | std::ios::app) << "partial";
+
+                    db = std::make_unique<EmbeddedDB>(dir.path.string(), 4);
+
+                    auto hours = db->getClimateAggregates("interior", 3600);
+
+                    REQUIRE(hours.size() == 2);
+                    REQUIRE(hours[0].count == 2);
+                    REQUIRE(hours[3600].count == 3);
+                    REQUIRE(hours[3600].min.temperature == Approx(10.0));
+                    REQUIRE(hours[3600].mean.humidity == Approx(50.0));
+
+                    REQUIRE(db->getClimateAggregates("interior", 86400).size() == 1);
+                    REQUIRE(db->getClimateAggregates("exterior", 3600).empty());
+
+                    REQUIRE(db->addClimateAggregates("interior", 3600, { { 7200, hour } }));
+                    REQUIRE(db->getClimateAggregates("interior", 3600).size() == 3);
+                }
+            }
+
+            AND_WHEN("the climate data is cleared")
+            {
+                db->clearClimateData();
+
+                THEN("no samples are left")
+                {
+                    REQUIRE(db->getClimateData("interior").empty());
+                    REQUIRE(db->getClimateData("exterior").empty());
+                    REQUIRE(db->getClimateWatermarks({ "interior" }).empty());
+                }
+            }
+        }
+
+        WHEN("we add samples for a sensor ID that is not a valid file name")
+        {
+            db->addClimateData("../hive 1", 100, { 50.0, 20.0 });
+
+            THEN("they are stored within the DB directory")
+            {
+                REQUIRE(db->getClimateData("../hive 1").size() == 1);
+                REQUIRE(fs::exists(dir.path / "climate" / "%2E%2E%2Fhive%201"));
+            }
+        }
+
+        WHEN("we set the name")
+        {
+            db->setName("hive-1");
+
+            THEN("it persists across instances until cleared")
+            {
+                REQUIRE(db->getName() == "hive-1");
+
+                db.reset();
+                db = std::make_unique<EmbeddedDB>(dir.path.string(), 4);
+
+                REQUIRE(db->getName() == "hive-1");
+
+                db->clearAboutData();
+
+                REQUIRE(db->getName() == PROJECT_NAME);
+            }
+        }
+    }
+}
@@ -0,0 +1,188 @@
+//==============================================================================
+// Copyright (c) 2018 Eric Seguin, all rights reserved.
+//==============================================================================
+
+#include "util/gorilla.h"
+
+#include "catch.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <limits>
+
+/**
+ * How to write tests with Catch:
+ * https://github.com/catchorg/Catch2/blob/master/docs/tutorial.md#bdd-style
+ */
+
+using namespace beewatch;
+
+//==============================================================================
+/// Build a series resembling real samples: 5 min period with some jitter, slowly drifting values
+static ClimateSeries makeSeries(size_t numSamples)
+{
+    ClimateSeries series;
+    series.reserve(numSamples);
+
+    int64_t time = 1'500'000'000;
+
+    for (size_t i = 0; i < numSamples; ++i)
+    {
+        time += 300 + (i % 7 == 0 ? 1 : 0) - (i % 11 == 0 ? 2 : 0);
+
+        ClimateData<double> data;
+        data.temperature = std::round(200.0 + 50.0 * std::sin(i / 100.0)) / 10.0;
+        data.humidity = std::round(600.0 + 100.0 * std::cos(i / 150.0)) / 10.0;
+
+        series.push_back(time, data);
+    }
+
+    return series;
+}
+
+/// Check that two series hold bit-identical samples
+static bool isSameSeries(const ClimateSeries& lhs, const ClimateSeries& rhs)
+{
+    return lhs.size() == rhs.size() &&
+           lhs.timestamps == rhs.timestamps &&
+           std::memcmp(lhs.temperature.data(), rhs.temperature.data(), lhs.size() * sizeof(double)) == 0 &&
+           std::memcmp(lhs.humidity.data(), rhs.humidity.data(), lhs.size() * sizeof(double)) == 0;
+}
+
+//==============================================================================
+SCENARIO("Climate data series are compressed with the Gorilla encoding", "[gorilla][util][core]")
+{
+    GIVEN("an empty encoder")
+    {
+        GorillaEncoder encoder;
+
+        THEN("it produces a valid empty chunk")
+        {
+            GorillaDecoder decoder(encoder.bytes());
+
+            REQUIRE(decoder.size() == 0);
+            REQUIRE(decoder.begin() == decoder.end());
+        }
+    }
+
+    GIVEN("a realistic climate data series")
+    {
+        auto series = makeSeries(1000);
+
+        WHEN("the series is encoded")
+        {
+            auto chunk = GorillaEncoder::encode(series);
+
+            THEN("it is decoded losslessly")
+            {
+                REQUIRE(isSameSeries(GorillaDecoder::decode(chunk), series));
+            }
+
+            THEN("it takes a fraction of its raw size")
+            {
+                REQUIRE(chunk.size() < series.size() * 3 * sizeof(double) / 4);
+            }
+
+            THEN("samples can be streamed in order without decoding the whole chunk")
+            {
+                GorillaDecoder decoder(chunk);
+                size_t index = 0;
+
+                REQUIRE(decoder.size() == series.size());
+
+                for (auto it = decoder.begin(); it != decoder.end() && index < series.size(); ++it, ++index)
+                {
+                    REQUIRE(it->first == series.timestamps[index]);
+                    REQUIRE(it->second.temperature == series.temperature[index]);
+                    REQUIRE(it->second.humidity == series.humidity[index]);
+                }
+
+                REQUIRE(index == series.size());
+            }
+
+            THEN("decoding a truncated chunk fails")
+            {
+                chunk.resize(chunk.size() / 2);
+                REQUIRE_THROWS_AS(GorillaDecoder::decode(chunk), std::out_of_range);
+            }
+        }
+    }
+
+    GIVEN("samples with extreme timestamps and values")
+    {
+        ClimateSeries series;
+
+        series.push_back(std::numeric_limits<int64_t>::min(), { -0.0, std::numeric_limits<double>::max() });
+        series.push_back(-1, { std::numeric_limits<double>::infinity(), 1e-300 });
+        series.push_back(0, { 0.0, 0.0 });
+        series.push_back(1, { 0.0, 0.0 });
+        series.push_back(1'000'000, { 12.5, -40.0 });
+        series.push_back(std::numeric_limits<int64_t>::max(), { -1.0, 1.0 });
+
+        THEN("they survive a round trip")
+        {
+            REQUIRE(isSameSeries(GorillaDecoder::decode(GorillaEncoder::encode(series)), series));
+        }
+    }
+
+    GIVEN("an invalid chunk")
+    {
+        std::vector<uint8_t> chunk { 42, 0, 0, 0, 0 };
+
+        THEN("the decoder rejects it")
+        {
+            REQUIRE_THROWS_AS(GorillaDecoder(chunk), std::invalid_argument);
+            REQUIRE_THROWS_AS(GorillaDecoder(chunk.data(), 3), std::invalid_argument);
+        }
+    }
+}
+
+//==============================================================================
+SCENARIO("Benchmark Gorilla chunk size and decode throughput", "[gorilla][benchmark][!hide]")
+{
+    using namespace std::chrono;
+
+    static constexpr size_t c_numSamples = 100'000;
+
+    GIVEN("a series of " + std::to_string(c_numSamples) + " realistic climate samples")
+    {
+        auto series = makeSeries(c_numSamples);
+
+        WHEN("it is encoded and decoded")
+        {
+            auto startTime = steady_clock::now();
+            auto chunk = GorillaEncoder::encode(series);
+            double encodeMs = duration<double, std::milli>(steady_clock::now() - startTime).count();
+
+            startTime = steady_clock::now();
+
+            double checksum = 0.0;
+
+            for (const auto& sample : GorillaDecoder(chunk))
+                checksum += sample.second.temperature;
+
+            double decodeMs = duration<double, std::milli>(steady_clock::now() - startTime).count();
+
+            // Raw size: 8-byte timestamp and two 8-byte values per sample
+            size_t rawSize = c_numSamples * 3 * sizeof(double);
+
+            std::cout << "Gorilla chunk: " << chunk.size() << " bytes for " << c_numSamples << " samples ("
+                      << (double)chunk.size() / c_numSamples << " bytes/sample, "
+                      << (double)rawSize / chunk.size() << "x smaller than raw)" << std::endl;
+
+            std::cout << "Encode: " << encodeMs << " ms (" << (int)(c_numSamples / (encodeMs / 1e3))
+                      << " samples/s)" << std::endl;
+
+            std::cout << "Streaming decode: " << decodeMs << " ms (" << (int)(c_numSamples / (decodeMs / 1e3))
+                      << " samples/s)" << std::endl;
+
+            THEN("the series is recovered")
+            {
+                REQUIRE(checksum != 0.0);
+                REQUIRE(GorillaDecoder(chunk).size() == c_numSamples);
+            }
+        }
+    }
+}
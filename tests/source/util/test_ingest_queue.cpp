@@ -0,0 +1,256 @@
+//==============================================================================
+// Copyright (c) 2018 Eric Seguin, all rights reserved.
+//==============================================================================
+
+#include "util/ingest_queue.h"
+
+#include "global/logging.h"
+
+#include "catch.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * How to write tests with Catch:
+ * https://github.com/catchorg/Catch2/blob/master/docs/tutorial.md#bdd-style
+ */
+
+using namespace beewatch;
+using namespace std::chrono;
+
+//==============================================================================
+/// Records batches received from an IngestQueue
+struct FlushRecorder
+{
+    std::mutex mutex;
+    std::vector<std::vector<ClimateSample>> batches;
+
+    IngestQueue::FlushFunction function()
+    {
+        return [this](const std::vector<ClimateSample>& batch) {
+            std::lock_guard<std::mutex> lock(mutex);
+            batches.push_back(batch);
+
+            return true;
+        };
+    }
+
+    size_t numBatches()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return batches.size();
+    }
+
+    size_t numSamples()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        size_t count = 0;
+        for (const auto& batch : batches)
+            count += batch.size();
+
+        return count;
+    }
+};
+
+static ClimateSample makeSample(int64_t timestamp)
+{
+    return { "interior", timestamp, { 50.0, 20.0 } };
+}
+
+//==============================================================================
+SCENARIO("Climate samples are written in batches by the ingest queue", "[ingest][util][core]")
+{
+    // Disable logger
+    g_logger.setVerbosity(Logger::Level::Unattainable);
+
+    GIVEN("an ingest queue with a batch size of 4 and a long flush interval")
+    {
+        FlushRecorder recorder;
+        auto queue = std::make_unique<IngestQueue>(recorder.function(), 8, 4, hours(1));
+
+        WHEN("we push fewer samples than the batch size")
+        {
+            for (int64_t i = 0; i < 3; ++i)
+                REQUIRE(queue->push(makeSample(i)));
+
+            std::this_thread::sleep_for(milliseconds(50));
+
+            THEN("nothing is written yet")
+            {
+                REQUIRE(recorder.numBatches() == 0);
+                REQUIRE(queue->size() == 3);
+            }
+
+            AND_WHEN("we request a flush")
+            {
+                queue->flush();
+
+                THEN("all samples are written in a single batch")
+                {
+                    REQUIRE(recorder.numBatches() == 1);
+                    REQUIRE(recorder.batches[0].size() == 3);
+                    REQUIRE(queue->size() == 0);
+                }
+            }
+
+            AND_WHEN("the queue is destroyed")
+            {
+                queue.reset();
+
+                THEN("the remaining samples are written")
+                {
+                    REQUIRE(recorder.numSamples() == 3);
+                }
+            }
+
+            AND_WHEN("the queue is cleared")
+            {
+                queue->clear();
+                queue.reset();
+
+                THEN("the pending samples are discarded")
+                {
+                    REQUIRE(recorder.numSamples() == 0);
+                }
+            }
+        }
+
+        WHEN("we push as many samples as the batch size")
+        {
+            for (int64_t i = 0; i < 4; ++i)
+                queue->push(makeSample(i));
+
+            // Give writer thread some time to wake up
+            for (int i = 0; i < 100 && recorder.numBatches() == 0; ++i)
+                std::this_thread::sleep_for(milliseconds(10));
+
+            THEN("the batch is written in order without waiting for the flush interval")
+            {
+                REQUIRE(recorder.numSamples() == 4);
+
+                for (int64_t i = 0; i < 4; ++i)
+                    REQUIRE(recorder.batches[0][i].timestamp == i);
+            }
+        }
+    }
+
+    GIVEN("an ingest queue with a short flush interval")
+    {
+        FlushRecorder recorder;
+        IngestQueue queue(recorder.function(), 8, 4, milliseconds(20));
+
+        WHEN("we push a single sample and wait past the flush interval")
+        {
+            queue.push(makeSample(42));
+
+            for (int i = 0; i < 100 && recorder.numBatches() == 0; ++i)
+                std::this_thread::sleep_for(milliseconds(10));
+
+            THEN("the sample is written")
+            {
+                REQUIRE(recorder.numSamples() == 1);
+                REQUIRE(recorder.batches[0][0].timestamp == 42);
+            }
+        }
+    }
+
+    GIVEN("an ingest queue whose writer is blocked")
+    {
+        std::mutex blockMutex;
+
+        FlushRecorder recorder;
+        auto recordBatch = recorder.function();
+
+        IngestQueue queue([&](const std::vector<ClimateSample>& batch) {
+                std::lock_guard<std::mutex> lock(blockMutex);
+                return recordBatch(batch);
+            }, 4, 1, hours(1));
+
+        std::unique_lock<std::mutex> block(blockMutex);
+
+        // First sample is picked up by the writer, which then blocks
+        queue.push(makeSample(0));
+
+        for (int i = 0; i < 100 && queue.size() > 0; ++i)
+            std::this_thread::sleep_for(milliseconds(10));
+
+        WHEN("we push more samples than the queue's capacity")
+        {
+            bool allAccepted = true;
+
+            for (int64_t i = 1; i <= 6; ++i)
+                allAccepted &= queue.push(makeSample(i));
+
+            THEN("push() does not block and the oldest samples are dropped")
+            {
+                REQUIRE(!allAccepted);
+                REQUIRE(queue.size() == 4);
+
+                block.unlock();
+                queue.flush();
+
+                REQUIRE(recorder.numSamples() == 5);
+                REQUIRE(recorder.batches.back().back().timestamp == 6);
+                REQUIRE(recorder.batches.back().front().timestamp == 3);
+            }
+        }
+    }
+
+    GIVEN("an ingest queue whose writes fail until the DB comes back")
+    {
+        std::atomic<bool> isDBUp(false);
+        std::atomic<int> numAttempts(0);
+
+        FlushRecorder recorder;
+        auto recordBatch = recorder.function();
+
+        IngestQueue queue([&](const std::vector<ClimateSample>& batch) {
+                numAttempts++;
+                return isDBUp && recordBatch(batch);
+            }, 4, 2, hours(1), milliseconds(10));
+
+        WHEN("we push samples while writes fail")
+        {
+            queue.push(makeSample(0));
+            queue.push(makeSample(1));
+
+            for (int i = 0; i < 100 && numAttempts < 2; ++i)
+                std::this_thread::sleep_for(milliseconds(10));
+
+            THEN("the batch is kept queued and retried")
+            {
+                REQUIRE(!queue.flush());
+
+                REQUIRE(numAttempts >= 2);
+                REQUIRE(recorder.numSamples() == 0);
+                REQUIRE(queue.size() == 2);
+            }
+
+            AND_WHEN("more samples than the queue's capacity are pushed before the DB comes back")
+            {
+                for (int64_t i = 2; i < 6; ++i)
+                    queue.push(makeSample(i));
+
+                isDBUp = true;
+
+                THEN("the newest samples are written in order")
+                {
+                    // A write started before the DB came back may still fail
+                    bool isFlushed = queue.flush() || queue.flush();
+
+                    REQUIRE(isFlushed);
+
+                    REQUIRE(recorder.numSamples() == 4);
+                    REQUIRE(recorder.batches.front().front().timestamp == 2);
+                    REQUIRE(recorder.batches.back().back().timestamp == 5);
+                    REQUIRE(queue.size() == 0);
+                }
+            }
+        }
+    }
+}
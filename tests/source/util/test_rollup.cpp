@@ -0,0 +1,198 @@
+//==============================================================================
+// Copyright (c) 2018 Eric Seguin, all rights reserved.
+//==============================================================================
+
+#include "util/rollup.h"
+
+#include "catch.hpp"
+
+#include <iterator>
+#include <limits>
+
+/**
+ * How to write tests with Catch:
+ * https://github.com/catchorg/Catch2/blob/master/docs/tutorial.md#bdd-style
+ */
+
+using namespace beewatch;
+
+//==============================================================================
+SCENARIO("Climate samples are rolled up into hourly and daily aggregates", "[rollup][util][core]")
+{
+    GIVEN("an empty rollup with hourly and daily tiers")
+    {
+        ClimateRollup rollup;
+
+        THEN("the coarsest tier meeting a resolution is selected")
+        {
+            REQUIRE(rollup.selectPeriod(300) == 0);
+            REQUIRE(rollup.selectPeriod(ClimateRollup::HOUR) == ClimateRollup::HOUR);
+            REQUIRE(rollup.selectPeriod(6 * ClimateRollup::HOUR) == ClimateRollup::HOUR);
+            REQUIRE(rollup.selectPeriod(7 * ClimateRollup::DAY) == ClimateRollup::DAY);
+        }
+
+        THEN("it holds no aggregates")
+        {
+            REQUIRE(rollup.get("interior", ClimateRollup::HOUR).empty());
+            REQUIRE_THROWS_AS(rollup.get("interior", 300), std::invalid_argument);
+        }
+
+        WHEN("we add 5 minute samples over two days")
+        {
+            static constexpr int64_t c_start = 1'500'000'000 / ClimateRollup::DAY * ClimateRollup::DAY;
+
+            std::vector<ClimateSample> samples;
+
+            for (int64_t t = c_start; t < c_start + 2 * ClimateRollup::DAY; t += 300)
+            {
+                // Values ramp up within each hour: 0, 1, ..., 11
+                double step = double((t - c_start) % ClimateRollup::HOUR / 300);
+                samples.push_back({ "interior", t, { 40.0 + step, 20.0 + step } });
+            }
+
+            rollup.add(samples);
+
+            THEN("each hour holds the min, max and mean of its samples")
+            {
+                auto hours = rollup.get("interior", ClimateRollup::HOUR);
+
+                REQUIRE(hours.size() == 48);
+                REQUIRE(hours.begin()->first == c_start);
+
+                for (const auto& hour : hours)
+                {
+                    REQUIRE(hour.second.count == 12);
+                    REQUIRE(hour.second.min.temperature == Approx(20.0));
+                    REQUIRE(hour.second.max.temperature == Approx(31.0));
+                    REQUIRE(hour.second.mean.temperature == Approx(25.5));
+                    REQUIRE(hour.second.mean.humidity == Approx(45.5));
+                }
+            }
+
+            THEN("each day aggregates all of its samples")
+            {
+                auto days = rollup.get("interior", ClimateRollup::DAY);
+
+                REQUIRE(days.size() == 2);
+                REQUIRE(days.begin()->second.count == 288);
+                REQUIRE(days.rbegin()->first == c_start + ClimateRollup::DAY);
+            }
+
+            THEN("reading since a given time includes the bucket containing it")
+            {
+                auto hours = rollup.get("interior", ClimateRollup::HOUR, c_start + 90 * 60);
+
+                REQUIRE(hours.size() == 47);
+                REQUIRE(hours.begin()->first == c_start + ClimateRollup::HOUR);
+
+                REQUIRE(rollup.get("interior", ClimateRollup::DAY, c_start + ClimateRollup::DAY).size() == 1);
+            }
+
+            THEN("other sensors are unaffected")
+            {
+                REQUIRE(rollup.get("exterior", ClimateRollup::HOUR).empty());
+            }
+
+            AND_WHEN("a sample is added to an existing bucket")
+            {
+                rollup.add(ClimateSample { "interior", c_start + 1, { 100.0, -10.0 } });
+
+                THEN("its aggregates are updated incrementally")
+                {
+                    auto hour = rollup.get("interior", ClimateRollup::HOUR).begin()->second;
+
+                    REQUIRE(hour.count == 13);
+                    REQUIRE(hour.min.temperature == Approx(-10.0));
+                    REQUIRE(hour.max.humidity == Approx(100.0));
+                }
+            }
+
+            AND_WHEN("the rollup is cleared")
+            {
+                rollup.clear();
+
+                THEN("no aggregates are left")
+                {
+                    REQUIRE(rollup.get("interior", ClimateRollup::DAY).empty());
+                }
+            }
+        }
+    }
+
+    GIVEN("a rollup whose closed buckets are persisted")
+    {
+        static constexpr int64_t c_start = 1'500'000'000 / ClimateRollup::DAY * ClimateRollup::DAY;
+
+        ClimateRollup rollup;
+
+        // Three samples per hour over the first three hours of a day
+        for (int64_t t = c_start; t < c_start + 3 * ClimateRollup::HOUR; t += 1200)
+            rollup.add(ClimateSample { "interior", t, { 50.0, 20.0 } });
+
+        WHEN("we get the buckets which haven't been persisted yet")
+        {
+            auto unpersisted = rollup.getUnpersisted();
+
+            THEN("only closed buckets are returned")
+            {
+                REQUIRE(unpersisted.size() == 1);
+                REQUIRE(unpersisted[0].sensorID == "interior");
+                REQUIRE(unpersisted[0].period == ClimateRollup::HOUR);
+                REQUIRE(unpersisted[0].buckets.size() == 2);
+                REQUIRE(unpersisted[0].buckets.begin()->first == c_start);
+                REQUIRE(unpersisted[0].buckets.begin()->second.count == 3);
+            }
+
+            AND_WHEN("they are marked as persisted")
+            {
+                rollup.setPersisted("interior", ClimateRollup::HOUR, c_start + 2 * ClimateRollup::HOUR);
+
+                THEN("they aren't returned again and late samples no longer change them")
+                {
+                    REQUIRE(rollup.getUnpersisted().empty());
+
+                    rollup.add(ClimateSample { "interior", c_start + 1, { 0.0, 0.0 } });
+
+                    REQUIRE(rollup.get("interior", ClimateRollup::HOUR).begin()->second.count == 3);
+                    REQUIRE(rollup.get("interior", ClimateRollup::DAY).begin()->second.count == 10);
+                }
+            }
+        }
+
+        WHEN("the persisted buckets are restored into a new rollup")
+        {
+            ClimateRollup restored;
+
+            auto hours = rollup.get("interior", ClimateRollup::HOUR);
+            hours.erase(std::prev(hours.end()));
+
+            auto replaySince = restored.restore("interior", ClimateRollup::HOUR, hours);
+
+            THEN("samples are only replayed into the buckets following them")
+            {
+                REQUIRE(replaySince == c_start + 2 * ClimateRollup::HOUR);
+                REQUIRE(restored.restore("interior", ClimateRollup::DAY, {}) == std::numeric_limits<int64_t>::min());
+
+                for (int64_t t = c_start; t < c_start + 3 * ClimateRollup::HOUR; t += 1200)
+                    restored.add(ClimateSample { "interior", t, { 50.0, 20.0 } });
+
+                REQUIRE(restored.get("interior", ClimateRollup::HOUR).size() == 3);
+
+                for (const auto& hour : restored.get("interior", ClimateRollup::HOUR))
+                    REQUIRE(hour.second.count == 3);
+
+                REQUIRE(restored.get("interior", ClimateRollup::DAY).begin()->second.count == 9);
+                REQUIRE(restored.getUnpersisted().empty());
+            }
+        }
+    }
+
+    GIVEN("invalid tier periods")
+    {
+        THEN("the rollup cannot be constructed")
+        {
+            REQUIRE_THROWS_AS(ClimateRollup({ 0 }), std::invalid_argument);
+            REQUIRE_THROWS_AS(ClimateRollup({ 3600, -60 }), std::invalid_argument);
+        }
+    }
+}
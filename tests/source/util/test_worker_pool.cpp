@@ -0,0 +1,117 @@
+//==============================================================================
+// Copyright (c) 2018 Eric Seguin, all rights reserved.
+//==============================================================================
+
+#include "util/worker_pool.h"
+
+#include "catch.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+
+/**
+ * How to write tests with Catch:
+ * https://github.com/catchorg/Catch2/blob/master/docs/tutorial.md#bdd-style
+ */
+
+using namespace beewatch;
+using namespace std::chrono;
+
+//==============================================================================
+SCENARIO("Tasks are run by a bounded pool of workers", "[workers][util][core]")
+{
+    THEN("a pool without workers or queue is refused")
+    {
+        REQUIRE_THROWS_AS(WorkerPool(0, 1), std::invalid_argument);
+        REQUIRE_THROWS_AS(WorkerPool(1, 0), std::invalid_argument);
+    }
+
+    GIVEN("a pool of 2 workers with room for 2 queued tasks")
+    {
+        WorkerPool pool(2, 2);
+
+        WHEN("we submit tasks")
+        {
+            std::atomic<int> numRun(0);
+
+            for (int i = 0; i < 2; ++i)
+                REQUIRE(pool.submit([&]() { numRun++; }));
+
+            while (pool.getStats().completed < 2)
+                std::this_thread::sleep_for(milliseconds(1));
+
+            THEN("they are all run")
+            {
+                REQUIRE(numRun == 2);
+                REQUIRE(pool.getStats().queued == 0);
+                REQUIRE(pool.getStats().running == 0);
+            }
+        }
+
+        WHEN("all workers are busy and the queue is full")
+        {
+            std::promise<void> release;
+            auto released = release.get_future().share();
+
+            std::atomic<int> numStarted(0);
+
+            for (int i = 0; i < 2; ++i)
+                pool.submit([&, released]() { numStarted++; released.wait(); });
+
+            while (numStarted < 2)
+                std::this_thread::sleep_for(milliseconds(1));
+
+            std::atomic<int> numExpired(0);
+            std::atomic<int> numRun(0);
+
+            REQUIRE(pool.submit([&]() { numRun++; }));
+            REQUIRE(pool.submit([&]() { numRun++; }, milliseconds(10), [&]() { numExpired++; }));
+
+            bool isAccepted = pool.submit([&]() { numRun++; });
+
+            auto stats = pool.getStats();
+
+            std::this_thread::sleep_for(milliseconds(50));
+            release.set_value();
+
+            while (pool.getStats().completed + pool.getStats().expired < 4)
+                std::this_thread::sleep_for(milliseconds(1));
+
+            THEN("further tasks are refused")
+            {
+                REQUIRE_FALSE(isAccepted);
+
+                REQUIRE(stats.running == 2);
+                REQUIRE(stats.queued == 2);
+                REQUIRE(pool.getStats().rejected == 1);
+            }
+
+            THEN("tasks which waited too long are expired instead of being run")
+            {
+                REQUIRE(numRun == 1);
+                REQUIRE(numExpired == 1);
+                REQUIRE(pool.getStats().expired == 1);
+                REQUIRE(pool.getStats().maxWaitMs >= 50.0);
+            }
+        }
+    }
+
+    GIVEN("a pool destroyed with tasks still queued")
+    {
+        std::atomic<int> numRun(0);
+
+        {
+            WorkerPool pool(1, 8);
+
+            for (int i = 0; i < 8; ++i)
+                pool.submit([&]() { std::this_thread::sleep_for(milliseconds(1)); numRun++; });
+        }
+
+        THEN("all of them are run first")
+        {
+            REQUIRE(numRun == 8);
+        }
+    }
+}
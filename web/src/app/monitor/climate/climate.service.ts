@@ -12,8 +12,12 @@ import { HttpParams } from '@angular/common/http';
 export class ClimateService {
   constructor(private rest: RestService) { }
 
-  getData(since: number): Observable<ClimateData> {
-    const requestParams = new HttpParams().set('since', (since + 1).toString());
+  getData(since: number, points?: number): Observable<ClimateData> {
+    let requestParams = new HttpParams().set('since', (since + 1).toString());
+
+    if (points) {
+      requestParams = requestParams.set('points', points.toString());
+    }
 
     return this.rest.get<ClimateData>('data/climate', requestParams)
                     .pipe( retry(3), catchError(this.rest.handleError<ClimateData>('ClimateService.getData')) );
@@ -13,6 +13,9 @@ import { MatDialogRef, MatDialog } from '@angular/material';
   styleUrls: ['./monitor.component.css']
 })
 export class MonitorComponent implements OnInit {
+  // Initial history is decimated server-side to roughly one sample per pixel
+  private static readonly HISTORY_POINTS = 1000;
+
   private lastUpdate = 0;
 
   public monitors: Monitor[] = [
@@ -26,7 +29,8 @@ export class MonitorComponent implements OnInit {
     this.initCharts().then(() =>
       interval(30000).pipe(
         startWith(0),
-        switchMap(() => this.climateService.getData(this.lastUpdate))
+        switchMap(() => this.climateService.getData(this.lastUpdate,
+                                                    this.lastUpdate === 0 ? MonitorComponent.HISTORY_POINTS : undefined))
       )
       .subscribe(data => this.updateClimate(data))
     );